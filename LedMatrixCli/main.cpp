@@ -0,0 +1,417 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "canvas.h"
+#include "effect_manager.h"
+#include "equalizer.h"
+#include "frame_pacer.h"
+#include "spectrum_analyzer.h"
+#include "tile_layout.h"
+#include "tiled_output.h"
+#include "uart.h"
+#include "wav_file.h"
+
+namespace
+{
+///Target FPS used in benchmark mode (frames are not paced)
+const uint32_t bench_target_fps = 1000000;
+
+std::atomic<bool> interrupted(false);
+
+void on_signal(int)
+{
+	interrupted = true;
+}
+
+struct output_path
+{
+	std::string path;
+	uart::open_mode mode;
+};
+
+struct options
+{
+	options()
+		: columns(1)
+		, rows(1)
+		, baud_rate(115200)
+		, fps(frame_pacer::default_target_fps)
+		, effect(effect_manager::effect_processor::spectrum_analyzer)
+		, bench(false)
+	{
+	}
+
+	std::string wav_path;
+	std::string sa_dump_path;
+	std::string frames_path;
+	std::vector<output_path> devices;
+	uint32_t columns;
+	uint32_t rows;
+	uint32_t baud_rate;
+	uint32_t fps;
+	effect_manager::effect_processor effect;
+	bool bench;
+};
+
+void print_usage()
+{
+	std::cout << "Usage: led_matrix_cli INPUT [OUTPUT] [OPTIONS]\n"
+		"Input (one of):\n"
+		"  --wav FILE          Analyze PCM WAV file and render effect\n"
+		"  --sa-dump FILE      Render effect from recorded equalizer data\n"
+		"                      (" << std::tuple_size<equalizer::sadata>::value << " bytes per frame)\n"
+		"  --frames FILE       Stream raw frames (canvas width * height RGB\n"
+		"                      pixels, rows top to bottom)\n"
+		"Output:\n"
+		"  --device PATH       Serial port, pty or existing file. Repeat for\n"
+		"                      several devices (left to right, top to bottom)\n"
+		"  --output FILE       Write frames to file, which is created if needed.\n"
+		"                      Can be repeated and mixed with --device\n"
+		"  --grid COLSxROWS    Devices grid (default 1x1)\n"
+		"  --baud RATE         Serial port baud rate (default 115200)\n"
+		"Options:\n"
+		"  --effect NAME       spectrum, waves or dots (default spectrum)\n"
+		"  --fps FPS           Target FPS (default " << frame_pacer::default_target_fps << ")\n"
+		"  --bench             Render as fast as possible and print timings\n"
+		"                      (output defaults to /dev/null)\n";
+}
+
+uint32_t parse_number(const std::string& value)
+{
+	size_t end = 0;
+	const unsigned long result = std::stoul(value, &end);
+	if(end != value.size() || !result)
+		throw std::invalid_argument("Invalid number: " + value);
+
+	return static_cast<uint32_t>(result);
+}
+
+options parse_options(int argc, char** argv)
+{
+	options result;
+	for(int i = 1; i < argc; ++i)
+	{
+		const std::string name = argv[i];
+		if(name == "--bench")
+		{
+			result.bench = true;
+			continue;
+		}
+
+		if(i + 1 == argc)
+			throw std::invalid_argument("Missing value of " + name);
+
+		const std::string value = argv[++i];
+		if(name == "--wav")
+		{
+			result.wav_path = value;
+		}
+		else if(name == "--sa-dump")
+		{
+			result.sa_dump_path = value;
+		}
+		else if(name == "--frames")
+		{
+			result.frames_path = value;
+		}
+		else if(name == "--device")
+		{
+			result.devices.push_back({ value, uart::open_mode::device });
+		}
+		else if(name == "--output")
+		{
+			result.devices.push_back({ value, uart::open_mode::output_file });
+		}
+		else if(name == "--grid")
+		{
+			const size_t separator = value.find('x');
+			if(separator == std::string::npos)
+				throw std::invalid_argument("Invalid grid: " + value);
+
+			result.columns = parse_number(value.substr(0, separator));
+			result.rows = parse_number(value.substr(separator + 1));
+		}
+		else if(name == "--baud")
+		{
+			result.baud_rate = parse_number(value);
+		}
+		else if(name == "--fps")
+		{
+			result.fps = parse_number(value);
+		}
+		else if(name == "--effect")
+		{
+			if(value == "spectrum")
+				result.effect = effect_manager::effect_processor::spectrum_analyzer;
+			else if(value == "waves")
+				result.effect = effect_manager::effect_processor::color_waves;
+			else if(value == "dots")
+				result.effect = effect_manager::effect_processor::glowing_dots;
+			else
+				throw std::invalid_argument("Unknown effect: " + value);
+		}
+		else
+		{
+			throw std::invalid_argument("Unknown option: " + name);
+		}
+	}
+
+	if(result.wav_path.empty() + result.sa_dump_path.empty() + result.frames_path.empty() != 2)
+		throw std::invalid_argument("Exactly one input must be specified");
+
+	if(result.devices.empty() && result.bench)
+		result.devices.assign(result.columns * result.rows, { "/dev/null", uart::open_mode::device });
+
+	if(result.devices.size() != result.columns * result.rows)
+		throw std::invalid_argument("Number of devices must be equal to number of grid tiles");
+
+	return result;
+}
+
+///Returns audio position of each rendered frame. In benchmark mode each frame
+///advances position by one frame interval, otherwise position is time since start.
+class frame_clock
+{
+public:
+	frame_clock(bool fixed_step, uint32_t fps)
+		: fixed_step_(fixed_step)
+		, step_(1.0 / fps)
+		, frame_index_(0)
+	{
+	}
+
+	double next_position()
+	{
+		if(fixed_step_)
+			return step_ * frame_index_++;
+
+		if(!frame_index_++)
+			start_ = std::chrono::steady_clock::now();
+
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+	}
+
+private:
+	bool fixed_step_;
+	double step_;
+	uint64_t frame_index_;
+	std::chrono::steady_clock::time_point start_;
+};
+
+///Input end notification. Data source waits at the end of input until effect
+///manager is stopped, so no silent frames are rendered after the last one.
+class input_state
+{
+public:
+	input_state()
+		: finished_(false)
+		, released_(false)
+	{
+	}
+
+	///Called by data source when input is over
+	void finish()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		finished_ = true;
+		finished_changed_.notify_all();
+		finished_changed_.wait(lock, [this]() { return released_; });
+	}
+
+	///Waits for the end of input or timeout
+	bool wait_for_finish(std::chrono::milliseconds timeout)
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		return finished_changed_.wait_for(lock, timeout, [this]() { return finished_; });
+	}
+
+	///Lets data source return, must be called before stopping effect manager
+	void release()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		released_ = true;
+		finished_changed_.notify_all();
+	}
+
+private:
+	std::mutex mutex_;
+	std::condition_variable finished_changed_;
+	bool finished_;
+	bool released_;
+};
+
+equalizer::data_source make_wav_source(const std::string& path, frame_clock& clock,
+	input_state& state)
+{
+	std::shared_ptr<wav_file> wav(new wav_file(path));
+	std::shared_ptr<spectrum_analyzer> analyzer(new spectrum_analyzer(wav->get_sample_rate()));
+	return [wav, analyzer, &clock, &state]()
+	{
+		const auto& samples = wav->get_samples();
+		const size_t position = static_cast<size_t>(clock.next_position() * wav->get_sample_rate());
+		if(position >= samples.size())
+		{
+			state.finish();
+			return equalizer::sadata {};
+		}
+
+		return analyzer->analyze(samples.data() + position, samples.size() - position);
+	};
+}
+
+equalizer::data_source make_sa_dump_source(const std::string& path, input_state& state)
+{
+	std::shared_ptr<std::ifstream> file(new std::ifstream(path, std::ios::binary));
+	if(!*file)
+		throw std::runtime_error("Unable to open " + path);
+
+	//Each frame takes one record
+	return [file, &state]()
+	{
+		equalizer::sadata data {};
+		if(!file->read(data.data(), data.size()))
+		{
+			state.finish();
+			return equalizer::sadata {};
+		}
+
+		return data;
+	};
+}
+
+void print_statistics(const frame_pacer::statistics& stats, double seconds)
+{
+	printf("Frames:            %llu\n", static_cast<unsigned long long>(stats.frame_count));
+	printf("Achieved FPS:      %.1f\n", seconds > 0 ? stats.frame_count / seconds : 0.0);
+	printf("Paced FPS:         %.1f (target %.0f, %llu frames degraded)\n", stats.paced_fps,
+		stats.target_fps, static_cast<unsigned long long>(stats.degraded_frame_count));
+	printf("Render time:       %.4f ms/frame\n", stats.render_time);
+	printf("Encode time:       %.4f ms/frame\n", stats.encode_time);
+	printf("Bytes per frame:   %.1f\n", stats.frame_size);
+	printf("Round trip time:   p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+		stats.rtt_p50, stats.rtt_p95, stats.rtt_p99, stats.rtt_max);
+	printf("Throughput:        %.0f bytes/s\n", stats.throughput);
+}
+
+///Renders effect from equalizer data
+frame_pacer::statistics run_effect(const options& opts, const std::vector<uart*>& ports,
+	const tile_layout& layout)
+{
+	std::atomic<bool> failed(false);
+	input_state state;
+	frame_clock clock(opts.bench, opts.fps);
+	if(!opts.wav_path.empty())
+		equalizer::set_data_source(make_wav_source(opts.wav_path, clock, state));
+	else
+		equalizer::set_data_source(make_sa_dump_source(opts.sa_dump_path, state));
+
+	effect_manager manager;
+	manager.on_error([&failed]() { failed = true; });
+	manager.set_effect_processor(opts.effect);
+	manager.set_target_fps(opts.bench ? bench_target_fps : opts.fps);
+	manager.start(ports, layout);
+
+	while(!failed && !interrupted && !state.wait_for_finish(std::chrono::milliseconds(10)))
+	{
+	}
+
+	state.release();
+	manager.stop();
+	if(failed)
+		throw std::runtime_error("Device is offline");
+
+	return manager.get_statistics();
+}
+
+///Streams raw frames
+frame_pacer::statistics run_frames(const options& opts, const std::vector<uart*>& ports,
+	const tile_layout& layout)
+{
+	std::ifstream file(opts.frames_path, std::ios::binary);
+	if(!file)
+		throw std::runtime_error("Unable to open " + opts.frames_path);
+
+	tiled_output output(layout, ports);
+	frame_pacer pacer(opts.bench ? bench_target_fps : opts.fps);
+	canvas frame(layout.get_canvas_width(), layout.get_canvas_height());
+	std::vector<char> pixels(frame.get_width() * frame.get_height() * 3);
+	while(!interrupted && file.read(pixels.data(), pixels.size()))
+	{
+		const char* pixel = pixels.data();
+		for(uint32_t y = 0; y != frame.get_height(); ++y)
+		{
+			for(uint32_t x = 0; x != frame.get_width(); ++x, pixel += 3)
+			{
+				frame.set_pixel(x, y, color::rgb(static_cast<uint8_t>(pixel[0]),
+					static_cast<uint8_t>(pixel[1]), static_cast<uint8_t>(pixel[2])));
+			}
+		}
+
+		const auto send_start = frame_pacer::clock::now();
+		const uint32_t byte_count = output.send_frame(frame);
+		pacer.on_frame_sent(byte_count, send_start, frame_pacer::clock::now(), output.get_last_encode_time());
+		pacer.wait_for_next_frame();
+	}
+
+	return pacer.get_statistics();
+}
+} //namespace
+
+int main(int argc, char** argv)
+{
+	options opts;
+	try
+	{
+		opts = parse_options(argc, argv);
+	}
+	catch(const std::exception& e)
+	{
+		std::cerr << e.what() << "\n\n";
+		print_usage();
+		return 2;
+	}
+
+	std::signal(SIGINT, on_signal);
+	std::signal(SIGTERM, on_signal);
+
+	try
+	{
+		std::vector<std::unique_ptr<uart>> devices;
+		std::vector<uart*> ports;
+		for(const auto& device : opts.devices)
+		{
+			devices.emplace_back(new uart(std::wstring(device.path.begin(), device.path.end()),
+				opts.baud_rate, device.mode));
+			ports.push_back(devices.back().get());
+		}
+
+		const tile_layout layout = tile_layout::make_grid(opts.columns, opts.rows);
+		const auto start = std::chrono::steady_clock::now();
+		const frame_pacer::statistics stats = opts.frames_path.empty()
+			? run_effect(opts, ports, layout) : run_frames(opts, ports, layout);
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		print_statistics(stats, seconds);
+	}
+	catch(const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
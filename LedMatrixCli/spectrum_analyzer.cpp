@@ -0,0 +1,109 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#include "spectrum_analyzer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+const float pi = 3.14159265358979f;
+
+///Frequency range shown by bands
+const float min_frequency = 50.f;
+const float max_frequency = 16000.f;
+
+///Band level range (dB relative to full scale sine amplitude),
+///levels below min_level are zero, levels above max_level are max_band_value
+const float min_level = -72.f;
+const float max_level = -12.f;
+const float max_band_value = 16.f;
+} //namespace
+
+spectrum_analyzer::spectrum_analyzer(uint32_t sample_rate)
+	: window_(fft_size)
+	, window_gain_(0)
+	, buffer_(fft_size)
+{
+	//Hann window
+	for(uint32_t i = 0; i != fft_size; ++i)
+	{
+		window_[i] = 0.5f - 0.5f * std::cos(2 * pi * i / (fft_size - 1));
+		window_gain_ += window_[i];
+	}
+
+	const float nyquist = sample_rate / 2.f;
+	const float top_frequency = std::min(max_frequency, nyquist);
+	const float bin_width = static_cast<float>(sample_rate) / fft_size;
+	for(uint32_t band = 0; band != equalizer::band_count; ++band)
+	{
+		const float from = min_frequency * std::pow(top_frequency / min_frequency,
+			static_cast<float>(band) / equalizer::band_count);
+		const float to = min_frequency * std::pow(top_frequency / min_frequency,
+			static_cast<float>(band + 1) / equalizer::band_count);
+
+		//Low bands are narrower than FFT bin, each band uses at least one bin
+		uint32_t first_bin = static_cast<uint32_t>(from / bin_width + 0.5f);
+		uint32_t last_bin = static_cast<uint32_t>(to / bin_width + 0.5f);
+		first_bin = std::min(std::max(first_bin, 1u), fft_size / 2 - 1);
+		last_bin = std::min(std::max(last_bin, first_bin + 1), fft_size / 2);
+		band_bins_.push_back({ first_bin, last_bin });
+	}
+}
+
+equalizer::sadata spectrum_analyzer::analyze(const float* samples, size_t count)
+{
+	for(uint32_t i = 0; i != fft_size; ++i)
+		buffer_[i] = i < count ? samples[i] * window_[i] : 0.f;
+
+	transform();
+
+	equalizer::sadata result {};
+	for(uint32_t band = 0; band != equalizer::band_count; ++band)
+	{
+		float magnitude = 0;
+		for(uint32_t bin = band_bins_[band].first; bin != band_bins_[band].second; ++bin)
+			magnitude = std::max(magnitude, std::abs(buffer_[bin]));
+
+		//Full scale sine has amplitude of 1
+		const float amplitude = 2 * magnitude / window_gain_;
+		const float level = 20 * std::log10(amplitude + 1e-9f);
+		const float value = (level - min_level) / (max_level - min_level) * max_band_value;
+		result[band] = static_cast<char>(std::min(std::max(value, 0.f), max_band_value));
+	}
+
+	return result;
+}
+
+void spectrum_analyzer::transform()
+{
+	//Iterative radix-2 FFT, bit reversal permutation first
+	for(uint32_t i = 1, j = 0; i != fft_size; ++i)
+	{
+		uint32_t bit = fft_size >> 1;
+		for(; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+
+		if(i < j)
+			std::swap(buffer_[i], buffer_[j]);
+	}
+
+	for(uint32_t length = 2; length <= fft_size; length <<= 1)
+	{
+		const std::complex<float> step = std::polar(1.f, -2 * pi / length);
+		for(uint32_t start = 0; start != fft_size; start += length)
+		{
+			std::complex<float> twiddle(1.f, 0.f);
+			for(uint32_t i = 0; i != length / 2; ++i)
+			{
+				const std::complex<float> even = buffer_[start + i];
+				const std::complex<float> odd = buffer_[start + i + length / 2] * twiddle;
+				buffer_[start + i] = even + odd;
+				buffer_[start + i + length / 2] = even - odd;
+				twiddle *= step;
+			}
+		}
+	}
+}
@@ -0,0 +1,40 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#pragma once
+
+#include <complex>
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+#include "equalizer.h"
+
+///Converts audio samples to equalizer data (like Winamp spectrum analyzer data):
+///logarithmically spaced bands with values from 0 to about 16.
+class spectrum_analyzer
+{
+public:
+	///Number of samples analyzed at once (must be power of 2)
+	static const uint32_t fft_size = 1024;
+
+public:
+	explicit spectrum_analyzer(uint32_t sample_rate);
+
+	/** Analyzes fft_size samples
+	*   @param samples Samples (-1.0 to 1.0)
+	*   @param count Number of samples available. If less than fft_size,
+	*   the rest is treated as silence.
+	*   @returns Equalizer data */
+	equalizer::sadata analyze(const float* samples, size_t count);
+
+private:
+	std::vector<float> window_;
+	float window_gain_;
+	//First and last + 1 FFT bin of each band
+	std::vector<std::pair<uint32_t, uint32_t>> band_bins_;
+	std::vector<std::complex<float>> buffer_;
+
+	void transform();
+};
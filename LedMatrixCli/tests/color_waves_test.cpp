@@ -0,0 +1,171 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+//Renders color waves effect from pseudo-random equalizer data and compares
+//device output with frames recorded from the original per-point display
+//implementation (color_waves_frames.raw, raw RGB frames of one device).
+
+#include <algorithm>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "display.h"
+#include "display_protocol.h"
+#include "effect_manager.h"
+#include "equalizer.h"
+#include "tile_layout.h"
+#include "uart.h"
+
+namespace
+{
+const uint32_t frame_count = 200;
+const uint32_t frame_size = display::display_width * display::display_height * display::bytes_per_led;
+
+std::vector<uint8_t> read_file(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if(!file)
+		throw std::runtime_error("Unable to open " + path);
+
+	return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+///Device bytes of recorded frames
+std::vector<uint8_t> encode_frames(const std::vector<uint8_t>& frames)
+{
+	std::vector<uint8_t> ret;
+	for(uint32_t frame = 0; frame != frame_count; ++frame)
+	{
+		display data;
+		const uint8_t* pixel = frames.data() + frame * frame_size;
+		for(uint8_t y = 0; y != display::display_height; ++y)
+		{
+			for(uint8_t x = 0; x != display::display_width; ++x, pixel += display::bytes_per_led)
+				data.set_pixel(x, y, { pixel[0], pixel[1], pixel[2] });
+		}
+
+		const std::vector<uint8_t> bytes = display_protocol::encode(data);
+		ret.insert(ret.end(), bytes.begin(), bytes.end());
+	}
+
+	return ret;
+}
+
+///Returns frame_count records of pseudo-random band values (0-20, values
+///above effect_manager::max_eq_value are cut), then blocks until released,
+///so the effect renders exactly frame_count frames from the test data.
+class test_data_source
+{
+public:
+	test_data_source()
+		: random_gen_(2016)
+		, index_(0)
+		, finished_(false)
+		, released_(false)
+	{
+	}
+
+	equalizer::sadata next()
+	{
+		equalizer::sadata data {};
+		std::unique_lock<std::mutex> lock(mutex_);
+		if(index_ == frame_count)
+		{
+			//All test frames are sent when the next one is requested
+			finished_ = true;
+			finished_changed_.notify_all();
+			finished_changed_.wait(lock, [this]() { return released_; });
+			return data;
+		}
+
+		++index_;
+		for(uint32_t i = 0; i != equalizer::band_count; ++i)
+			data[i] = static_cast<char>(random_gen_() % 21);
+
+		return data;
+	}
+
+	void wait_for_finish()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		finished_changed_.wait(lock, [this]() { return finished_; });
+	}
+
+	void release()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		released_ = true;
+		finished_changed_.notify_all();
+	}
+
+private:
+	std::mt19937 random_gen_;
+	std::mutex mutex_;
+	std::condition_variable finished_changed_;
+	uint32_t index_;
+	bool finished_;
+	bool released_;
+};
+} //namespace
+
+int main(int argc, char** argv)
+{
+	if(argc != 3)
+	{
+		std::cerr << "Usage: color_waves_test RECORDED_FRAMES OUTPUT_FILE" << std::endl;
+		return 2;
+	}
+
+	try
+	{
+		const std::vector<uint8_t> recorded = read_file(argv[1]);
+		if(recorded.size() != frame_count * frame_size)
+			throw std::runtime_error("Unexpected recorded frames size");
+
+		const std::string output_path = argv[2];
+		test_data_source source;
+		equalizer::set_data_source([&source]() { return source.next(); });
+
+		{
+			uart output(std::wstring(output_path.begin(), output_path.end()), 115200,
+				uart::open_mode::output_file);
+
+			effect_manager manager;
+			manager.set_effect_processor(effect_manager::effect_processor::color_waves);
+			manager.set_target_fps(1000);
+			manager.start({ &output }, tile_layout::make_grid(1, 1));
+			source.wait_for_finish();
+			source.release();
+			manager.stop();
+		}
+
+		//Frames rendered after the data source was released are not compared
+		const std::vector<uint8_t> expected = encode_frames(recorded);
+		const std::vector<uint8_t> actual = read_file(output_path);
+		if(actual.size() < expected.size()
+			|| !std::equal(expected.begin(), expected.end(), actual.begin()))
+		{
+			const auto mismatch = std::mismatch(expected.begin(), expected.end(), actual.begin(),
+				actual.end());
+			std::cerr << "Color waves output differs from recorded frames at byte "
+				<< (mismatch.first - expected.begin()) << std::endl;
+			return 1;
+		}
+	}
+	catch(const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	std::cout << "Color waves: " << frame_count << " frames match" << std::endl;
+	return 0;
+}
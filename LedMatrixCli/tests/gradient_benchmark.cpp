@@ -0,0 +1,297 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+//Benchmark of gradient tables against per-pixel color::gradient() calls.
+//Spectrum analyzer bars and glowing dots band colors are calculated for each
+//frame both ways (like effect_manager does now and did before the tables).
+//Reports time per frame and the biggest difference of color components
+//over all frames.
+
+#include <algorithm>
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+#include "colors.h"
+#include "equalizer.h"
+#include "gradient.h"
+
+namespace
+{
+const uint32_t frame_count = 20000;
+
+struct sa_gradient
+{
+	color::rgb from_low;
+	color::rgb from_high;
+	color::rgb peak;
+};
+
+const std::vector<sa_gradient> sa_gradients
+{
+	{ { 0, 0, 0xff }, { 0xff, 0xff, 0 }, { 0, 0xff, 0 } },
+	{ { 0, 0xff, 0 }, { 0xff, 0, 0 }, { 0, 0, 0xff } },
+	{ { 0xff, 0xff, 0xff }, { 0, 0, 0xff }, { 0xff, 0, 0 } },
+	{ { 0xff, 0, 0 }, { 0x30, 0, 0xa0 }, { 0xff, 0xff, 0 } },
+	{ { 0xff, 0x80, 0 }, { 0, 0xff, 0x50 }, { 0x70, 0x70, 0xff } },
+	{ { 0x50, 0x50, 0 }, { 0xff, 0xff, 0 }, { 0, 0x90, 0x20 } }
+};
+
+const std::vector<std::pair<color::rgb, color::rgb>> dots_gradients
+{
+	{ { 0, 0, 0xff }, { 0xff, 0xff, 0 } },
+	{ { 0, 0xff, 0 }, { 0xff, 0x10, 0x10 } },
+	{ { 0xff, 0xff, 0xff }, { 0, 0xff, 0xff } },
+	{ { 0xff, 0, 0x70 }, { 0xff, 0, 0 } },
+	{ color::blueviolet, color::gold },
+	{ color::greenyellow, color::firebrick },
+	{ color::lightskyblue, color::magenta }
+};
+
+///Keeps results alive, so calculations are not optimized out
+uint32_t checksum = 0;
+
+void add_to_checksum(const std::vector<color::rgb>& pixels)
+{
+	for(const auto& pixel : pixels)
+		checksum += pixel.r + pixel.g + pixel.b;
+}
+
+uint8_t get_difference(uint8_t a, uint8_t b)
+{
+	return static_cast<uint8_t>(a > b ? a - b : b - a);
+}
+
+uint8_t get_max_difference(const std::vector<color::rgb>& a, const std::vector<color::rgb>& b)
+{
+	uint8_t ret = 0;
+	for(size_t i = 0; i != a.size(); ++i)
+	{
+		const uint8_t difference[] = { get_difference(a[i].r, b[i].r),
+			get_difference(a[i].g, b[i].g), get_difference(a[i].b, b[i].b) };
+		for(uint8_t value : difference)
+		{
+			if(value > ret)
+				ret = value;
+		}
+	}
+
+	return ret;
+}
+
+///Calculates bar colors of all rows of width x height canvas (full width bars)
+///like the spectrum analyzer effect did before gradient tables
+class sa_per_pixel
+{
+public:
+	static const uint32_t max_gradient_step = 2000;
+
+	sa_per_pixel(uint32_t width, uint32_t height)
+		: width_(width)
+		, height_(height)
+		, pixels_(width * height)
+	{
+	}
+
+	const std::vector<color::rgb>& render(uint32_t frame)
+	{
+		for(uint32_t y = 0; y != height_; ++y)
+		{
+			const uint32_t row_index = frame * height_ + y;
+			const uint32_t step = row_index % (2 * max_gradient_step);
+			const size_t current_gradient = row_index / (2 * max_gradient_step) % sa_gradients.size();
+			const auto& grad = sa_gradients[current_gradient];
+			const auto& next_grad = sa_gradients[(current_gradient + 1) % sa_gradients.size()];
+			color::rgb low, high;
+			color::gradient(grad.from_low, next_grad.from_low, max_gradient_step, step, low);
+			color::gradient(grad.from_high, next_grad.from_high, max_gradient_step, step, high);
+			for(uint32_t x = 0; x != width_; ++x)
+			{
+				pixels_[y * width_ + x] = color::rgb(
+					high.r * x / (width_ - 1) + low.r * (width_ - x - 1) / width_,
+					high.g * x / (width_ - 1) + low.g * (width_ - x - 1) / width_,
+					high.b * x / (width_ - 1) + low.b * (width_ - x - 1) / width_);
+			}
+		}
+
+		return pixels_;
+	}
+
+private:
+	uint32_t width_;
+	uint32_t height_;
+	std::vector<color::rgb> pixels_;
+};
+
+///The same bar colors calculated with gradient tables like the spectrum analyzer effect does
+class sa_tables
+{
+public:
+	static const uint32_t max_gradient_step = sa_per_pixel::max_gradient_step;
+
+	sa_tables(uint32_t width, uint32_t height)
+		: width_(width)
+		, height_(height)
+		, pixels_(width * height)
+		, low_weight_(gradient_lut::get_weight(width, width - 1))
+		, built_gradient_(sa_gradients.size())
+		, bar_(width)
+	{
+	}
+
+	const std::vector<color::rgb>& render(uint32_t frame)
+	{
+		for(uint32_t y = 0; y != height_; ++y)
+		{
+			const uint32_t row_index = frame * height_ + y;
+			const uint32_t step = row_index % (2 * max_gradient_step);
+			const size_t current_gradient = row_index / (2 * max_gradient_step) % sa_gradients.size();
+			if(current_gradient != built_gradient_)
+			{
+				const auto& grad = sa_gradients[current_gradient];
+				const auto& next_grad = sa_gradients[(current_gradient + 1) % sa_gradients.size()];
+				low_lut_.build(gradient_lut::interpolate({ 0, 0, 0 }, grad.from_low, low_weight_),
+					gradient_lut::interpolate({ 0, 0, 0 }, next_grad.from_low, low_weight_));
+				high_lut_.build(grad.from_high, next_grad.from_high);
+				built_gradient_ = current_gradient;
+			}
+
+			const color::rgb* row = bar_.fill(low_lut_.at(max_gradient_step, step),
+				high_lut_.at(max_gradient_step, step));
+			std::copy(row, row + width_, pixels_.begin() + y * width_);
+		}
+
+		return pixels_;
+	}
+
+private:
+	uint32_t width_;
+	uint32_t height_;
+	std::vector<color::rgb> pixels_;
+	uint32_t low_weight_;
+	size_t built_gradient_;
+	gradient_lut low_lut_, high_lut_;
+	gradient_row bar_;
+};
+
+///Calculates colors of all equalizer bands at the highest level
+///like the glowing dots effect did before gradient tables
+class dots_per_pixel
+{
+public:
+	static const uint32_t max_gradient_step = 500;
+
+	dots_per_pixel()
+		: pixels_(equalizer::band_count)
+	{
+	}
+
+	const std::vector<color::rgb>& render(uint32_t frame)
+	{
+		const uint32_t step = frame % max_gradient_step;
+		const size_t current_gradient = frame / max_gradient_step % dots_gradients.size();
+		const auto& grad = dots_gradients[current_gradient];
+		const auto& next_grad = dots_gradients[(current_gradient + 1) % dots_gradients.size()];
+		for(uint32_t i = 0; i != equalizer::band_count; ++i)
+		{
+			color::rgb low_freq, high_freq, to;
+			color::gradient(grad.first, next_grad.first, max_gradient_step, step, low_freq);
+			color::gradient(grad.second, next_grad.second, max_gradient_step, step, high_freq);
+			color::gradient(low_freq, high_freq, equalizer::max_band_index, i, to);
+			color::gradient({ 0, 0, 0 }, to, max_level, max_level, pixels_[i]);
+		}
+
+		return pixels_;
+	}
+
+private:
+	static const uint32_t max_level = 15;
+
+	std::vector<color::rgb> pixels_;
+};
+
+///The same band colors calculated with gradient tables like the glowing dots effect does
+class dots_tables
+{
+public:
+	static const uint32_t max_gradient_step = dots_per_pixel::max_gradient_step;
+
+	dots_tables()
+		: pixels_(equalizer::band_count)
+		, built_gradient_(dots_gradients.size())
+		, band_colors_(equalizer::band_count)
+	{
+	}
+
+	const std::vector<color::rgb>& render(uint32_t frame)
+	{
+		const uint32_t step = frame % max_gradient_step;
+		const size_t current_gradient = frame / max_gradient_step % dots_gradients.size();
+		if(current_gradient != built_gradient_)
+		{
+			const auto& grad = dots_gradients[current_gradient];
+			const auto& next_grad = dots_gradients[(current_gradient + 1) % dots_gradients.size()];
+			low_freq_lut_.build(grad.first, next_grad.first);
+			high_freq_lut_.build(grad.second, next_grad.second);
+			built_gradient_ = current_gradient;
+		}
+
+		band_colors_.fill(low_freq_lut_.at(max_gradient_step, step),
+			high_freq_lut_.at(max_gradient_step, step));
+		for(uint32_t i = 0; i != equalizer::band_count; ++i)
+		{
+			pixels_[i] = gradient_lut::interpolate({ 0, 0, 0 }, band_colors_.data()[i],
+				gradient_lut::get_weight(max_level, max_level));
+		}
+
+		return pixels_;
+	}
+
+private:
+	static const uint32_t max_level = 15;
+
+	std::vector<color::rgb> pixels_;
+	size_t built_gradient_;
+	gradient_lut low_freq_lut_, high_freq_lut_;
+	gradient_row band_colors_;
+};
+
+template<typename Renderer>
+double measure_ns_per_frame(Renderer& renderer)
+{
+	const auto start = std::chrono::steady_clock::now();
+	for(uint32_t frame = 0; frame != frame_count; ++frame)
+		add_to_checksum(renderer.render(frame));
+
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count()
+		/ frame_count;
+}
+
+template<typename PerPixel, typename Tables>
+void benchmark(const char* name, PerPixel per_pixel, Tables tables)
+{
+	const double per_pixel_time = measure_ns_per_frame(per_pixel);
+	const double tables_time = measure_ns_per_frame(tables);
+
+	uint8_t max_difference = 0;
+	for(uint32_t frame = 0; frame != frame_count; ++frame)
+	{
+		const uint8_t difference = get_max_difference(per_pixel.render(frame), tables.render(frame));
+		if(difference > max_difference)
+			max_difference = difference;
+	}
+
+	printf("%s: per pixel %.0f ns/frame, tables %.0f ns/frame, max difference %u\n",
+		name, per_pixel_time, tables_time, max_difference);
+}
+} //namespace
+
+int main()
+{
+	benchmark("Spectrum analyzer 10x16", sa_per_pixel(10, 16), sa_tables(10, 16));
+	benchmark("Spectrum analyzer 40x32", sa_per_pixel(40, 32), sa_tables(40, 32));
+	benchmark("Glowing dots", dots_per_pixel(), dots_tables());
+	printf("Checksum %u\n", checksum);
+	return 0;
+}
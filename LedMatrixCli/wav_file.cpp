@@ -0,0 +1,133 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#include "wav_file.h"
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string.h>
+
+namespace
+{
+const uint16_t format_pcm = 1;
+const uint16_t format_float = 3;
+const uint16_t format_extensible = 0xfffe;
+
+uint32_t read_le(const uint8_t* data, uint32_t size)
+{
+	uint32_t value = 0;
+	for(uint32_t i = 0; i != size; ++i)
+		value |= static_cast<uint32_t>(data[i]) << (i * 8);
+
+	return value;
+}
+
+float read_sample(const uint8_t* data, uint16_t format, uint16_t bits_per_sample)
+{
+	if(format == format_float)
+	{
+		const uint32_t value = read_le(data, 4);
+		float result;
+		memcpy(&result, &value, sizeof(result));
+		return result;
+	}
+
+	switch(bits_per_sample)
+	{
+	case 8: //8-bit data is unsigned
+		return (static_cast<int32_t>(data[0]) - 0x80) / 128.f;
+
+	case 16:
+		return static_cast<int16_t>(read_le(data, 2)) / 32768.f;
+
+	case 24: //Sign-extend 24-bit value
+		return static_cast<int32_t>(read_le(data, 3) << 8) / 2147483648.f;
+
+	default:
+		return static_cast<int32_t>(read_le(data, 4)) / 2147483648.f;
+	}
+}
+} //namespace
+
+wav_file::wav_file(const std::string& path)
+	: sample_rate_(0)
+{
+	std::ifstream file(path, std::ios::binary);
+	if(!file)
+		throw std::runtime_error("Unable to open " + path);
+
+	const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if(data.size() < 12 || memcmp(data.data(), "RIFF", 4) || memcmp(data.data() + 8, "WAVE", 4))
+		throw std::runtime_error(path + " is not a WAV file");
+
+	uint16_t format = 0, channels = 0, bits_per_sample = 0, block_align = 0;
+	const uint8_t* samples = nullptr;
+	size_t samples_size = 0;
+
+	//Walk RIFF chunks, each chunk is padded to even size
+	size_t offset = 12;
+	while(offset + 8 <= data.size())
+	{
+		const uint8_t* chunk = data.data() + offset;
+		size_t chunk_size = read_le(chunk + 4, 4);
+		if(chunk_size > data.size() - offset - 8)
+			chunk_size = data.size() - offset - 8;
+
+		if(!memcmp(chunk, "fmt ", 4) && chunk_size >= 16)
+		{
+			format = static_cast<uint16_t>(read_le(chunk + 8, 2));
+			channels = static_cast<uint16_t>(read_le(chunk + 10, 2));
+			sample_rate_ = read_le(chunk + 12, 4);
+			block_align = static_cast<uint16_t>(read_le(chunk + 20, 2));
+			bits_per_sample = static_cast<uint16_t>(read_le(chunk + 22, 2));
+			//Extensible format has real format in the first bytes of subformat GUID
+			if(format == format_extensible && chunk_size >= 26)
+				format = static_cast<uint16_t>(read_le(chunk + 32, 2));
+		}
+		else if(!memcmp(chunk, "data", 4))
+		{
+			samples = chunk + 8;
+			samples_size = chunk_size;
+		}
+
+		offset += 8 + chunk_size + (chunk_size & 1);
+	}
+
+	const bool is_supported_pcm = format == format_pcm && (bits_per_sample == 8 || bits_per_sample == 16
+		|| bits_per_sample == 24 || bits_per_sample == 32);
+	const bool is_supported_float = format == format_float && bits_per_sample == 32;
+	if(!samples || !channels || !sample_rate_ || (!is_supported_pcm && !is_supported_float)
+		|| block_align != channels * bits_per_sample / 8)
+	{
+		throw std::runtime_error(path + " has unsupported WAV format");
+	}
+
+	const uint32_t bytes_per_sample = bits_per_sample / 8;
+	const size_t frame_count = samples_size / block_align;
+	samples_.reserve(frame_count);
+	for(size_t i = 0; i != frame_count; ++i)
+	{
+		const uint8_t* frame = samples + i * block_align;
+		float value = 0;
+		for(uint16_t channel = 0; channel != channels; ++channel)
+			value += read_sample(frame + channel * bytes_per_sample, format, bits_per_sample);
+
+		samples_.push_back(value / channels);
+	}
+}
+
+uint32_t wav_file::get_sample_rate() const
+{
+	return sample_rate_;
+}
+
+const std::vector<float>& wav_file::get_samples() const
+{
+	return samples_;
+}
+
+double wav_file::get_duration() const
+{
+	return static_cast<double>(samples_.size()) / sample_rate_;
+}
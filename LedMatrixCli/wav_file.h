@@ -0,0 +1,31 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+///WAV file reader. Supports 8, 16, 24 and 32-bit integer PCM and
+///32-bit float data. All channels are mixed to single (mono) channel.
+class wav_file
+{
+public:
+	/** Loads WAV file
+	*   @param path File path
+	*   @throw std::runtime_error in case file can't be read or has unsupported format */
+	explicit wav_file(const std::string& path);
+
+	uint32_t get_sample_rate() const;
+
+	///Returns mono samples (-1.0 to 1.0)
+	const std::vector<float>& get_samples() const;
+
+	///Returns duration in seconds
+	double get_duration() const;
+
+private:
+	uint32_t sample_rate_;
+	std::vector<float> samples_;
+};
@@ -0,0 +1,75 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#include "canvas.h"
+
+#include <algorithm>
+
+namespace
+{
+uint8_t add_saturated(uint8_t value, uint8_t addend)
+{
+	const uint32_t sum = static_cast<uint32_t>(value) + addend;
+	return static_cast<uint8_t>(sum > 0xff ? 0xff : sum);
+}
+} //namespace
+
+canvas::canvas(uint32_t width, uint32_t height)
+	: width_(width)
+	, height_(height)
+	, pixels_(width * height)
+{
+}
+
+uint32_t canvas::get_width() const
+{
+	return width_;
+}
+
+uint32_t canvas::get_height() const
+{
+	return height_;
+}
+
+void canvas::set_pixel(uint32_t x, uint32_t y, const color::rgb& color)
+{
+	if(x >= width_ || y >= height_)
+		return;
+
+	pixels_[y * width_ + x] = color;
+}
+
+void canvas::set_row(uint32_t y, const color::rgb* colors, uint32_t count)
+{
+	if(y >= height_)
+		return;
+
+	if(count > width_)
+		count = width_;
+
+	std::copy(colors, colors + count, pixels_.begin() + y * width_);
+}
+
+color::rgb canvas::get_pixel(uint32_t x, uint32_t y) const
+{
+	if(x >= width_ || y >= height_)
+		return color::rgb();
+
+	return pixels_[y * width_ + x];
+}
+
+void canvas::clear()
+{
+	std::fill(pixels_.begin(), pixels_.end(), color::rgb());
+}
+
+void canvas::add_pixel_saturated(uint32_t x, uint32_t y, const color::rgb& color)
+{
+	if(x >= width_ || y >= height_)
+		return;
+
+	auto& pixel = pixels_[y * width_ + x];
+	pixel.r = add_saturated(pixel.r, color.r);
+	pixel.g = add_saturated(pixel.g, color.g);
+	pixel.b = add_saturated(pixel.b, color.b);
+}
@@ -0,0 +1,42 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "colors.h"
+
+///RGB canvas of arbitrary size. Effects are rendered to canvas,
+///which is then split to device displays (see tile_layout).
+class canvas
+{
+public:
+	///Creates empty canvas (filled with black color)
+	canvas(uint32_t width, uint32_t height);
+
+	uint32_t get_width() const;
+	uint32_t get_height() const;
+
+	///Sets separate pixel color
+	void set_pixel(uint32_t x, uint32_t y, const color::rgb& color);
+
+	///Sets colors of first count pixels of row y
+	void set_row(uint32_t y, const color::rgb* colors, uint32_t count);
+
+	///Returns separate pixel color
+	color::rgb get_pixel(uint32_t x, uint32_t y) const;
+
+	///Fills canvas with black color
+	void clear();
+
+	///Adds color to separate pixel color. Each color
+	///component is clamped to 0xff.
+	void add_pixel_saturated(uint32_t x, uint32_t y, const color::rgb& color);
+
+private:
+	uint32_t width_;
+	uint32_t height_;
+	std::vector<color::rgb> pixels_;
+};
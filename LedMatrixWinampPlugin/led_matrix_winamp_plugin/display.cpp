@@ -31,5 +31,6 @@ color::rgb display::get_pixel(uint8_t x, uint8_t y) const
 
 void display::clear()
 {
-	memset(matrix_.data(), 0, sizeof(matrix_));
+	for(auto& row : matrix_)
+		row.fill(color::rgb());
 }
@@ -14,7 +14,7 @@ device_offline_exception::device_offline_exception()
 {
 }
 
-void display_protocol::send_data_to_device(const display& data, uart& com_port)
+std::vector<uint8_t> display_protocol::encode(const display& data)
 {
 	std::vector<uint8_t> data_bytes { 0xff, 0x00 }; //Sync bytes
 	data_bytes.reserve(display::display_height * display::display_width * display::bytes_per_led
@@ -40,10 +40,14 @@ void display_protocol::send_data_to_device(const display& data, uart& com_port)
 		}
 	}
 
+	return data_bytes;
+}
+
+void display_protocol::wait_for_device(uart& com_port)
+{
 	try
 	{
 		static const uint8_t device_ready_bytes = 0x78;
-		com_port.write_data(data_bytes.data(), data_bytes.size());
 		while(com_port.read_byte() != device_ready_bytes)
 		{
 		}
@@ -53,3 +57,20 @@ void display_protocol::send_data_to_device(const display& data, uart& com_port)
 		throw device_offline_exception();
 	}
 }
+
+uint32_t display_protocol::send_data_to_device(const display& data, uart& com_port)
+{
+	const std::vector<uint8_t> data_bytes = encode(data);
+
+	try
+	{
+		com_port.write_data(data_bytes.data(), static_cast<uint32_t>(data_bytes.size()));
+	}
+	catch(const std::exception&)
+	{
+		throw device_offline_exception();
+	}
+
+	wait_for_device(com_port);
+	return static_cast<uint32_t>(data_bytes.size());
+}
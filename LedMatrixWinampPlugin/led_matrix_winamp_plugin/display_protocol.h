@@ -4,6 +4,8 @@
 #pragma once
 
 #include <stdexcept>
+#include <stdint.h>
+#include <vector>
 
 #include "static_class.h"
 
@@ -20,9 +22,21 @@ public:
 class display_protocol : static_class
 {
 public:
+	/** Encodes data to bytes sent to device
+	*   @param data Data to encode
+	*   @returns Sync bytes followed by color bytes (0xff color bytes are doubled).
+	*   Device shows the picture when the last byte is received. */
+	static std::vector<uint8_t> encode(const display& data);
+
+	/** Waits for device to show the picture
+	*   @param com_port UART instance
+	*   @throw device_offline_exception in case device doesn't respond */
+	static void wait_for_device(uart& com_port);
+
 	/** Sends data to device
 	*   @param data Data to send 
 	*   @param com_port UART instance
+	*   @returns Number of bytes sent
 	*   @throw device_offline_exception in case device doesn't respond */
-	static void send_data_to_device(const display& data, uart& com_port);
+	static uint32_t send_data_to_device(const display& data, uart& com_port);
 };
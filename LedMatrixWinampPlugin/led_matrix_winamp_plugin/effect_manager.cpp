@@ -4,18 +4,20 @@
 #include "effect_manager.h"
 
 #include <algorithm>
+#include <array>
 #include <ctime>
 #include <functional>
 #include <vector>
 
+#include "canvas.h"
 #include "colors.h"
 #include "display.h"
-#include "display_protocol.h"
 #include "equalizer.h"
+#include "gradient.h"
+#include "tiled_output.h"
 
 effect_manager::effect_manager()
 	: running_(false)
-	, com_port_(nullptr)
 	, effect_processor_(effect_processor::spectrum_analyzer)
 {
 	random_gen_.seed(static_cast<std::mt19937::result_type>(std::time(0)));
@@ -27,6 +29,11 @@ effect_manager::~effect_manager()
 }
 
 void effect_manager::start(uart& com_port)
+{
+	start({ &com_port }, tile_layout());
+}
+
+void effect_manager::start(const std::vector<uart*>& com_ports, const tile_layout& layout)
 {
 	if(worker_.joinable())
 		worker_.join();
@@ -34,7 +41,17 @@ void effect_manager::start(uart& com_port)
 	bool expected = false;
 	if(running_.compare_exchange_strong(expected, true))
 	{
-		com_port_ = &com_port;
+		try
+		{
+			output_.reset(new tiled_output(layout, com_ports));
+		}
+		catch(...)
+		{
+			running_ = false;
+			throw;
+		}
+
+		pacer_.reset();
 		worker_ = std::thread(std::bind(&effect_manager::worker, this));
 	}
 	else
@@ -50,6 +67,8 @@ void effect_manager::stop()
 	
 	if(worker_.joinable())
 		worker_.join();
+
+	output_.reset();
 }
 
 namespace
@@ -61,19 +80,49 @@ struct sa_gradient
 	color::rgb peak;
 };
 
+///Wave kernel pixel: pixel coordinates and Manhattan distance
+///from the frequency point
+struct wave_kernel_pixel
+{
+	uint32_t x;
+	uint32_t y;
+	uint8_t distance;
+};
+
 struct frequency_point
 {
-	frequency_point(uint8_t x, uint8_t y)
+	///Max distance from the point the wave travels
+	static const uint8_t max_wave_radius = 7;
+
+	frequency_point(uint32_t x, uint32_t y, const canvas& target)
 		: x(x), y(y)
 		, current_value(0)
 	{
+		//Precalculate all canvas pixels the wave of this point can reach
+		for(int32_t pixel_y = 0; pixel_y != static_cast<int32_t>(target.get_height()); ++pixel_y)
+		{
+			for(int32_t pixel_x = 0; pixel_x != static_cast<int32_t>(target.get_width()); ++pixel_x)
+			{
+				const int32_t distance = abs(pixel_x - static_cast<int32_t>(x))
+					+ abs(pixel_y - static_cast<int32_t>(y));
+				if(distance <= max_wave_radius)
+				{
+					kernel.push_back({ static_cast<uint32_t>(pixel_x),
+						static_cast<uint32_t>(pixel_y), static_cast<uint8_t>(distance) });
+				}
+			}
+		}
 	}
 
-	uint8_t x;
-	uint8_t y;
+	uint32_t x;
+	uint32_t y;
 	color::rgb current_color;
 	uint8_t current_value;
-	display matrix;
+	std::vector<wave_kernel_pixel> kernel;
+	///Point colors of last frames, the most recent one goes first.
+	///Pixel at distance d (d > 0) has color history[d - 1]
+	///with components halved d - 1 times.
+	std::array<color::rgb, max_wave_radius> history;
 };
 
 struct effect_gradient
@@ -92,11 +141,22 @@ struct low_high_frequency_gradient
 
 void effect_manager::effect_glowing_dots()
 {
-	std::vector<uint8_t> transformation;
-	for(uint8_t i = 0; i != display::display_width * display::display_height; ++i)
+	canvas matrix(create_canvas());
+	const uint32_t width = matrix.get_width();
+	const uint32_t pixel_count = width * matrix.get_height();
+
+	std::vector<uint32_t> transformation;
+	for(uint32_t i = 0; i != pixel_count; ++i)
 		transformation.push_back(i);
 	std::shuffle(transformation.begin(), transformation.end(), random_gen_);
 
+	//Each band lights the same number of pixels, remaining pixels
+	//are given to the first and to the last bands
+	const uint32_t band_pixel_count = pixel_count / equalizer::band_count;
+	const uint32_t extra_pixel_count = pixel_count % equalizer::band_count;
+	const uint32_t first_bands_with_extra_pixel = extra_pixel_count / 2;
+	const uint32_t last_bands_with_extra_pixel = extra_pixel_count - first_bands_with_extra_pixel;
+
 	const std::vector<low_high_frequency_gradient> gradients
 	{
 		{ { 0, 0, 0xff }, { 0xff, 0xff, 0 } },
@@ -114,13 +174,28 @@ void effect_manager::effect_glowing_dots()
 	size_t current_gradient = 0;
 	uint32_t gradient_step = 0;
 
-	display matrix;
+	//Palette transitions are rebuilt only when the palette advances
+	gradient_lut low_freq_lut, high_freq_lut;
+	auto build_luts = [&]()
+	{
+		const auto& grad = gradients[current_gradient];
+		const auto& next_grad = gradients[(current_gradient + 1) % gradients.size()];
+		low_freq_lut.build(grad.low_frequency, next_grad.low_frequency);
+		high_freq_lut.build(grad.high_frequency, next_grad.high_frequency);
+	};
+	build_luts();
+
+	gradient_row band_colors(equalizer::band_count);
+
 	while(running_ && effect_processor_ == effect_processor::glowing_dots)
 	{
 		auto data = equalizer::get_raw_equalizer_data();
 
-		uint8_t pixel_index = 0;
-		for(size_t i = 0; i != equalizer::band_count; ++i)
+		band_colors.fill(low_freq_lut.at(max_gradient_step, gradient_step),
+			high_freq_lut.at(max_gradient_step, gradient_step));
+
+		uint32_t pixel_index = 0;
+		for(uint32_t i = 0; i != equalizer::band_count; ++i)
 		{
 			uint8_t eq_value = data.at(i);
 			if(eq_value > max_eq_value)
@@ -133,27 +208,17 @@ void effect_manager::effect_glowing_dots()
 			else if(peaks[i])
 				--peaks[i];
 
-			color::rgb low_freq, high_freq;
-			const auto& grad = gradients[current_gradient];
-			const auto& next_grad = gradients[(current_gradient + 1) % gradients.size()];
-			color::gradient(grad.low_frequency, next_grad.low_frequency, max_gradient_step, gradient_step, low_freq);
-			color::gradient(grad.high_frequency, next_grad.high_frequency, max_gradient_step, gradient_step, high_freq);
-
-			color::rgb to;
-			color::gradient(low_freq, high_freq, equalizer::band_count - 1, i, to);
-
-			color::rgb result_color;
-			color::gradient({ 0, 0, 0 }, to, effect_manager::max_eq_value, peaks[i], result_color);
+			const color::rgb result_color = gradient_lut::interpolate({ 0, 0, 0 }, band_colors.data()[i],
+				gradient_lut::get_weight(effect_manager::max_eq_value, peaks[i]));
 
-			uint8_t pixel_count = 2;
-			uint8_t y = i / display::display_width;
-			if(y == 0 || y == (equalizer::band_count / display::display_width) - 1)
-				pixel_count = 3;
+			uint32_t current_band_pixel_count = band_pixel_count;
+			if(i < first_bands_with_extra_pixel || i >= equalizer::band_count - last_bands_with_extra_pixel)
+				++current_band_pixel_count;
 
-			for(uint8_t px = 0; px != pixel_count; ++px)
+			for(uint32_t px = 0; px != current_band_pixel_count; ++px)
 			{
-				uint8_t x = transformation[pixel_index] % display::display_width;
-				y = transformation[pixel_index] / display::display_width;
+				const uint32_t x = transformation[pixel_index] % width;
+				const uint32_t y = transformation[pixel_index] / width;
 				++pixel_index;
 				matrix.set_pixel(x, y, result_color);
 			}
@@ -163,9 +228,10 @@ void effect_manager::effect_glowing_dots()
 		{
 			gradient_step = 0;
 			current_gradient = (current_gradient + 1) % gradients.size();
+			build_luts();
 		}
 
-		display_protocol::send_data_to_device(matrix, *com_port_);
+		send_frame(matrix);
 	}
 }
 
@@ -176,11 +242,19 @@ void effect_manager::effect_spectrum_analyzer()
 	size_t current_gradient = 0;
 	uint32_t gradient_step = 0;
 
-	display matrix;
+	canvas matrix(create_canvas());
+	const uint32_t width = matrix.get_width();
+	const uint32_t height = matrix.get_height();
 	std::vector<double> prev_data;
 	std::vector<double> peaks;
-	prev_data.resize(display::display_height);
-	peaks.resize(display::display_height);
+	prev_data.resize(height);
+	peaks.resize(height);
+
+	//Canvas can be higher than number of equalizer bands,
+	//several rows show the same band in this case
+	uint32_t sa_band_count = height;
+	if(sa_band_count > equalizer::band_count)
+		sa_band_count = equalizer::band_count;
 
 	const std::vector<sa_gradient> gradients
 	{
@@ -192,23 +266,41 @@ void effect_manager::effect_spectrum_analyzer()
 		{ { 0x50, 0x50, 0 }, { 0xff, 0xff, 0 }, { 0, 0x90, 0x20 } }
 	};
 
+	//Bar pixel x has color high * x / (width - 1) + low * (width - x - 1) / width,
+	//which is a linear gradient from low * (width - 1) / width to high,
+	//so low colors are scaled once when the palette advances
+	const uint32_t low_weight = gradient_lut::get_weight(width, width - 1);
+	gradient_lut low_lut, high_lut, peak_lut;
+	auto build_luts = [&]()
+	{
+		const auto& grad = gradients[current_gradient];
+		const auto& next_grad = gradients[(current_gradient + 1) % gradients.size()];
+		low_lut.build(gradient_lut::interpolate({ 0, 0, 0 }, grad.from_low, low_weight),
+			gradient_lut::interpolate({ 0, 0, 0 }, next_grad.from_low, low_weight));
+		high_lut.build(grad.from_high, next_grad.from_high);
+		peak_lut.build(grad.peak, next_grad.peak);
+	};
+	build_luts();
+
+	gradient_row bar(width);
+
 	while(running_ && effect_processor_ == effect_processor::spectrum_analyzer)
 	{
 		auto data = equalizer::cut_sa_data(equalizer::get_raw_equalizer_data(),
-			display::display_height, equalizer::cut_mode::single);
+			static_cast<uint8_t>(sa_band_count), equalizer::cut_mode::single);
 
 		matrix.clear();
-		for(uint8_t y = 0; y != display::display_height; ++y)
+		for(uint32_t y = 0; y != height; ++y)
 		{
-			uint8_t eq_value = data.at(y);
+			uint8_t eq_value = data.at(y * sa_band_count / height);
 			if(eq_value > max_eq_value)
 				eq_value = max_eq_value;
 
-			double max_x = static_cast<double>(display::display_width) * eq_value / max_eq_value;
+			double max_x = static_cast<double>(width) * eq_value / max_eq_value;
 			double prev_value = prev_data[y];
 			if(prev_value > max_x)
 			{
-				max_x = prev_value - 0.7 - (display::display_width - prev_value) / 20;
+				max_x = prev_value - 0.7 - (width - prev_value) / 20;
 				if(max_x < 0)
 					max_x = 0;
 			}
@@ -220,41 +312,28 @@ void effect_manager::effect_spectrum_analyzer()
 			}
 			else
 			{
-				peaks[y] -= (display::display_width - peaks[y]) / 10;
+				peaks[y] -= (width - peaks[y]) / 10;
 				if(peaks[y] < 0)
 					peaks[y] = 0;
 			}
 
-			color::rgb low, high, peak;
-			const auto& grad = gradients[current_gradient];
-			const auto& next_grad = gradients[(current_gradient + 1) % gradients.size()];
-			color::gradient(grad.from_low, next_grad.from_low, max_gradient_step, gradient_step, low);
-			color::gradient(grad.from_high, next_grad.from_high, max_gradient_step, gradient_step, high);
-			color::gradient(grad.peak, next_grad.peak, max_gradient_step, gradient_step, peak);
+			const color::rgb peak = peak_lut.at(max_gradient_step, gradient_step);
+			matrix.set_row(y, bar.fill(low_lut.at(max_gradient_step, gradient_step),
+				high_lut.at(max_gradient_step, gradient_step)), static_cast<uint32_t>(max_x));
 
 			if(++gradient_step == max_gradient_step)
 			{
 				gradient_step = 0;
 				current_gradient = (current_gradient + 1) % gradients.size();
-			}
-
-			for(uint32_t x = 0; x != static_cast<uint32_t>(max_x); ++x)
-			{
-				color::rgb color(high.r * x / (display::display_width - 1)
-					+ low.r * (display::display_width - x - 1) / display::display_width,
-					high.g * x / (display::display_width - 1)
-					+ low.g * (display::display_width - x - 1) / display::display_width,
-					high.b * x / (display::display_width - 1)
-					+ low.b * (display::display_width - x - 1) / display::display_width);
-				matrix.set_pixel(x, y, color);
+				build_luts();
 			}
 
 			const double peak_value = peaks.at(y);
 			if(peak_value > 1)
-				matrix.set_pixel(static_cast<uint8_t>(peak_value), y, peak);
+				matrix.set_pixel(static_cast<uint32_t>(peak_value), y, peak);
 		}
 
-		display_protocol::send_data_to_device(matrix, *com_port_);
+		send_frame(matrix);
 	}
 }
 
@@ -269,7 +348,11 @@ void effect_manager::effect_color_waves()
 		{ { 0xff, 0x33, 0 }, { 0, 0xff, 0 }, { 0x50, 0xff, 0x50 } }
 	};
 
-	std::vector<frequency_point> freq_points
+	canvas matrix(create_canvas());
+
+	//Point coordinates on the single device display,
+	//they are scaled to the canvas size
+	const std::vector<std::pair<uint32_t, uint32_t>> display_points
 	{
 		{ 3, 2 },
 		{ 6, 2 },
@@ -290,7 +373,13 @@ void effect_manager::effect_color_waves()
 		{ 6, 13 }
 	};
 
-	display matrix;
+	std::vector<frequency_point> freq_points;
+	for(const auto& point : display_points)
+	{
+		freq_points.emplace_back(point.first * matrix.get_width() / display::display_width,
+			point.second * matrix.get_height() / display::display_height, matrix);
+	}
+
 	size_t current_gradient = 0;
 	uint32_t current_gradient_step = 0;
 	static const uint32_t max_gradient_step = 2000;
@@ -353,78 +442,30 @@ void effect_manager::effect_color_waves()
 				--freq_point.current_value;
 		}
 
+		matrix.clear();
 		for(size_t i = 0; i != freq_points.size(); ++i)
 		{
 			auto& freq_point = freq_points[i];
-			freq_point.matrix.set_pixel(freq_point.x, freq_point.y, freq_point.current_color);
-			for(uint8_t r = 7; r != 1; --r)
-			{
-				for(int8_t x = -r; x != r + 1; ++x)
-				{
-					for(int8_t y = -r; y != r + 1; ++y)
-					{
-						if(abs(x) + abs(y) == r)
-						{
-							int8_t prev_x = x;
-							int8_t prev_y = y;
-							if(x < 0)
-							{
-								prev_x = x + 1;
-							}
-							else if(x > 0)
-							{
-								prev_x = x - 1;
-							}
-							else
-							{
-								if(y > 0)
-									prev_y = y - 1;
-								else
-									prev_y = y + 1;
-							}
-
-							auto color = freq_point.matrix.get_pixel(freq_point.x + prev_x, freq_point.y + prev_y);
-							color.r /= 2;
-							color.g /= 2;
-							color.b /= 2;
-							freq_point.matrix.set_pixel(freq_point.x + x, freq_point.y + y, color);
-						}
-					}
-				}
-			}
+			std::copy_backward(freq_point.history.begin(), freq_point.history.end() - 1,
+				freq_point.history.end());
+			freq_point.history[0] = freq_point.current_color;
 
-			for(int8_t x = -1; x != 2; ++x)
+			std::array<color::rgb, frequency_point::max_wave_radius + 1> attenuated;
+			attenuated[0] = freq_point.current_color;
+			for(uint8_t distance = 1; distance != attenuated.size(); ++distance)
 			{
-				for(int8_t y = -1; y != 2; ++y)
-				{
-					if(abs(x) + abs(y) == 1)
-						freq_point.matrix.set_pixel(freq_point.x + x, freq_point.y + y, freq_point.current_color);
-				}
+				const auto& color = freq_point.history[distance - 1];
+				const uint8_t shift = distance - 1;
+				attenuated[distance] = { static_cast<uint8_t>(color.r >> shift),
+					static_cast<uint8_t>(color.g >> shift),
+					static_cast<uint8_t>(color.b >> shift) };
 			}
-		}
 
-		for(uint8_t x = 0; x != display::display_width; ++x)
-		{
-			for(uint8_t y = 0; y != display::display_height; ++y)
-			{
-				uint32_t color_r = 0, color_g = 0, color_b = 0;
-				for(size_t i = 0; i != freq_points.size(); ++i)
-				{
-					auto color = freq_points[i].matrix.get_pixel(x, y);
-					color_r += color.r;
-					color_g += color.g;
-					color_b += color.b;
-				}
-
-				color_r = (std::min)(color_r, 0xffu);
-				color_g = (std::min)(color_g, 0xffu);
-				color_b = (std::min)(color_b, 0xffu);
-
-				matrix.set_pixel(x, y, { static_cast<uint8_t>(color_r), static_cast<uint8_t>(color_g), static_cast<uint8_t>(color_b) });
-			}
+			for(const auto& pixel : freq_point.kernel)
+				matrix.add_pixel_saturated(pixel.x, pixel.y, attenuated[pixel.distance]);
 		}
 
-		display_protocol::send_data_to_device(matrix, *com_port_);
+		send_frame(matrix);
 	}
 }
 
@@ -433,6 +474,30 @@ void effect_manager::set_effect_processor(effect_processor processor)
 	effect_processor_ = processor;
 }
 
+void effect_manager::set_target_fps(uint32_t target_fps)
+{
+	pacer_.set_target_fps(target_fps);
+}
+
+frame_pacer::statistics effect_manager::get_statistics() const
+{
+	return pacer_.get_statistics();
+}
+
+canvas effect_manager::create_canvas() const
+{
+	const tile_layout& layout = output_->get_layout();
+	return canvas(layout.get_canvas_width(), layout.get_canvas_height());
+}
+
+void effect_manager::send_frame(const canvas& data)
+{
+	const auto send_start = frame_pacer::clock::now();
+	const uint32_t byte_count = output_->send_frame(data);
+	pacer_.on_frame_sent(byte_count, send_start, frame_pacer::clock::now(), output_->get_last_encode_time());
+	pacer_.wait_for_next_frame();
+}
+
 void effect_manager::on_error(const on_error_callback& error)
 {
 	error_callback_ = error;
@@ -462,7 +527,7 @@ void effect_manager::worker()
 				break;
 			}
 
-			display_protocol::send_data_to_device(display(), *com_port_);
+			send_frame(create_canvas());
 		}
 	}
 	catch(...)
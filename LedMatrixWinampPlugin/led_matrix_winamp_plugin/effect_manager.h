@@ -8,9 +8,15 @@
 #include <memory>
 #include <random>
 #include <thread>
+#include <vector>
 
+#include "frame_pacer.h"
+#include "tile_layout.h"
 #include "uart.h"
 
+class canvas;
+class tiled_output;
+
 ///Generates effects based on Winamp equalizer data and sends
 ///effect data to the device via UART
 class effect_manager
@@ -35,7 +41,13 @@ public:
 	~effect_manager();
 
 	void stop();
+	///Starts effects on single device
 	void start(uart& com_port);
+	/** Starts effects on several devices. Effects are rendered to
+	*   canvas of layout size, each device shows its tile.
+	*   @param com_ports UART of each layout tile
+	*   @param layout Device tiles layout */
+	void start(const std::vector<uart*>& com_ports, const tile_layout& layout);
 	
 	///Sets callback that is called in case of error
 	///(such as device offline error). Effect generation is
@@ -44,16 +56,29 @@ public:
 
 	void set_effect_processor(effect_processor processor);
 
+	///Sets FPS effects are rendered with (if device link allows)
+	void set_target_fps(uint32_t target_fps);
+
+	///Returns frame pacing and latency counters. Can be called from any thread.
+	frame_pacer::statistics get_statistics() const;
+
 private:
 	std::atomic<bool> running_;
 	std::thread worker_;
-	uart* com_port_;
+	std::unique_ptr<tiled_output> output_;
 	std::atomic<effect_processor> effect_processor_;
 	on_error_callback error_callback_;
 	std::mt19937 random_gen_;
+	frame_pacer pacer_;
 
 	void worker();
 
+	///Creates empty canvas of current layout size
+	canvas create_canvas() const;
+
+	///Sends frame to the devices and waits until the next frame should be rendered
+	void send_frame(const canvas& data);
+
 	void effect_spectrum_analyzer();
 	void effect_color_waves();
 	void effect_glowing_dots();
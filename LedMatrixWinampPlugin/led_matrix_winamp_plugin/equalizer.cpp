@@ -5,28 +5,18 @@
 
 #include <cassert>
 #include <stdexcept>
-#include <Windows.h>
 
-#include "wa_ipc.h"
+equalizer::data_source equalizer::data_source_;
 
-equalizer::export_sa_get equalizer::export_sa_get_ = nullptr;
-equalizer::export_sa_setreq equalizer::export_sa_setreq_ = nullptr;
-
-void equalizer::init(HWND winamp_window)
+void equalizer::set_data_source(const data_source& source)
 {
-	export_sa_get_ = reinterpret_cast<export_sa_get>(::SendMessageW(winamp_window, WM_WA_IPC, 2, IPC_GETSADATAFUNC));
-	export_sa_setreq_ = reinterpret_cast<export_sa_setreq>(::SendMessageW(winamp_window, WM_WA_IPC, 1, IPC_GETSADATAFUNC));
-	if(!export_sa_get_ || !export_sa_setreq_)
-		throw std::runtime_error("Unable to initialize equalizer");
+	data_source_ = source;
 }
 
 equalizer::sadata equalizer::get_raw_equalizer_data()
 {
-	assert(export_sa_setreq_ && export_sa_get_ && "Equalizer is not initialized");
-	export_sa_setreq_(0);
-	sadata ret;
-	export_sa_get_(ret.data());
-	return ret;
+	assert(data_source_ && "Equalizer is not initialized");
+	return data_source_();
 }
 
 std::vector<uint8_t> equalizer::cut_sa_data(const sadata& data, uint8_t needed_band_count, cut_mode mode)
@@ -3,9 +3,12 @@
 
 #pragma once
 
-#include <Windows.h>
+#ifdef _WIN32
+#	include <Windows.h>
+#endif
 
 #include <array>
+#include <functional>
 #include <stdint.h>
 #include <vector>
 
@@ -21,6 +24,9 @@ public:
 	///Size of this array is taken from Winamp plugin samples (Winamp SDK)
 	typedef std::array<char, 75 * 2 + 8> sadata;
 
+	///Function which returns raw equalizer data
+	typedef std::function<sadata()> data_source;
+
 	///Shrink mode enumeration for cut_sa_data() function
 	enum class cut_mode
 	{
@@ -34,8 +40,14 @@ public:
 	};
 
 public:
-	///Initializes wrapper
+#ifdef _WIN32
+	///Initializes wrapper with Winamp equalizer data source
 	static void init(HWND winamp_window);
+#endif
+
+	///Sets equalizer data source (e.g. audio file analyzer instead of Winamp).
+	///Must not be called while effects are running.
+	static void set_data_source(const data_source& source);
 
 	///Returns raw equalizer data.
 	///The first 70 lines will be the SA data (every line is a band),
@@ -50,8 +62,5 @@ public:
 	static std::vector<uint8_t> cut_sa_data(const sadata& data, uint8_t band_count, cut_mode mode);
 
 private:
-	typedef char* (__cdecl *export_sa_get)(char data[std::tuple_size<sadata>::value]);
-	typedef void (__cdecl *export_sa_setreq)(int want);
-	static export_sa_get export_sa_get_;
-	static export_sa_setreq export_sa_setreq_;
+	static data_source data_source_;
 };
@@ -0,0 +1,31 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#include "equalizer.h"
+
+#include <stdexcept>
+#include <Windows.h>
+
+#include "wa_ipc.h"
+
+namespace
+{
+typedef char* (__cdecl *export_sa_get)(char data[std::tuple_size<equalizer::sadata>::value]);
+typedef void (__cdecl *export_sa_setreq)(int want);
+} //namespace
+
+void equalizer::init(HWND winamp_window)
+{
+	const auto sa_get = reinterpret_cast<export_sa_get>(::SendMessageW(winamp_window, WM_WA_IPC, 2, IPC_GETSADATAFUNC));
+	const auto sa_setreq = reinterpret_cast<export_sa_setreq>(::SendMessageW(winamp_window, WM_WA_IPC, 1, IPC_GETSADATAFUNC));
+	if(!sa_get || !sa_setreq)
+		throw std::runtime_error("Unable to initialize equalizer");
+
+	set_data_source([sa_get, sa_setreq]()
+	{
+		sa_setreq(0);
+		sadata ret;
+		sa_get(ret.data());
+		return ret;
+	});
+}
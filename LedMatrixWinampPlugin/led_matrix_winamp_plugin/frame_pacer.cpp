@@ -0,0 +1,157 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#include "frame_pacer.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace
+{
+///Smoothing factor of round-trip time and throughput moving averages
+const double average_factor = 0.125;
+
+double get_percentile(const std::vector<float>& sorted_values, uint32_t percentile)
+{
+	return sorted_values[(sorted_values.size() - 1) * percentile / 100];
+}
+} //namespace
+
+frame_pacer::frame_pacer(uint32_t target_fps)
+	: target_fps_(target_fps ? target_fps : 1)
+{
+	reset();
+}
+
+void frame_pacer::set_target_fps(uint32_t target_fps)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	target_fps_ = target_fps ? target_fps : 1;
+	frame_interval_ = get_target_interval();
+}
+
+void frame_pacer::reset()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	average_rtt_ = 0;
+	average_throughput_ = 0;
+	frame_interval_ = get_target_interval();
+	next_frame_ = clock::now();
+	frame_start_ = next_frame_;
+	total_render_time_ = clock::duration::zero();
+	total_encode_time_ = clock::duration::zero();
+	total_byte_count_ = 0;
+	sample_index_ = 0;
+	frame_count_ = 0;
+	degraded_frame_count_ = 0;
+}
+
+frame_pacer::clock::duration frame_pacer::get_target_interval() const
+{
+	return std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / target_fps_));
+}
+
+void frame_pacer::on_frame_sent(uint32_t byte_count, clock::time_point send_start, clock::time_point send_end,
+	clock::duration encode_time)
+{
+	const double rtt = std::chrono::duration<double>(send_end - send_start).count();
+	const double throughput = rtt > 0 ? byte_count / rtt : 0;
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	if(frame_count_ == 0)
+	{
+		average_rtt_ = rtt;
+		average_throughput_ = throughput;
+	}
+	else
+	{
+		average_rtt_ += (rtt - average_rtt_) * average_factor;
+		average_throughput_ += (throughput - average_throughput_) * average_factor;
+	}
+
+	//Frame is late if it was acknowledged after the next frame was due.
+	//The first frame is sent right away and has no deadline.
+	if(frame_count_ && send_end > next_frame_)
+		++degraded_frame_count_;
+
+	samples_[sample_index_ % sample_count] = { send_end, static_cast<float>(rtt * 1000) };
+	++sample_index_;
+	++frame_count_;
+	total_render_time_ += send_start - frame_start_;
+	total_encode_time_ += encode_time;
+	total_byte_count_ += byte_count;
+
+	//Device acknowledges each frame, so the link can't sustain more than
+	//one frame per round trip. Lower frame rate instead of sending frames late.
+	const clock::duration sustainable_interval = std::chrono::duration_cast<clock::duration>(
+		std::chrono::duration<double>(average_rtt_));
+	frame_interval_ = std::max(get_target_interval(), sustainable_interval);
+}
+
+void frame_pacer::wait_for_next_frame()
+{
+	clock::time_point next_frame;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		next_frame = next_frame_;
+	}
+
+	//If the frame is late, it is rendered right now,
+	//and frames are not rendered in a burst to catch up
+	const clock::time_point now = clock::now();
+	if(next_frame > now)
+		std::this_thread::sleep_until(next_frame);
+	else
+		next_frame = now;
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	next_frame_ = next_frame + frame_interval_;
+	frame_start_ = clock::now();
+}
+
+frame_pacer::statistics frame_pacer::get_statistics() const
+{
+	statistics result = {};
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	result.target_fps = target_fps_;
+	result.paced_fps = 1.0 / std::chrono::duration<double>(frame_interval_).count();
+	result.throughput = average_throughput_;
+	result.frame_count = frame_count_;
+	result.degraded_frame_count = degraded_frame_count_;
+	if(frame_count_)
+	{
+		result.render_time = std::chrono::duration<double, std::milli>(total_render_time_).count() / frame_count_;
+		result.encode_time = std::chrono::duration<double, std::milli>(total_encode_time_).count() / frame_count_;
+		result.frame_size = static_cast<double>(total_byte_count_) / frame_count_;
+	}
+
+	uint32_t count = sample_index_;
+	if(count > sample_count)
+		count = sample_count;
+	if(!count)
+		return result;
+
+	std::vector<float> rtts;
+	rtts.reserve(count);
+	clock::time_point first_sent = samples_[0].sent, last_sent = samples_[0].sent;
+	for(uint32_t i = 0; i != count; ++i)
+	{
+		rtts.push_back(samples_[i].rtt_ms);
+		first_sent = std::min(first_sent, samples_[i].sent);
+		last_sent = std::max(last_sent, samples_[i].sent);
+	}
+
+	std::sort(rtts.begin(), rtts.end());
+	result.rtt_p50 = get_percentile(rtts, 50);
+	result.rtt_p95 = get_percentile(rtts, 95);
+	result.rtt_p99 = get_percentile(rtts, 99);
+	result.rtt_max = rtts.back();
+
+	const double seconds = std::chrono::duration<double>(last_sent - first_sent).count();
+	if(seconds > 0)
+		result.measured_fps = (count - 1) / seconds;
+
+	return result;
+}
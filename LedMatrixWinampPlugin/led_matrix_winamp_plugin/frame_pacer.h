@@ -0,0 +1,101 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <stdint.h>
+
+///Paces frames sent to the device. Measures round-trip time of each frame
+///(sending data and waiting for device ack), estimates link throughput
+///and limits frame rate to the target FPS or to the FPS the link can
+///sustain, whichever is lower. Frames are never queued: next frame
+///is rendered right before it is needed.
+class frame_pacer
+{
+public:
+	typedef std::chrono::steady_clock clock;
+
+	static const uint32_t default_target_fps = 30;
+	///Number of last frames used to calculate latency percentiles and FPS
+	static const uint32_t sample_count = 256;
+
+	///Pacing and latency counters
+	struct statistics
+	{
+		///FPS requested by user
+		double target_fps;
+		///FPS frames are paced to (lower than target_fps when link is slow)
+		double paced_fps;
+		///Actual FPS of last frames
+		double measured_fps;
+		///Estimated link throughput (bytes per second)
+		double throughput;
+		///Frame round-trip time percentiles (milliseconds)
+		double rtt_p50;
+		double rtt_p95;
+		double rtt_p99;
+		double rtt_max;
+		///Total frames sent
+		uint64_t frame_count;
+		///Frames acknowledged after the next frame was due
+		uint64_t degraded_frame_count;
+		///Average frame render time (milliseconds)
+		double render_time;
+		///Average frame encode time (milliseconds)
+		double encode_time;
+		///Average number of bytes sent per frame
+		double frame_size;
+	};
+
+public:
+	explicit frame_pacer(uint32_t target_fps = default_target_fps);
+
+	///Sets FPS to pace frames to (if link allows)
+	void set_target_fps(uint32_t target_fps);
+
+	///Clears all measurements
+	void reset();
+
+	/** Records sent frame. Frame render time is the time between
+	*   wait_for_next_frame() return and send_start.
+	*   @param byte_count Number of bytes sent
+	*   @param send_start Time the frame sending was started
+	*   @param send_end Time the device acknowledged the frame
+	*   @param encode_time Time spent to encode the frame (part of sending) */
+	void on_frame_sent(uint32_t byte_count, clock::time_point send_start, clock::time_point send_end,
+		clock::duration encode_time);
+
+	///Sleeps until the next frame should be rendered
+	void wait_for_next_frame();
+
+	///Returns current counters. Can be called from any thread.
+	statistics get_statistics() const;
+
+private:
+	struct frame_sample
+	{
+		clock::time_point sent;
+		float rtt_ms;
+	};
+
+	mutable std::mutex mutex_;
+	uint32_t target_fps_;
+	//Exponential moving averages of round-trip time (seconds) and throughput (bytes per second)
+	double average_rtt_;
+	double average_throughput_;
+	clock::duration frame_interval_;
+	clock::time_point next_frame_;
+	clock::time_point frame_start_;
+	clock::duration total_render_time_;
+	clock::duration total_encode_time_;
+	uint64_t total_byte_count_;
+	std::array<frame_sample, sample_count> samples_;
+	uint32_t sample_index_;
+	uint64_t frame_count_;
+	uint64_t degraded_frame_count_;
+
+	clock::duration get_target_interval() const;
+};
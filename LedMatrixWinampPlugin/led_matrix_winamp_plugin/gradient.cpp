@@ -0,0 +1,148 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#include "gradient.h"
+
+#include <stddef.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define GRADIENT_USE_SSE2
+#	include <emmintrin.h>
+#endif
+
+static_assert(sizeof(color::rgb) == 3, "color::rgb must be tightly packed");
+
+namespace
+{
+///Row is filled by blocks of 8 pixels (3 SSE2 registers of 16-bit components)
+const uint32_t pixels_per_block = 8;
+const uint32_t components_per_block = pixels_per_block * 3;
+
+uint8_t interpolate_component(uint8_t from, uint8_t to, uint32_t weight)
+{
+	return static_cast<uint8_t>((from * (gradient_lut::weight_one - weight) + to * weight) >> 8);
+}
+} //namespace
+
+gradient_lut::gradient_lut()
+{
+}
+
+gradient_lut::gradient_lut(const color::rgb& from, const color::rgb& to)
+{
+	build(from, to);
+}
+
+void gradient_lut::build(const color::rgb& from, const color::rgb& to)
+{
+	for(uint32_t i = 0; i != size; ++i)
+		table_[i] = interpolate(from, to, get_weight(size - 1, i));
+}
+
+const color::rgb& gradient_lut::at(uint8_t index) const
+{
+	return table_[index];
+}
+
+const color::rgb& gradient_lut::at(uint32_t step_count, uint32_t current_step) const
+{
+	if(current_step > step_count)
+		current_step = 2 * step_count - current_step;
+
+	return table_[current_step * (size - 1) / step_count];
+}
+
+uint32_t gradient_lut::get_weight(uint32_t step_count, uint32_t current_step)
+{
+	if(current_step > step_count)
+		current_step = 2 * step_count - current_step;
+
+	return current_step * weight_one / step_count;
+}
+
+color::rgb gradient_lut::interpolate(const color::rgb& from, const color::rgb& to, uint32_t weight)
+{
+	return color::rgb(interpolate_component(from.r, to.r, weight),
+		interpolate_component(from.g, to.g, weight),
+		interpolate_component(from.b, to.b, weight));
+}
+
+gradient_row::gradient_row(uint32_t length)
+	: length_(length)
+{
+	const uint32_t block_count = (length + pixels_per_block - 1) / pixels_per_block;
+	weights_.resize(block_count * components_per_block);
+	inverse_weights_.resize(weights_.size());
+	pixels_.resize(weights_.size());
+
+	for(uint32_t i = 0; i != weights_.size(); ++i)
+	{
+		const uint32_t x = i / 3;
+		//Padding pixels after the row end are just not used
+		uint32_t weight = 0;
+		if(x < length && length > 1)
+			weight = gradient_lut::get_weight(length - 1, x);
+
+		weights_[i] = static_cast<uint16_t>(weight);
+		inverse_weights_[i] = static_cast<uint16_t>(gradient_lut::weight_one - weight);
+	}
+}
+
+const color::rgb* gradient_row::fill(const color::rgb& from, const color::rgb& to)
+{
+	size_t i = 0;
+
+#ifdef GRADIENT_USE_SSE2
+	//Color components repeat each 3 values, so each block of 3 registers
+	//has the same [from] and [to] values
+	const __m128i from_values[3] = {
+		_mm_setr_epi16(from.r, from.g, from.b, from.r, from.g, from.b, from.r, from.g),
+		_mm_setr_epi16(from.b, from.r, from.g, from.b, from.r, from.g, from.b, from.r),
+		_mm_setr_epi16(from.g, from.b, from.r, from.g, from.b, from.r, from.g, from.b)
+	};
+	const __m128i to_values[3] = {
+		_mm_setr_epi16(to.r, to.g, to.b, to.r, to.g, to.b, to.r, to.g),
+		_mm_setr_epi16(to.b, to.r, to.g, to.b, to.r, to.g, to.b, to.r),
+		_mm_setr_epi16(to.g, to.b, to.r, to.g, to.b, to.r, to.g, to.b)
+	};
+
+	for(; i != pixels_.size(); i += components_per_block)
+	{
+		__m128i values[3];
+		for(uint32_t reg = 0; reg != 3; ++reg)
+		{
+			const __m128i weight = _mm_loadu_si128(
+				reinterpret_cast<const __m128i*>(&weights_[i + reg * 8]));
+			const __m128i inverse_weight = _mm_loadu_si128(
+				reinterpret_cast<const __m128i*>(&inverse_weights_[i + reg * 8]));
+			//from * (1 - weight) + to * weight never exceeds 0xff00
+			values[reg] = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(from_values[reg], inverse_weight),
+				_mm_mullo_epi16(to_values[reg], weight)), 8);
+		}
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&pixels_[i]),
+			_mm_packus_epi16(values[0], values[1]));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(&pixels_[i + 16]),
+			_mm_packus_epi16(values[2], values[2]));
+	}
+#endif
+
+	for(; i != pixels_.size(); i += 3)
+	{
+		pixels_[i] = interpolate_component(from.r, to.r, weights_[i]);
+		pixels_[i + 1] = interpolate_component(from.g, to.g, weights_[i + 1]);
+		pixels_[i + 2] = interpolate_component(from.b, to.b, weights_[i + 2]);
+	}
+
+	return data();
+}
+
+const color::rgb* gradient_row::data() const
+{
+	return reinterpret_cast<const color::rgb*>(pixels_.data());
+}
+
+uint32_t gradient_row::length() const
+{
+	return length_;
+}
@@ -0,0 +1,76 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#pragma once
+
+#include <array>
+#include <stdint.h>
+#include <vector>
+
+#include "colors.h"
+
+///Color gradient lookup table. Table is built once (when gradient
+///palette advances), and then colors are just taken from it.
+///All calculations are performed using Q8.8 fixed point values.
+class gradient_lut
+{
+public:
+	static const uint32_t size = 256;
+	///Q8.8 weight value which is equal to 1.0
+	static const uint32_t weight_one = 256;
+
+	typedef std::array<color::rgb, size> table;
+
+public:
+	///Creates table filled with black color
+	gradient_lut();
+	///Creates table with gradient from color [from] to color [to]
+	gradient_lut(const color::rgb& from, const color::rgb& to);
+
+	///Rebuilds table with gradient from color [from] to color [to]
+	void build(const color::rgb& from, const color::rgb& to);
+
+	///Returns table color (0 is [from], size - 1 is [to])
+	const color::rgb& at(uint8_t index) const;
+
+	///Returns table color for current_step of step_count steps.
+	///current_step can be greater than step_count like in color::gradient().
+	const color::rgb& at(uint32_t step_count, uint32_t current_step) const;
+
+	///Returns Q8.8 weight of current_step of step_count steps
+	///(0 is [from], weight_one is [to]).
+	///current_step can be greater than step_count like in color::gradient().
+	static uint32_t get_weight(uint32_t step_count, uint32_t current_step);
+
+	///Interpolates colors using Q8.8 weight (0 to weight_one)
+	static color::rgb interpolate(const color::rgb& from, const color::rgb& to, uint32_t weight);
+
+private:
+	table table_;
+};
+
+///Fills row of fixed length with horizontal gradient. Weights of
+///each pixel are calculated once, rows are filled using SSE2 (if available).
+class gradient_row
+{
+public:
+	explicit gradient_row(uint32_t length);
+
+	/** Fills row with gradient
+	*   @param from First pixel color
+	*   @param to Last pixel color
+	*   @returns Row pixels (length() values) */
+	const color::rgb* fill(const color::rgb& from, const color::rgb& to);
+
+	///Returns row pixels filled by last fill() call
+	const color::rgb* data() const;
+
+	uint32_t length() const;
+
+private:
+	uint32_t length_;
+	//Q8.8 weights of [to] and [from] for each color component
+	std::vector<uint16_t> weights_;
+	std::vector<uint16_t> inverse_weights_;
+	std::vector<uint8_t> pixels_;
+};
@@ -0,0 +1,115 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#include "tile_layout.h"
+
+#include "canvas.h"
+#include "display.h"
+
+tile_layout::tile_layout()
+{
+	add_tile(0, 0, orientation::normal);
+}
+
+tile_layout tile_layout::make_grid(uint32_t columns, uint32_t rows, orientation tile_orientation)
+{
+	tile_layout layout;
+	layout.tiles_.clear();
+
+	const uint32_t tile_width = get_tile_width(tile_orientation);
+	const uint32_t tile_height = get_tile_height(tile_orientation);
+	for(uint32_t row = 0; row != rows; ++row)
+	{
+		for(uint32_t column = 0; column != columns; ++column)
+			layout.add_tile(column * tile_width, row * tile_height, tile_orientation);
+	}
+
+	return layout;
+}
+
+void tile_layout::add_tile(uint32_t x, uint32_t y, orientation tile_orientation)
+{
+	tiles_.push_back({ x, y, tile_orientation });
+}
+
+const std::vector<tile_layout::tile>& tile_layout::get_tiles() const
+{
+	return tiles_;
+}
+
+uint32_t tile_layout::get_canvas_width() const
+{
+	uint32_t width = 0;
+	for(const auto& t : tiles_)
+	{
+		const uint32_t right = t.x + get_tile_width(t.tile_orientation);
+		if(right > width)
+			width = right;
+	}
+
+	return width;
+}
+
+uint32_t tile_layout::get_canvas_height() const
+{
+	uint32_t height = 0;
+	for(const auto& t : tiles_)
+	{
+		const uint32_t bottom = t.y + get_tile_height(t.tile_orientation);
+		if(bottom > height)
+			height = bottom;
+	}
+
+	return height;
+}
+
+uint32_t tile_layout::get_tile_width(orientation tile_orientation)
+{
+	return tile_orientation == orientation::rotated_90 || tile_orientation == orientation::rotated_270
+		? display::display_height : display::display_width;
+}
+
+uint32_t tile_layout::get_tile_height(orientation tile_orientation)
+{
+	return tile_orientation == orientation::rotated_90 || tile_orientation == orientation::rotated_270
+		? display::display_width : display::display_height;
+}
+
+void tile_layout::extract_tile(const canvas& source, const tile& source_tile, display& target)
+{
+	static const uint32_t max_x = display::display_width - 1;
+	static const uint32_t max_y = display::display_height - 1;
+
+	for(uint8_t y = 0; y != display::display_height; ++y)
+	{
+		for(uint8_t x = 0; x != display::display_width; ++x)
+		{
+			//Canvas pixel of device display pixel [x; y]
+			uint32_t canvas_x = source_tile.x, canvas_y = source_tile.y;
+			switch(source_tile.tile_orientation)
+			{
+			case orientation::rotated_90:
+				canvas_x += max_y - y;
+				canvas_y += x;
+				break;
+
+			case orientation::rotated_180:
+				canvas_x += max_x - x;
+				canvas_y += max_y - y;
+				break;
+
+			case orientation::rotated_270:
+				canvas_x += y;
+				canvas_y += max_x - x;
+				break;
+
+			default:
+				canvas_x += x;
+				canvas_y += y;
+				break;
+			}
+
+			target.set_pixel(x, y, source.get_pixel(canvas_x, canvas_y));
+		}
+	}
+}
@@ -0,0 +1,65 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+class canvas;
+class display;
+
+///Describes how device displays (tiles) are placed on the canvas
+class tile_layout
+{
+public:
+	///Device display orientation on the canvas (clockwise rotation).
+	///Rotated by 90 or 270 degrees tile is display_height pixels wide
+	///and display_width pixels high.
+	enum class orientation
+	{
+		normal,
+		rotated_90,
+		rotated_180,
+		rotated_270
+	};
+
+	struct tile
+	{
+		///Canvas coordinates of tile top left pixel
+		uint32_t x;
+		uint32_t y;
+		orientation tile_orientation;
+	};
+
+public:
+	///Creates layout with single not rotated tile
+	tile_layout();
+
+	/** Creates layout of columns * rows tiles (left to right, top to bottom)
+	*   @param columns Number of tiles in each row
+	*   @param rows Number of tile rows
+	*   @param tile_orientation Orientation of all tiles */
+	static tile_layout make_grid(uint32_t columns, uint32_t rows,
+		orientation tile_orientation = orientation::normal);
+
+	///Adds tile to layout. Tiles should not overlap.
+	void add_tile(uint32_t x, uint32_t y, orientation tile_orientation);
+
+	const std::vector<tile>& get_tiles() const;
+
+	///Returns canvas size needed to contain all tiles
+	uint32_t get_canvas_width() const;
+	uint32_t get_canvas_height() const;
+
+	///Returns tile width on the canvas
+	static uint32_t get_tile_width(orientation tile_orientation);
+	///Returns tile height on the canvas
+	static uint32_t get_tile_height(orientation tile_orientation);
+
+	///Copies canvas pixels of tile to device display
+	static void extract_tile(const canvas& source, const tile& source_tile, display& target);
+
+private:
+	std::vector<tile> tiles_;
+};
@@ -0,0 +1,155 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#include "tiled_output.h"
+
+#include <stdexcept>
+
+#include "canvas.h"
+#include "display.h"
+#include "display_protocol.h"
+#include "uart.h"
+
+tiled_output::tiled_output(const tile_layout& layout, const std::vector<uart*>& com_ports)
+	: layout_(layout)
+	, com_ports_(com_ports)
+	, frame_(nullptr)
+	, frame_number_(0)
+	, flip_frame_number_(0)
+	, ready_count_(0)
+	, done_count_(0)
+	, byte_count_(0)
+	, encode_time_(std::chrono::steady_clock::duration::zero())
+	, failed_(false)
+	, stopping_(false)
+{
+	if(com_ports_.size() != layout_.get_tiles().size())
+		throw std::invalid_argument("Number of UARTs must be equal to number of tiles");
+
+	for(size_t i = 0; i != com_ports_.size(); ++i)
+		workers_.emplace_back(&tiled_output::worker, this, i);
+}
+
+tiled_output::~tiled_output()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopping_ = true;
+	}
+
+	workers_cv_.notify_all();
+	for(auto& worker : workers_)
+		worker.join();
+}
+
+std::chrono::steady_clock::duration tiled_output::get_last_encode_time() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return encode_time_;
+}
+
+const tile_layout& tiled_output::get_layout() const
+{
+	return layout_;
+}
+
+uint32_t tiled_output::send_frame(const canvas& frame)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	frame_ = &frame;
+	ready_count_ = 0;
+	done_count_ = 0;
+	byte_count_ = 0;
+	encode_time_ = std::chrono::steady_clock::duration::zero();
+	failed_ = false;
+	++frame_number_;
+	workers_cv_.notify_all();
+
+	sender_cv_.wait(lock, [this]() { return ready_count_ == workers_.size(); });
+
+	//All UARTs have transmitted the frame except the last byte, so devices will show it at about the same time
+	flip_frame_number_ = frame_number_;
+	workers_cv_.notify_all();
+
+	sender_cv_.wait(lock, [this]() { return done_count_ == workers_.size(); });
+	frame_ = nullptr;
+
+	if(failed_)
+		throw device_offline_exception();
+
+	return byte_count_;
+}
+
+void tiled_output::worker(size_t tile_index)
+{
+	const tile_layout::tile& source_tile = layout_.get_tiles()[tile_index];
+	uart& com_port = *com_ports_[tile_index];
+	uint64_t current_frame_number = 0;
+	display tile_data;
+
+	while(true)
+	{
+		const canvas* frame;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			workers_cv_.wait(lock, [&]() { return stopping_ || frame_number_ != current_frame_number; });
+			if(stopping_)
+				return;
+
+			current_frame_number = frame_number_;
+			frame = frame_;
+		}
+
+		bool succeeded = true;
+		std::vector<uint8_t> data_bytes;
+		std::chrono::steady_clock::duration encode_time = std::chrono::steady_clock::duration::zero();
+		try
+		{
+			const auto encode_start = std::chrono::steady_clock::now();
+			tile_layout::extract_tile(*frame, source_tile, tile_data);
+			data_bytes = display_protocol::encode(tile_data);
+			encode_time = std::chrono::steady_clock::now() - encode_start;
+			com_port.write_data(data_bytes.data(), static_cast<uint32_t>(data_bytes.size() - 1));
+			com_port.drain();
+		}
+		catch(const std::exception&)
+		{
+			succeeded = false;
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			failed_ = failed_ || !succeeded;
+			byte_count_ += static_cast<uint32_t>(data_bytes.size());
+			if(encode_time > encode_time_)
+				encode_time_ = encode_time;
+			++ready_count_;
+			sender_cv_.notify_one();
+
+			workers_cv_.wait(lock, [&]() { return stopping_ || flip_frame_number_ == current_frame_number; });
+			if(stopping_)
+				return;
+		}
+
+		if(succeeded)
+		{
+			try
+			{
+				com_port.write_byte(data_bytes.back());
+				display_protocol::wait_for_device(com_port);
+			}
+			catch(const std::exception&)
+			{
+				succeeded = false;
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			failed_ = failed_ || !succeeded;
+			++done_count_;
+		}
+
+		sender_cv_.notify_one();
+	}
+}
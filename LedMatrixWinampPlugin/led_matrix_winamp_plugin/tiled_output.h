@@ -0,0 +1,69 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+#include "tile_layout.h"
+
+class canvas;
+class uart;
+
+///Sends canvas tiles to several devices in parallel (one worker thread per UART).
+///Devices show the frame at about the same time: each UART transmits all
+///frame bytes except the last one, and last bytes are sent only when all
+///UARTs have transmitted the rest of the frame. Devices may still be receiving
+///the data (e.g. from USB adapter buffers), so this is best-effort.
+class tiled_output
+{
+public:
+	/** Creates output and starts workers
+	*   @param layout Tile layout
+	*   @param com_ports UART of each layout tile
+	*   @throw std::invalid_argument if number of UARTs is not equal to number of tiles */
+	tiled_output(const tile_layout& layout, const std::vector<uart*>& com_ports);
+	~tiled_output();
+
+	tiled_output(const tiled_output&) = delete;
+	tiled_output& operator=(const tiled_output&) = delete;
+
+	const tile_layout& get_layout() const;
+
+	/** Sends canvas to all devices and waits until all devices show it
+	*   @param frame Canvas to send (must be layout canvas size)
+	*   @returns Number of bytes sent to all devices
+	*   @throw device_offline_exception in case any device doesn't respond */
+	uint32_t send_frame(const canvas& frame);
+
+	///Returns time spent to encode the last frame
+	///(devices are encoded in parallel, so this is the longest one)
+	std::chrono::steady_clock::duration get_last_encode_time() const;
+
+private:
+	void worker(size_t tile_index);
+
+	tile_layout layout_;
+	std::vector<uart*> com_ports_;
+	std::vector<std::thread> workers_;
+
+	mutable std::mutex mutex_;
+	std::condition_variable workers_cv_;
+	std::condition_variable sender_cv_;
+	const canvas* frame_;
+	//Number of frame workers should send
+	uint64_t frame_number_;
+	//Number of frame workers should finish (send the last byte)
+	uint64_t flip_frame_number_;
+	uint32_t ready_count_;
+	uint32_t done_count_;
+	uint32_t byte_count_;
+	std::chrono::steady_clock::duration encode_time_;
+	bool failed_;
+	bool stopping_;
+};
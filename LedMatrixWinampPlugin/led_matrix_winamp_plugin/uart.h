@@ -20,14 +20,23 @@ public:
 	}
 };
 
-///Generalized UART class
+///Generalized UART class. On POSIX systems name may also be a path to pty
+///or existing file. Non-terminal outputs are write-only and acknowledge every read.
 class uart
 {
 public:
 	typedef std::set<std::wstring> uart_port_list;
 
+	enum class open_mode
+	{
+		///Open existing serial port (or pty, or file on POSIX systems)
+		device,
+		///Create or truncate regular file to write frames to (POSIX only)
+		output_file
+	};
+
 public:
-	explicit uart(const std::wstring& name, uint32_t baud_rate);
+	explicit uart(const std::wstring& name, uint32_t baud_rate, open_mode mode = open_mode::device);
 	~uart();
 
 	static uart_port_list get_available_ports();
@@ -36,6 +45,9 @@ public:
 	void write_data(const uint8_t* data, uint32_t size);
 	uint8_t read_byte();
 
+	///Waits until all written data is transmitted by the port
+	void drain();
+
 private:
 	void close();
 
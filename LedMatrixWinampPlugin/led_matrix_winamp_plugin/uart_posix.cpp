@@ -0,0 +1,223 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#include "uart.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <string>
+
+namespace
+{
+///Terminals are configured as serial ports, all other files
+///(regular files, FIFOs) are write-only data sinks. Sinks have
+///no device attached, so they report device ready byte on each read.
+const uint8_t sink_ready_byte = 0x78;
+
+std::string to_narrow(const std::wstring& value)
+{
+	std::string ret;
+	for(wchar_t c : value)
+		ret.push_back(static_cast<char>(c));
+
+	return ret;
+}
+
+speed_t get_speed(uint32_t baud_rate)
+{
+	switch(baud_rate)
+	{
+	case 9600:
+		return B9600;
+	case 19200:
+		return B19200;
+	case 38400:
+		return B38400;
+	case 57600:
+		return B57600;
+	case 115200:
+		return B115200;
+	case 230400:
+		return B230400;
+	default:
+		throw uart_exception("Unsupported baud rate");
+	}
+}
+} //namespace
+
+struct uart_impl
+{
+	uart_impl()
+		: fd(-1)
+		, is_terminal(false)
+		, attributes_set(false)
+	{
+	}
+
+	int fd;
+	bool is_terminal;
+	termios old_attributes;
+	bool attributes_set;
+};
+
+uart::uart(const std::wstring& name, uint32_t baud_rate, open_mode mode)
+{
+	try
+	{
+		impl_.reset(new uart_impl);
+
+		const std::string path = to_narrow(name);
+		if(mode == open_mode::output_file)
+		{
+			//Never create files in place of mistyped device names
+			if(!path.compare(0, 5, "/dev/"))
+				throw uart_exception("Output file must not be in /dev: " + path);
+
+			impl_->fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		}
+		else
+		{
+			impl_->fd = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+		}
+
+		if(impl_->fd == -1)
+			throw uart_exception("Unable to open " + path + ": " + ::strerror(errno));
+
+		impl_->is_terminal = ::isatty(impl_->fd) != 0;
+		if(impl_->is_terminal)
+		{
+			if(::tcgetattr(impl_->fd, &impl_->old_attributes))
+				throw uart_exception("Unable to get terminal attributes");
+
+			impl_->attributes_set = true;
+
+			termios attributes = impl_->old_attributes;
+			::cfmakeraw(&attributes);
+			attributes.c_cflag |= CLOCAL | CREAD;
+			attributes.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+			//Read returns after 1 second without data, like Windows implementation timeouts
+			attributes.c_cc[VMIN] = 0;
+			attributes.c_cc[VTIME] = 10;
+
+			const speed_t speed = get_speed(baud_rate);
+			if(::cfsetispeed(&attributes, speed) || ::cfsetospeed(&attributes, speed))
+				throw uart_exception("Unable to set baud rate");
+
+			if(::tcsetattr(impl_->fd, TCSANOW, &attributes))
+				throw uart_exception("Unable to set terminal attributes");
+
+			::tcflush(impl_->fd, TCIOFLUSH);
+		}
+	}
+	catch(const std::exception&)
+	{
+		close();
+		throw;
+	}
+}
+
+void uart::close()
+{
+	if(impl_->is_terminal)
+		::tcdrain(impl_->fd);
+
+	if(impl_->attributes_set)
+		::tcsetattr(impl_->fd, TCSANOW, &impl_->old_attributes);
+
+	if(impl_->fd != -1)
+		::close(impl_->fd);
+}
+
+uart::~uart()
+{
+	close();
+}
+
+uart::uart_port_list uart::get_available_ports()
+{
+	uart_port_list ret;
+
+	DIR* dir = ::opendir("/dev");
+	if(!dir)
+		throw uart_exception("Unable to list /dev directory");
+
+	static const char* const prefixes[] = { "ttyUSB", "ttyACM", "ttyS", "ttyAMA", "cu." };
+	while(const dirent* entry = ::readdir(dir))
+	{
+		for(const char* prefix : prefixes)
+		{
+			if(!::strncmp(entry->d_name, prefix, ::strlen(prefix)))
+			{
+				const std::string path = std::string("/dev/") + entry->d_name;
+				ret.insert(std::wstring(path.begin(), path.end()));
+				break;
+			}
+		}
+	}
+
+	::closedir(dir);
+	return ret;
+}
+
+void uart::write_byte(uint8_t byte)
+{
+	write_data(&byte, sizeof(byte));
+}
+
+uint8_t uart::read_byte()
+{
+	if(!impl_->is_terminal)
+		return sink_ready_byte;
+
+	uint8_t ret = 0;
+	ssize_t read = 0;
+	do
+	{
+		read = ::read(impl_->fd, &ret, sizeof(ret));
+	}
+	while(read == -1 && errno == EINTR);
+
+	if(read != sizeof(ret))
+		throw uart_exception("Unable to read byte");
+
+	return ret;
+}
+
+void uart::write_data(const uint8_t* data, uint32_t size)
+{
+	while(size)
+	{
+		const ssize_t written = ::write(impl_->fd, data, size);
+		if(written == -1)
+		{
+			if(errno == EINTR)
+				continue;
+
+			throw uart_exception("Unable to write byte");
+		}
+
+		data += written;
+		size -= static_cast<uint32_t>(written);
+	}
+}
+
+void uart::drain()
+{
+	if(!impl_->is_terminal)
+		return;
+
+	int result = 0;
+	do
+	{
+		result = ::tcdrain(impl_->fd);
+	}
+	while(result == -1 && errno == EINTR);
+
+	if(result)
+		throw uart_exception("Unable to drain terminal");
+}
@@ -24,12 +24,15 @@ struct uart_impl
 	bool something_sent;
 };
 
-uart::uart(const std::wstring& name, uint32_t baud_rate)
+uart::uart(const std::wstring& name, uint32_t baud_rate, open_mode mode)
 {
 	try
 	{
 		impl_.reset(new uart_impl);
 
+		if(mode != open_mode::device)
+			throw uart_exception("Output files are not supported");
+
 		impl_->com_handle = ::CreateFileW(name.c_str(), GENERIC_READ | GENERIC_WRITE, 0,
 			nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
 		if(impl_->com_handle == INVALID_HANDLE_VALUE)
@@ -203,4 +206,10 @@ void uart::write_data(const uint8_t* data, uint32_t size)
 	impl_->something_sent = true;
 	if(!::WriteFile(impl_->com_handle, data, size, &written, 0) || written != size)
 		throw uart_exception("Unable to write byte");
+}
+
+void uart::drain()
+{
+	if(!::FlushFileBuffers(impl_->com_handle))
+		throw uart_exception("Unable to drain COM port");
 }
\ No newline at end of file
@@ -13,6 +13,7 @@ namespace
 {
 int16_t cached_x = 0, cached_y = 0, cached_z = 0;
 bool swap_up_down_thresholds = false;
+bool manual_update = false;
 
 //Full 255 TCNT2 value.
 //As timer overflows in 0.01632 sec (16 MHz, prescaler = 1024),
@@ -27,25 +28,9 @@ constexpr int16_t speed_threshold = 45;
 
 void get_values_internal()
 {
-	if(TCNT2 > timer_threshold || bit_is_set(TIFR2, TOV2))
-	{
-		//Too much time elapsed, renew accelerometer values
-		//This operation takes approximately 320us = 0.00032 sec on 400Hz TWI
-		adxl345::get_values(cached_x, cached_y, cached_z);
-		if(cached_z < 0) //Device is upside down
-		{
-			cached_x = -cached_x;
-			cached_y = -cached_y;
-			swap_up_down_thresholds = true;
-		}
-		else
-		{
-			swap_up_down_thresholds = false;
-		}
-		
-		TCNT2 = 0;
-		TIFR2 |= _BV(TOV2); //Clear timer2 counter overflow (inversed bit)
-	}
+	int16_t x, y, z;
+	if(!manual_update && accelerometer::read_raw_values(x, y, z))
+		accelerometer::set_raw_values(x, y, z);
 }
 
 int8_t limit_speed(int16_t value)
@@ -129,6 +114,44 @@ int8_t accelerometer::get_y_speed()
 	return limit_speed(cached_y);
 }
 
+void accelerometer::set_manual_update(bool enable)
+{
+	manual_update = enable;
+}
+
+bool accelerometer::read_raw_values(int16_t& x, int16_t& y, int16_t& z)
+{
+	if(TCNT2 > timer_threshold || bit_is_set(TIFR2, TOV2))
+	{
+		//Too much time elapsed, renew accelerometer values
+		//This operation takes approximately 320us = 0.00032 sec on 400Hz TWI
+		adxl345::get_values(x, y, z);
+		
+		TCNT2 = 0;
+		TIFR2 |= _BV(TOV2); //Clear timer2 counter overflow (inversed bit)
+		return true;
+	}
+	
+	return false;
+}
+
+void accelerometer::set_raw_values(int16_t x, int16_t y, int16_t z)
+{
+	cached_x = x;
+	cached_y = y;
+	cached_z = z;
+	if(cached_z < 0) //Device is upside down
+	{
+		cached_x = -cached_x;
+		cached_y = -cached_y;
+		swap_up_down_thresholds = true;
+	}
+	else
+	{
+		swap_up_down_thresholds = false;
+	}
+}
+
 accelerometer::speed_action accelerometer::process_speed(speed_state& state, speed_type type)
 {
 	int8_t speed = type == speed_x ? get_x_speed() : get_y_speed();
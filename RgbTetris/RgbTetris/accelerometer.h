@@ -80,4 +80,16 @@ public:
 	*   @param speed X or Y speed direction
 	*   @returns Accelerometer movement event */
 	static speed_action process_speed(speed_state& state, speed_type speed);
+	
+	///Enables or disables manual update mode. In this mode accelerometer
+	///is not read automatically, and cached values are changed only by
+	///set_raw_values() calls.
+	static void set_manual_update(bool enable);
+	
+	///Reads raw adxl345 values if refresh period (~61 Hz) has elapsed.
+	///Returns false if values were not read.
+	static bool read_raw_values(int16_t& x, int16_t& y, int16_t& z);
+	
+	///Sets cached values, as if they were read from adxl345
+	static void set_raw_values(int16_t x, int16_t y, int16_t z);
 };
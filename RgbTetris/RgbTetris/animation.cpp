@@ -0,0 +1,48 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#include "animation.h"
+
+animation::animation()
+	:func_(nullptr),
+	context_(nullptr),
+	step_(0),
+	ticks_left_(0)
+{
+}
+
+void animation::start(step_function func, void* context)
+{
+	func_ = func;
+	context_ = context;
+	step_ = 0;
+	ticks_left_ = 0;
+}
+
+void animation::stop()
+{
+	func_ = nullptr;
+}
+
+bool animation::is_running() const
+{
+	return func_ != nullptr;
+}
+
+bool animation::tick()
+{
+	if(!func_)
+		return false;
+	
+	if(ticks_left_ && --ticks_left_)
+		return true;
+	
+	ticks_left_ = func_(step_++, context_);
+	if(!ticks_left_)
+	{
+		func_ = nullptr;
+		return false;
+	}
+	
+	return true;
+}
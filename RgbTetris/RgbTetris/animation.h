@@ -0,0 +1,38 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#pragma once
+
+#include <stdint.h>
+
+///Tick-driven animation. Animation is a sequence of steps drawn by step function,
+///each step is shown for specified number of timer ticks. Games call tick() once
+///per timer interrupt from their main loop, so input is still processed while
+///animation is running.
+class animation
+{
+public:
+	/** Draws animation step.
+	*   @param step Step index, starting from zero
+	*   @param context Context passed to start()
+	*   @returns Number of timer ticks to show this step, 0 to finish animation */
+	using step_function = uint16_t(*)(uint16_t step, void* context);
+	
+public:
+	animation();
+	
+	///Starts animation, first step is drawn on next tick() call
+	void start(step_function func, void* context);
+	void stop();
+	bool is_running() const;
+	
+	///Advances animation by one timer tick.
+	///Returns false if animation is finished.
+	bool tick();
+	
+private:
+	step_function func_;
+	void* context_;
+	uint16_t step_;
+	uint16_t ticks_left_;
+};
@@ -43,15 +43,15 @@ button_info info[buttons::btn_count] = {
 	{ _BV(BTN_DOWN_PIN), 0, repeat_disabled }
 };
 
-//This function is called on timer interrupt (see init())
-void on_interrupt()
+volatile bool manual_update = false;
+
+void update_states(uint8_t held_buttons)
 {
-	const uint8_t button_values = BTNS_PORT;
 	uint8_t state;
 	for(uint8_t i = 0; i != sizeof(info) / sizeof(info[0]); ++i)
 	{
 		state = info[i].button_state;
-		if((button_values & info[i].pin_mask) && (state != button_pressed))
+		if(!(held_buttons & (1 << i)) && (state != button_pressed))
 		{
 			state = 0;
 			if(info[i].button_press_counter != repeat_disabled)
@@ -83,6 +83,13 @@ void on_interrupt()
 		info[i].button_state = state;
 	}
 }
+
+//This function is called on timer interrupt (see init())
+void on_interrupt()
+{
+	if(!manual_update)
+		update_states(buttons::get_held_buttons());
+}
 } //namespace
 
 void buttons::enable_repeat(button_id id, bool enable)
@@ -110,6 +117,17 @@ bool buttons::is_pressed(button_id button)
 	return false;
 }
 
+bool buttons::is_any_pressed()
+{
+	for(uint8_t i = 0; i != btn_count; ++i)
+	{
+		if(is_pressed(static_cast<button_id>(i)))
+			return true;
+	}
+	
+	return false;
+}
+
 bool buttons::is_still_pressed(button_id button)
 {
 	if(info[button].button_state == button_pressed)
@@ -140,6 +158,30 @@ void buttons::flush_pressed()
 		info[i].button_state = button_press_processed;
 }
 
+uint8_t buttons::get_held_buttons()
+{
+	//Buttons are pulled up, held button pin is low
+	const uint8_t button_values = BTNS_PORT;
+	uint8_t held_buttons = 0;
+	for(uint8_t i = 0; i != sizeof(info) / sizeof(info[0]); ++i)
+	{
+		if(!(button_values & info[i].pin_mask))
+			held_buttons |= 1 << i;
+	}
+	
+	return held_buttons;
+}
+
+void buttons::set_manual_update(bool enable)
+{
+	manual_update = enable;
+}
+
+void buttons::update(uint8_t held_buttons)
+{
+	update_states(held_buttons);
+}
+
 void buttons::init()
 {
 	timer::on_interrupt(on_interrupt);
@@ -55,6 +55,9 @@ public:
 	///is released and pressed again.
 	static bool is_pressed(button_id id);
 	
+	///Returns true if any button was pressed (see is_pressed)
+	static bool is_any_pressed();
+	
 	///Returns true if button was pressed and still pressed.
 	///Next call this function will return true until button
 	///is released.
@@ -68,4 +71,17 @@ public:
 	
 	///Enables or disables press event repeat for specified button(s)
 	static void enable_repeat(uint8_t button_mask, bool enable);
+	
+	///Returns bitmap of buttons which are held down now
+	///(bit is set for each held button_id)
+	static uint8_t get_held_buttons();
+	
+	///Enables or disables manual update mode. In this mode button pins
+	///are not checked on timer interrupt, and button states are changed
+	///only by update() calls.
+	static void set_manual_update(bool enable);
+	
+	///Updates button states in manual update mode, as if timer
+	///interrupt occured with specified buttons held down
+	static void update(uint8_t held_buttons);
 };
@@ -0,0 +1,314 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "maze_grid.h"
+
+///Lazily generated maze, which is much larger than RAM allows to store.
+///Maze is split into square chunks. Each chunk is a depth-first search maze
+///generated from the maze seed and chunk coordinates, so it's the same each
+///time it's generated. Chunks are connected with each other by the binary
+///tree algorithm: each chunk has a single passage to its right or down
+///neighbour, so the whole maze is a spanning tree. Only a few recently used
+///chunks are kept in memory, others are generated again when needed.
+class chunked_maze
+{
+public:
+	static constexpr uint8_t max_size = 255;
+	static constexpr uint8_t chunk_size = 8;
+	//Display shows at most 2x2 chunks at once
+	static constexpr uint8_t cache_size = 6;
+	//Bytes chunk generation keeps on the stack (path and visited cells)
+	static constexpr uint8_t generation_stack = chunk_size * chunk_size + chunk_size;
+	
+public:
+	/** Sets maze size. Doesn't generate anything.
+	*   @param seed Maze seed
+	*   @param random_passage_probability Probability (0 - 128) to remove random
+	*   wall of a cell to create loops inside chunks */
+	void init(uint8_t width, uint8_t height, uint16_t seed, uint8_t random_passage_probability)
+	{
+		width_ = width;
+		height_ = height;
+		seed_ = seed;
+		random_passage_probability_ = random_passage_probability;
+		use_counter_ = 0;
+		last_slot_ = 0;
+		for(uint8_t i = 0; i != cache_size; ++i)
+			cache_[i].x = no_chunk;
+	}
+	
+	uint8_t get_width() const
+	{
+		return width_;
+	}
+	
+	uint8_t get_height() const
+	{
+		return height_;
+	}
+	
+	bool contains(uint8_t x, uint8_t y) const
+	{
+		return x < width_ && y < height_;
+	}
+	
+	///Cell must be inside the maze. Generates the chunk of the cell if it's not in memory.
+	bool has_wall(uint8_t x, uint8_t y, maze_grid::wall_position pos)
+	{
+		switch(pos)
+		{
+			case maze_grid::wall_up:
+				return !y || !has_down_passage(x, y - 1);
+			
+			case maze_grid::wall_down:
+				return !has_down_passage(x, y);
+			
+			case maze_grid::wall_left:
+				return !x || !has_right_passage(x - 1, y);
+			
+			default: //wall_right
+				return !has_right_passage(x, y);
+		}
+	}
+	
+private:
+	static constexpr uint8_t no_chunk = 0xff;
+	
+	enum link_direction : uint8_t
+	{
+		link_none,
+		link_right,
+		link_down
+	};
+	
+	struct chunk
+	{
+		uint8_t x;
+		uint8_t y;
+		//Value of use_counter_ when the chunk was used last time
+		uint8_t last_use;
+		//Bit X of row Y is set if there's no wall to the right of (below) the cell
+		uint8_t right_passages[chunk_size];
+		uint8_t down_passages[chunk_size];
+	};
+	
+	static uint32_t get_next_random(uint32_t& state)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+	
+	uint32_t get_chunk_random_state(uint8_t chunk_x, uint8_t chunk_y) const
+	{
+		uint32_t state = ((static_cast<uint32_t>(seed_) << 16) | (chunk_x << 8) | chunk_y) ^ 0x9e3779b9ul;
+		if(!state)
+			state = 1;
+		
+		//Mix bits of the seed and coordinates
+		for(uint8_t i = 0; i != 4; ++i)
+			get_next_random(state);
+		
+		return state;
+	}
+	
+	///Returns number of maze cells of the chunk along the dimension
+	static uint8_t get_chunk_cell_count(uint8_t chunk_coord, uint8_t maze_size)
+	{
+		const uint8_t left = maze_size - chunk_coord * chunk_size;
+		return left < chunk_size ? left : chunk_size;
+	}
+	
+	///Returns direction of passage from the chunk to its neighbour and passage position
+	///(row for the right neighbour, column for the down neighbour). Takes first random
+	///numbers of the chunk.
+	link_direction get_link(uint8_t chunk_x, uint8_t chunk_y, uint32_t& state, uint8_t& position) const
+	{
+		const bool last_column = chunk_x == (width_ - 1) / chunk_size;
+		const bool last_row = chunk_y == (height_ - 1) / chunk_size;
+		const uint32_t random = get_next_random(state);
+		link_direction direction;
+		if(last_column)
+			direction = last_row ? link_none : link_down;
+		else if(last_row)
+			direction = link_right;
+		else
+			direction = (random & 0x100) ? link_right : link_down;
+		
+		position = static_cast<uint8_t>(get_next_random(state) % (direction == link_right
+			? get_chunk_cell_count(chunk_y, height_) : get_chunk_cell_count(chunk_x, width_)));
+		return direction;
+	}
+	
+	bool has_link(uint8_t chunk_x, uint8_t chunk_y, link_direction direction, uint8_t position) const
+	{
+		uint32_t state = get_chunk_random_state(chunk_x, chunk_y);
+		uint8_t link_position;
+		return get_link(chunk_x, chunk_y, state, link_position) == direction && link_position == position;
+	}
+	
+	bool has_right_passage(uint8_t x, uint8_t y)
+	{
+		const uint8_t cell_x = x % chunk_size, cell_y = y % chunk_size;
+		if(cell_x == chunk_size - 1)
+			return x + 1 != width_ && has_link(x / chunk_size, y / chunk_size, link_right, cell_y);
+		
+		return get_chunk(x / chunk_size, y / chunk_size).right_passages[cell_y] & (1 << cell_x);
+	}
+	
+	bool has_down_passage(uint8_t x, uint8_t y)
+	{
+		const uint8_t cell_x = x % chunk_size, cell_y = y % chunk_size;
+		if(cell_y == chunk_size - 1)
+			return y + 1 != height_ && has_link(x / chunk_size, y / chunk_size, link_down, cell_x);
+		
+		return get_chunk(x / chunk_size, y / chunk_size).down_passages[cell_y] & (1 << cell_x);
+	}
+	
+	///Returns chunk from cache. If it's not there, replaces the least recently used chunk.
+	const chunk& get_chunk(uint8_t chunk_x, uint8_t chunk_y)
+	{
+		chunk* value = &cache_[last_slot_];
+		if(value->x == chunk_x && value->y == chunk_y)
+			return *value;
+		
+		uint8_t oldest_slot = 0, oldest_age = 0;
+		for(uint8_t i = 0; i != cache_size; ++i)
+		{
+			value = &cache_[i];
+			if(value->x == chunk_x && value->y == chunk_y)
+			{
+				value->last_use = use_counter_;
+				last_slot_ = i;
+				return *value;
+			}
+			
+			const uint8_t age = value->x == no_chunk ? UINT8_MAX
+				: static_cast<uint8_t>(use_counter_ - value->last_use);
+			if(age >= oldest_age)
+			{
+				oldest_age = age;
+				oldest_slot = i;
+			}
+		}
+		
+		value = &cache_[oldest_slot];
+		value->last_use = ++use_counter_;
+		last_slot_ = oldest_slot;
+		generate_chunk(*value, chunk_x, chunk_y);
+		return *value;
+	}
+	
+	///Depth-first search inside the chunk, then random passages
+	void generate_chunk(chunk& value, uint8_t chunk_x, uint8_t chunk_y) const
+	{
+		value.x = chunk_x;
+		value.y = chunk_y;
+		memset(value.right_passages, 0, sizeof(value.right_passages));
+		memset(value.down_passages, 0, sizeof(value.down_passages));
+		
+		const uint8_t width = get_chunk_cell_count(chunk_x, width_);
+		const uint8_t height = get_chunk_cell_count(chunk_y, height_);
+		uint32_t state = get_chunk_random_state(chunk_x, chunk_y);
+		uint8_t position;
+		get_link(chunk_x, chunk_y, state, position);
+		
+		//Stack of cells (x + y * chunk_size)
+		uint8_t path[chunk_size * chunk_size];
+		uint8_t visited[chunk_size] {};
+		uint8_t level = 0;
+		uint8_t x = get_next_random(state) % width, y = get_next_random(state) % height;
+		visited[y] |= 1 << x;
+		while(true)
+		{
+			uint8_t unvisited_directions[4];
+			uint8_t unvisited_directions_count = 0;
+			if(x && !(visited[y] & (1 << (x - 1))))
+				unvisited_directions[unvisited_directions_count++] = maze_grid::wall_left;
+			if(x + 1 != width && !(visited[y] & (1 << (x + 1))))
+				unvisited_directions[unvisited_directions_count++] = maze_grid::wall_right;
+			if(y && !(visited[y - 1] & (1 << x)))
+				unvisited_directions[unvisited_directions_count++] = maze_grid::wall_up;
+			if(y + 1 != height && !(visited[y + 1] & (1 << x)))
+				unvisited_directions[unvisited_directions_count++] = maze_grid::wall_down;
+			
+			if(!unvisited_directions_count)
+			{
+				//Backtrack
+				if(!level)
+					break;
+				
+				const uint8_t cell = path[--level];
+				x = cell % chunk_size;
+				y = cell / chunk_size;
+				continue;
+			}
+			
+			path[level++] = x + y * chunk_size;
+			remove_wall(value, x, y, unvisited_directions[get_next_random(state) % unvisited_directions_count]);
+			visited[y] |= 1 << x;
+		}
+		
+		if(!random_passage_probability_)
+			return;
+		
+		for(y = 0; y != height; ++y)
+		{
+			for(x = 0; x != width; ++x)
+			{
+				const uint32_t random = get_next_random(state);
+				if((random & 0x7f) >= random_passage_probability_)
+					continue;
+				
+				const maze_grid::wall_position wall = static_cast<maze_grid::wall_position>(1 << ((random >> 8) % 4));
+				if((wall == maze_grid::wall_left && !x) || (wall == maze_grid::wall_right && x + 1 == width)
+					|| (wall == maze_grid::wall_up && !y) || (wall == maze_grid::wall_down && y + 1 == height))
+				{
+					continue;
+				}
+				
+				uint8_t next_x = x, next_y = y;
+				remove_wall(value, next_x, next_y, wall);
+			}
+		}
+	}
+	
+	///Removes wall of the cell inside the chunk, moves coordinates to the neighbour cell
+	static void remove_wall(chunk& value, uint8_t& x, uint8_t& y, uint8_t wall)
+	{
+		switch(wall)
+		{
+			case maze_grid::wall_left:
+				value.right_passages[y] |= 1 << --x;
+				break;
+			
+			case maze_grid::wall_right:
+				value.right_passages[y] |= 1 << x++;
+				break;
+			
+			case maze_grid::wall_up:
+				value.down_passages[--y] |= 1 << x;
+				break;
+			
+			default: //wall_down
+				value.down_passages[y++] |= 1 << x;
+				break;
+		}
+	}
+	
+private:
+	uint8_t width_;
+	uint8_t height_;
+	uint16_t seed_;
+	uint8_t random_passage_probability_;
+	//Incremented each time a chunk is generated
+	uint8_t use_counter_;
+	uint8_t last_slot_;
+	chunk cache_[cache_size];
+};
@@ -0,0 +1,117 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "util.h"
+
+///Fixed-capacity pool of game entities (bullets, etc.). Active slots are tracked
+///with a bitmask, so a free slot is allocated without scanning entries, and
+///iteration visits active slots only (in slot order).
+/** Iteration example (slot may be released inside the loop):
+*   for(uint8_t i = pool.first_active(); i != pool.no_slot; i = pool.next_active(i))
+*       pool[i]... */
+template<typename T, uint8_t Capacity>
+class entity_pool
+{
+	static_assert(Capacity && Capacity <= 16, "Active slots must fit into 16-bit mask");
+	
+public:
+	using mask_type = util::conditional_t<(Capacity > 8), uint16_t, uint8_t>;
+	
+	static constexpr uint8_t capacity = Capacity;
+	static constexpr uint8_t no_slot = 0xff;
+	static constexpr mask_type full_mask = static_cast<mask_type>((1ul << Capacity) - 1);
+	
+public:
+	entity_pool()
+		:active_(0)
+	{
+		memset(entities_, 0, sizeof(entities_));
+	}
+	
+	///Activates the first free slot. Returns its index or no_slot if pool is full.
+	uint8_t allocate()
+	{
+		if(active_ == full_mask)
+			return no_slot;
+		
+		const uint8_t index = find_first_set(static_cast<mask_type>(~active_));
+		active_ |= static_cast<mask_type>(1 << index);
+		return index;
+	}
+	
+	void release(uint8_t index)
+	{
+		active_ &= static_cast<mask_type>(~(1 << index));
+	}
+	
+	void clear()
+	{
+		active_ = 0;
+	}
+	
+	bool is_active(uint8_t index) const
+	{
+		return active_ & (1 << index);
+	}
+	
+	bool is_full() const
+	{
+		return active_ == full_mask;
+	}
+	
+	bool is_empty() const
+	{
+		return !active_;
+	}
+	
+	///Returns index of the first active slot or no_slot
+	uint8_t first_active() const
+	{
+		return active_ ? find_first_set(active_) : no_slot;
+	}
+	
+	///Returns index of the next active slot after the slot or no_slot
+	uint8_t next_active(uint8_t index) const
+	{
+		const mask_type next = static_cast<mask_type>(active_ >> ++index);
+		return next ? index + find_first_set(next) : no_slot;
+	}
+	
+	T& operator[](uint8_t index)
+	{
+		return entities_[index];
+	}
+	
+	const T& operator[](uint8_t index) const
+	{
+		return entities_[index];
+	}
+	
+private:
+	///Returns index of the lowest set bit, mask must not be zero
+	static uint8_t find_first_set(mask_type mask)
+	{
+		//Isolate the lowest set bit, then find its index with binary search
+		const mask_type bit = static_cast<mask_type>(mask & (~mask + 1));
+		uint8_t index = 0;
+		if(Capacity > 8 && (bit & static_cast<mask_type>(0xff00)))
+			index += 8;
+		if(bit & static_cast<mask_type>(0xf0f0))
+			index += 4;
+		if(bit & static_cast<mask_type>(0xcccc))
+			index += 2;
+		if(bit & static_cast<mask_type>(0xaaaa))
+			index += 1;
+		
+		return index;
+	}
+	
+private:
+	mask_type active_;
+	T entities_[Capacity];
+};
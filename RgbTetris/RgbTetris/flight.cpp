@@ -4,7 +4,6 @@
 #include "flight.h"
 
 #include <stdlib.h>
-#include <string.h>
 
 #include <avr/pgmspace.h>
 
@@ -12,6 +11,7 @@
 #include "buttons.h"
 #include "game.h"
 #include "colors.h"
+#include "entity_pool.h"
 #include "move_helper.h"
 #include "number_display.h"
 #include "options.h"
@@ -63,15 +63,101 @@ void load_level(level& lvl, uint32_t score, uint8_t& target_difficulty_counter)
 	}
 }
 
+///Playfield row
+struct world_row
+{
+	uint8_t left_wall_size : 4;
+	uint8_t right_wall_size : 4;
+	//Bit X is set if there's asteroid in column X
+	uint16_t asteroids;
+	color::rgb wall_color;
+};
+
+///Scrolling playfield (walls and asteroids). Rows are kept in a ring buffer,
+///so scrolling the world down doesn't move any data. Ship and bullets are not
+///a part of the world, the framebuffer is composed when it's going to be shown.
+struct world
+{
+	world()
+		:head(0)
+	{
+	}
+	
+	///Returns row by its Y coordinate on the display
+	world_row& get_row(uint8_t y)
+	{
+		uint8_t index = head + y;
+		if(index >= ws2812_matrix::height)
+			index -= ws2812_matrix::height;
+		
+		return rows[index];
+	}
+	
+	const world_row& get_row(uint8_t y) const
+	{
+		return const_cast<world*>(this)->get_row(y);
+	}
+	
+	///Moves all rows down, the bottom row becomes the top one
+	world_row& scroll()
+	{
+		if(++head == ws2812_matrix::height)
+			head = 0;
+		
+		return get_row(ws2812_matrix::height - 1);
+	}
+	
+	//Ring buffer index of the bottom row
+	uint8_t head;
+	world_row rows[ws2812_matrix::height];
+};
+
+constexpr uint16_t full_row_mask = (1u << ws2812_matrix::width) - 1;
+
+uint16_t get_wall_mask(const world_row& row)
+{
+	return ((1u << row.left_wall_size) - 1)
+		| (full_row_mask & ~((1u << (ws2812_matrix::width - row.right_wall_size)) - 1));
+}
+
+///Returns mask of occupied (by walls or asteroids) columns of the row
+uint16_t get_occupied_mask(const world& w, uint8_t y)
+{
+	const world_row& row = w.get_row(y);
+	return get_wall_mask(row) | row.asteroids;
+}
+
+void init_row(world_row& row, uint8_t left_wall_size, uint8_t right_wall_size, const color::rgb& wall_color)
+{
+	row.left_wall_size = left_wall_size;
+	row.right_wall_size = right_wall_size;
+	row.asteroids = 0;
+	row.wall_color = wall_color;
+}
+
+void draw_world(const world& w, const color::rgb& asteroid_color)
+{
+	for(uint8_t y = 0; y != ws2812_matrix::height; ++y)
+	{
+		const world_row& row = w.get_row(y);
+		const uint16_t walls = get_wall_mask(row);
+		for(uint8_t x = 0; x != ws2812_matrix::width; ++x)
+		{
+			const uint16_t bit = 1u << x;
+			const color::rgb& rgb = (walls & bit) ? row.wall_color
+				: ((row.asteroids & bit) ? asteroid_color : color::rgb { 0, 0, 0 });
+			ws2812_matrix::set_pixel_color_fast(x, y, rgb.r, rgb.g, rgb.b);
+		}
+	}
+}
+
 //Ship picture:
 /* 010 *
 *  111 */
-bool ship_intersects(uint8_t x, uint8_t y)
+bool ship_intersects(const world& w, uint8_t x, uint8_t y)
 {
-	return ws2812_matrix::is_on(x, y)
-		|| ws2812_matrix::is_on(x + 1, y)
-		|| ws2812_matrix::is_on(x + 2, y)
-		|| ws2812_matrix::is_on(x + 1, y + 1);
+	return ((get_occupied_mask(w, y) >> x) & 0b111)
+		|| ((get_occupied_mask(w, y + 1) >> (x + 1)) & 1);
 }
 
 void draw_ship(uint8_t x, uint8_t y,
@@ -83,43 +169,43 @@ void draw_ship(uint8_t x, uint8_t y,
 	ws2812_matrix::set_pixel_color(x + 1, y + 1, front_color);
 }
 
-void clear_ship(uint8_t x, uint8_t y)
+///Returns index of set bit with specified rank (0 is the lowest set bit)
+uint8_t select_set_bit(uint16_t mask, uint8_t rank)
 {
-	color::rgb black { 0, 0, 0 };
-	draw_ship(x, y, black, black);
+	uint8_t x = 0;
+	const uint8_t low_count = util::count_bits(static_cast<uint8_t>(mask));
+	if(rank >= low_count)
+	{
+		rank -= low_count;
+		mask >>= 8;
+		x = 8;
+	}
+	
+	for(;; ++x, mask >>= 1)
+	{
+		if((mask & 1) && !rank--)
+			return x;
+	}
 }
 
-void spawn_asteroid(uint8_t left_wall_size, uint8_t right_wall_size, const color::rgb& rgb)
+void spawn_asteroid(world& w, uint8_t left_wall_size, uint8_t right_wall_size)
 {
 	if(rand() % max_probability > asteroid_spawn_probability)
 		return;
 	
-	uint8_t available_x_coords[ws2812_matrix::width - 2];
-	uint8_t coord_count = 0;
-	for(uint8_t x = left_wall_size + 1; x != ws2812_matrix::width - right_wall_size - 1; ++x)
-	{
-		bool ok = true;
-		for(uint8_t y = ws2812_matrix::height - 1; y != ws2812_matrix::height - 5; --y)
-		{
-			if(ws2812_matrix::is_on(x, y) || ws2812_matrix::is_on(x - 1, y) || ws2812_matrix::is_on(x + 1, y))
-			{
-				ok = false;
-				break;
-			}
-		}
-		
-		if(ok)
-		{
-			available_x_coords[coord_count] = x;
-			++coord_count;
-		}
-	}
+	//Asteroid must not touch walls and other asteroids in the top 4 rows
+	uint16_t occupied = 0;
+	for(uint8_t y = ws2812_matrix::height - 1; y != ws2812_matrix::height - 5; --y)
+		occupied |= get_occupied_mask(w, y);
 	
+	//Columns not adjacent to the walls of the top row
+	const uint16_t columns = ((1u << (ws2812_matrix::width - right_wall_size - 1)) - 1)
+		& ~((1u << (left_wall_size + 1)) - 1);
+	const uint16_t available = columns & ~(occupied | (occupied << 1) | (occupied >> 1));
+	const uint8_t coord_count = util::count_bits(static_cast<uint8_t>(available))
+		+ util::count_bits(static_cast<uint8_t>(available >> 8));
 	if(coord_count)
-	{
-		ws2812_matrix::set_pixel_color(available_x_coords[rand() % coord_count],
-			ws2812_matrix::height - 1, rgb);
-	}
+		w.get_row(ws2812_matrix::height - 1).asteroids |= 1u << select_set_bit(available, rand() % coord_count);
 }
 
 constexpr uint8_t max_bullets = 4;
@@ -128,83 +214,69 @@ constexpr uint8_t target_bullet_counter = 30;
 struct bullet
 {
 	util::coord coords;
-	bool active;
 };
 
+using bullet_pool = entity_pool<bullet, max_bullets>;
+
 struct bullet_info
 {
 	bullet_info()
-		: bullet_counter(0),
-		bullet_count(0)
+		: bullet_counter(0)
 	{
-		memset(bullets, 0, sizeof(bullets));
 	}
 	
 	uint8_t bullet_counter;
-	uint8_t bullet_count;
-	bullet bullets[max_bullets];
+	bullet_pool bullets;
 };
 
-bool add_bullet(uint8_t x, uint8_t y, bullet_info& info)
+bool add_bullet(uint8_t x, uint8_t y, bullet_info& info, const world& w)
 {
-	if(info.bullet_counter || info.bullet_count == max_bullets)
+	//Ship is at the top, no room for a bullet
+	if(info.bullet_counter || y >= ws2812_matrix::height)
 		return false;
 	
 	//Check if wall is ahead
-	if(ws2812_matrix::is_on(x, y) && (ws2812_matrix::is_on(x + 1, y) || ws2812_matrix::is_on(x - 1, y)))
+	if(get_wall_mask(w.get_row(y)) & (1u << x))
 		return false;
 	
-	for(uint8_t i = 0; i != max_bullets; ++i)
-	{
-		auto& bullet = info.bullets[i];
-		if(bullet.active)
-			continue;
-			
-		bullet.coords.x = x;
-		bullet.coords.y = y;
-		bullet.active = true;
-		break;
-	}
+	const uint8_t index = info.bullets.allocate();
+	if(index == bullet_pool::no_slot)
+		return false;
+	
+	auto& bullet = info.bullets[index];
+	bullet.coords.x = x;
+	bullet.coords.y = y;
 	
-	++info.bullet_count;
 	info.bullet_counter = target_bullet_counter;
 	return true;
 }
 
 void draw_bullets(const bullet_info& info, const color::rgb& rgb)
 {
-	for(uint8_t i = 0; i != max_bullets; ++i)
-	{
-		auto& bullet = info.bullets[i];
-		if(!bullet.active)
-			continue;
-		
-		ws2812_matrix::set_pixel_color(bullet.coords, rgb);
-	}
+	for(uint8_t i = info.bullets.first_active(); i != bullet_pool::no_slot; i = info.bullets.next_active(i))
+		ws2812_matrix::set_pixel_color(info.bullets[i].coords, rgb);
 }
 
-bool calculate_bullets(bullet_info& info, uint32_t& score, uint8_t multiplier)
+bool calculate_bullets(bullet_info& info, world& w, uint32_t& score, uint8_t multiplier)
 {
 	bool score_changed = false;
-	for(uint8_t i = 0; i != max_bullets; ++i)
+	for(uint8_t i = info.bullets.first_active(); i != bullet_pool::no_slot; i = info.bullets.next_active(i))
 	{
-		auto& bullet = info.bullets[i];
-		if(!bullet.active)
-			continue;
+		const auto& bullet = info.bullets[i];
+		world_row& row = w.get_row(bullet.coords.y);
+		const uint16_t bit = 1u << bullet.coords.x;
 		
 		//Check if asteroid or wall is ahead
-		if(ws2812_matrix::is_on(bullet.coords))
+		if(row.asteroids & bit)
 		{
-			bullet.active = false;
-			--info.bullet_count;
-			if(!ws2812_matrix::is_on(bullet.coords.x + 1, bullet.coords.y)
-				&& !ws2812_matrix::is_on(bullet.coords.x - 1, bullet.coords.y))
-			{
-				//Asteroid hit
-				ws2812_matrix::clear_pixel(bullet.coords);
-				score += multiplier;
-				score_changed = true;
-			}
+			info.bullets.release(i);
+			row.asteroids &= ~bit;
+			score += multiplier;
+			score_changed = true;
+		}
+		else if(get_wall_mask(row) & bit)
+		{
+			info.bullets.release(i);
 		}
 	}
 	
@@ -213,17 +285,10 @@ bool calculate_bullets(bullet_info& info, uint32_t& score, uint8_t multiplier)
 
 void move_bullets(bullet_info& info)
 {
-	for(uint8_t i = 0; i != max_bullets; ++i)
+	for(uint8_t i = info.bullets.first_active(); i != bullet_pool::no_slot; i = info.bullets.next_active(i))
 	{
-		auto& bullet = info.bullets[i];
-		if(!bullet.active)
-			continue;
-		
-		if(++bullet.coords.y == ws2812_matrix::height)
-		{
-			bullet.active = false;
-			--info.bullet_count;
-		}
+		if(++info.bullets[i].coords.y == ws2812_matrix::height)
+			info.bullets.release(i);
 	}
 }
 
@@ -253,11 +318,9 @@ uint32_t loop()
 	bool need_check_bullets = false;
 	uint8_t bullet_move_counter = 0;
 	
+	world w;
 	for(uint8_t i = 0; i != ws2812_matrix::height; ++i)
-	{
-		ws2812_matrix::set_pixel_color(0, i, prev_color);
-		ws2812_matrix::set_pixel_color(ws2812_matrix::width - 1, i, prev_color);
-	}
+		init_row(w.get_row(i), left_wall_size, right_wall_size, prev_color);
 	
 	uint8_t ship_x = (ws2812_matrix::width - ship_width) / 2;
 	uint8_t ship_y = 0;
@@ -273,7 +336,6 @@ uint32_t loop()
 	color::rgb back_color(ship_back_color);
 	color::scale_to_brightness(front_color, max_brightness);
 	color::scale_to_brightness(back_color, max_brightness);
-	draw_ship(ship_x, ship_y, front_color, back_color);
 	
 	color::rgb current_bullet_color(bullet_color);
 	color::rgb current_asteroid_color(asteroid_color);
@@ -284,15 +346,13 @@ uint32_t loop()
 	{
 		timer::wait_for_interrupt();
 		
-		draw_bullets(bullets, { 0, 0, 0 });
 		if(++difficulty_counter == target_difficulty_counter)
 		{
 			difficulty_counter = 0;
 			need_check_bullets = true;
 			
-			clear_ship(ship_x, ship_y);
-			ws2812_matrix::shift_down();
-			if(ship_intersects(ship_x, ship_y))
+			world_row& top_row = w.scroll();
+			if(ship_intersects(w, ship_x, ship_y))
 				return result_score; //Game over
 				
 			color::gradient(prev_color, current_color,
@@ -305,14 +365,8 @@ uint32_t loop()
 				game::get_random_color(current_color, max_brightness);
 			}
 			
-			for(uint8_t x = 0; x != ws2812_matrix::width; ++x)
-			{
-				if(x < left_wall_size || x >= ws2812_matrix::width - right_wall_size)
-					ws2812_matrix::set_pixel_color(x, ws2812_matrix::height - 1, rgb);
-			}
-			
-			spawn_asteroid(left_wall_size, right_wall_size, current_asteroid_color);
-			draw_ship(ship_x, ship_y, front_color, back_color);
+			init_row(top_row, left_wall_size, right_wall_size, rgb);
+			spawn_asteroid(w, left_wall_size, right_wall_size);
 			
 			temp_score += current_level.score_multiplier;
 			prev_result_score = result_score;
@@ -393,28 +447,26 @@ uint32_t loop()
 			}
 		}
 		
-		clear_ship(ship_x, ship_y);
-		
 		move_dir = move_helper::process_speed(&x_speed_state, &y_speed_state, accelerometer_enabled);
 		if(move_dir & move_direction_left)
 		{
-			if(ship_x < ws2812_matrix::width - ship_width && !ship_intersects(new_x + 1, new_y))
+			if(ship_x < ws2812_matrix::width - ship_width && !ship_intersects(w, new_x + 1, new_y))
 				++new_x;
 		}	
 		else if(move_dir & move_direction_right)
 		{
-			if(ship_x && !ship_intersects(new_x - 1, new_y))
+			if(ship_x && !ship_intersects(w, new_x - 1, new_y))
 				--new_x;
 		}
 			
 		if(move_dir & move_direction_up)
 		{
-			if(ship_y < ws2812_matrix::height - ship_height && !ship_intersects(new_x, new_y + 1))
+			if(ship_y < ws2812_matrix::height - ship_height && !ship_intersects(w, new_x, new_y + 1))
 				++new_y;
 		}
 		else if(move_dir & move_direction_down)
 		{
-			if(ship_y && !ship_intersects(new_x, new_y - 1))
+			if(ship_y && !ship_intersects(w, new_x, new_y - 1))
 				--new_y;
 		}
 		
@@ -425,8 +477,6 @@ uint32_t loop()
 			ship_y = new_y;
 		}
 		
-		draw_ship(ship_x, ship_y, front_color, back_color);
-		
 		if(bullets.bullet_counter)
 			--bullets.bullet_counter;
 		
@@ -434,7 +484,7 @@ uint32_t loop()
 		auto button_down_state = buttons::get_button_status(buttons::button_down);
 		if(button_up_state == buttons::button_status_pressed) //Shoot
 		{
-			if(add_bullet(ship_x + 1, ship_y + 2, bullets))
+			if(add_bullet(ship_x + 1, ship_y + 2, bullets, w))
 				need_check_bullets = true;
 		}
 		else if(button_up_state == buttons::button_status_still_pressed
@@ -461,7 +511,7 @@ uint32_t loop()
 		{
 			need_check_bullets = false;
 			need_redraw = true;
-			if(calculate_bullets(bullets, result_score, current_level.score_multiplier))
+			if(calculate_bullets(bullets, w, result_score, current_level.score_multiplier))
 			{
 				number_display::output_number(result_score);
 				temp_score = result_score * 8;
@@ -470,6 +520,8 @@ uint32_t loop()
 		
 		if(need_redraw)
 		{
+			draw_world(w, current_asteroid_color);
+			draw_ship(ship_x, ship_y, front_color, back_color);
 			draw_bullets(bullets, current_bullet_color);
 			
 			need_redraw = false;
@@ -11,15 +11,18 @@
 #include "buttons.h"
 #include "colors.h"
 #include "effect.h"
+#include "input_recorder.h"
 #include "number_display.h"
 #include "options.h"
 #include "queue.h"
+#include "timer.h"
 #include "util.h"
 #include "ws2812_matrix.h"
 
 namespace
 {
 constexpr uint8_t vertical_text_shift = ws2812_matrix::height > 16 ? 9 : 4;
+constexpr uint16_t pause_step_ticks = timer::ms_to_ticks(25);
 } //namespace
 
 void game::intro()
@@ -45,7 +48,9 @@ void game::end(uint32_t score, game_id id)
 	
 	char buf[24];
 	
-	if(score > options::get_high_score(id))
+	//Replayed sessions don't change high scores
+	if(score > options::get_high_score(id)
+		&& input_recorder::get_mode() != input_recorder::mode_replay)
 	{
 		options::set_high_score(id, score);
 		strcpy_P(buf, PSTR("NEW HIGH SCORE: "));
@@ -130,7 +135,7 @@ bool interruptible_demo()
 			if(pixel_queue.pop_front(coord))
 			{
 				smallest_coord next_coord;
-						
+				
 				bool clear = true;
 				uint8_t i = 0;
 				while(pixel_queue.get(next_coord, i++))
@@ -165,7 +170,10 @@ bool interruptible_demo()
 		else if(buttons::is_pressed(buttons::button_left))
 			return false;
 		
-		util::delay(100);
+		//Wait for timer ticks (not busy delay), so input recorder
+		//can update buttons (see input_recorder.h)
+		for(uint16_t i = 0; i != pause_step_ticks; ++i)
+			timer::wait_for_interrupt();
 	}
 }
 
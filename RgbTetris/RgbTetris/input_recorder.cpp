@@ -0,0 +1,251 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#include "input_recorder.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "accelerometer.h"
+#include "buttons.h"
+#include "options.h"
+#include "timer.h"
+
+namespace
+{
+constexpr uint8_t max_idle_frames = 0x7f;
+constexpr uint8_t input_changed_flag = 0x80;
+constexpr uint8_t accel_changed_flag = 0x40;
+constexpr uint8_t held_buttons_mask = 0x3f;
+constexpr uint8_t accelerometer_enabled_flag = 0x01;
+constexpr uint8_t axis_count = 3;
+
+static_assert(buttons::btn_count <= 6, "Held buttons must fit into held_buttons_mask");
+
+input_recorder::mode current_mode = input_recorder::mode_off;
+input_recorder::write_function write_byte = nullptr;
+input_recorder::read_function read_byte = nullptr;
+
+//Last recorded or replayed input
+uint8_t held_buttons = 0;
+int8_t axes[axis_count] = {};
+//Frames without input changes (not yet written when recording, left to replay when replaying)
+uint8_t idle_frames = 0;
+bool accelerometer_enabled = false;
+bool replay_finished = false;
+
+int8_t quantize(int16_t value)
+{
+	value /= input_recorder::accel_quantum;
+	if(value > INT8_MAX)
+		return INT8_MAX;
+	if(value < INT8_MIN)
+		return INT8_MIN;
+	
+	return static_cast<int8_t>(value);
+}
+
+void apply_input(bool axes_changed)
+{
+	buttons::update(held_buttons);
+	if(axes_changed)
+	{
+		accelerometer::set_raw_values(axes[0] * input_recorder::accel_quantum,
+			axes[1] * input_recorder::accel_quantum, axes[2] * input_recorder::accel_quantum);
+	}
+}
+
+void flush_idle_frames()
+{
+	if(idle_frames)
+	{
+		write_byte(idle_frames);
+		idle_frames = 0;
+	}
+}
+
+void record_frame()
+{
+	const uint8_t new_held_buttons = buttons::get_held_buttons() & held_buttons_mask;
+	uint8_t changed_axes = 0;
+	int16_t values[axis_count];
+	if(accelerometer_enabled && accelerometer::read_raw_values(values[0], values[1], values[2]))
+	{
+		for(uint8_t i = 0; i != axis_count; ++i)
+		{
+			const int8_t value = quantize(values[i]);
+			if(value != axes[i])
+			{
+				axes[i] = value;
+				changed_axes |= 1 << i;
+			}
+		}
+	}
+	
+	if(new_held_buttons != held_buttons || changed_axes)
+	{
+		flush_idle_frames();
+		held_buttons = new_held_buttons;
+		write_byte(input_changed_flag | (changed_axes ? accel_changed_flag : 0) | held_buttons);
+		if(changed_axes)
+		{
+			write_byte(changed_axes);
+			for(uint8_t i = 0; i != axis_count; ++i)
+			{
+				if(changed_axes & (1 << i))
+					write_byte(static_cast<uint8_t>(axes[i]));
+			}
+		}
+	}
+	else if(++idle_frames == max_idle_frames)
+	{
+		flush_idle_frames();
+	}
+	
+	apply_input(changed_axes);
+}
+
+void finish_replay()
+{
+	replay_finished = true;
+	held_buttons = 0;
+}
+
+void replay_frame()
+{
+	bool axes_changed = false;
+	uint8_t value;
+	if(idle_frames)
+	{
+		--idle_frames;
+	}
+	else if(!replay_finished)
+	{
+		if(!read_byte(value) || value == input_recorder::end_of_session)
+		{
+			finish_replay();
+		}
+		else if(!(value & input_changed_flag))
+		{
+			idle_frames = value - 1;
+		}
+		else
+		{
+			held_buttons = value & held_buttons_mask;
+			if(value & accel_changed_flag)
+			{
+				uint8_t changed_axes;
+				if(!read_byte(changed_axes))
+				{
+					finish_replay();
+				}
+				else
+				{
+					for(uint8_t i = 0; i != axis_count; ++i)
+					{
+						if((changed_axes & (1 << i)) && read_byte(value))
+							axes[i] = static_cast<int8_t>(value);
+					}
+					
+					axes_changed = true;
+				}
+			}
+		}
+	}
+	
+	apply_input(axes_changed);
+}
+
+void on_frame()
+{
+	if(current_mode == input_recorder::mode_record)
+		record_frame();
+	else
+		replay_frame();
+}
+
+//Input state is reset in the same way on both recording and replay start
+void start(input_recorder::mode mode)
+{
+	current_mode = mode;
+	held_buttons = 0;
+	idle_frames = 0;
+	replay_finished = false;
+	for(uint8_t i = 0; i != axis_count; ++i)
+		axes[i] = 0;
+	
+	buttons::set_manual_update(true);
+	accelerometer::set_manual_update(true);
+	accelerometer::set_raw_values(0, 0, 0);
+	timer::on_wait(on_frame);
+}
+} //namespace
+
+void input_recorder::start_recording(game::game_id id, write_function write)
+{
+	const uint16_t seed = rand();
+	srand(seed);
+	
+	write_byte = write;
+	accelerometer_enabled = options::is_accelerometer_enabled();
+	
+	write_byte(session_signature);
+	write_byte(id);
+	write_byte(static_cast<uint8_t>(seed));
+	write_byte(static_cast<uint8_t>(seed >> 8));
+	write_byte(accelerometer_enabled ? accelerometer_enabled_flag : 0);
+	write_byte(options::get_max_brightness());
+	
+	start(mode_record);
+}
+
+bool input_recorder::start_replay(game::game_id& id, read_function read)
+{
+	uint8_t header[6];
+	for(uint8_t i = 0; i != sizeof(header); ++i)
+	{
+		if(!read(header[i]))
+			return false;
+	}
+	
+	if(header[0] != session_signature || header[1] >= game::max_game_id)
+		return false;
+	
+	id = static_cast<game::game_id>(header[1]);
+	srand(header[2] | (static_cast<uint16_t>(header[3]) << 8));
+	
+	read_byte = read;
+	accelerometer_enabled = header[4] & accelerometer_enabled_flag;
+	
+	options::set_overrides(header[5], accelerometer_enabled);
+	
+	start(mode_replay);
+	return true;
+}
+
+void input_recorder::stop()
+{
+	if(current_mode == mode_off)
+		return;
+	
+	timer::on_wait(nullptr);
+	buttons::set_manual_update(false);
+	accelerometer::set_manual_update(false);
+	
+	if(current_mode == mode_record)
+	{
+		flush_idle_frames();
+		write_byte(end_of_session);
+	}
+	else
+	{
+		options::clear_overrides();
+	}
+	
+	current_mode = mode_off;
+}
+
+input_recorder::mode input_recorder::get_mode()
+{
+	return current_mode;
+}
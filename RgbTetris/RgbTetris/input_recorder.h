@@ -0,0 +1,61 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#pragma once
+
+#include <stdint.h>
+
+#include "game.h"
+#include "static_class.h"
+
+///Records game session input (random seed, buttons and accelerometer) to a byte
+///stream and replays it, so the session re-runs frame-exactly. Frame is a single
+///timer::wait_for_interrupt() call: while recorder is active, buttons and
+///accelerometer are updated once per frame (see manual update mode of these classes).
+/** Stream description:
+*   - Header: session_signature, game::game_id, random seed (2 bytes, little-endian),
+*     flags (bit 0 is set if accelerometer is enabled), max brightness.
+*   - Frame records:
+*     - 0x01 - 0x7f: number of frames without input changes.
+*     - 0x80 | [0x40] | held_buttons: held buttons (bit is set for each held
+*       buttons::button_id) or accelerometer values changed. If 0x40 bit is set,
+*       this byte is followed by changed axes mask (bit 0 - X, bit 1 - Y, bit 2 - Z)
+*       and quantized values of changed axes (int8_t, raw value / accel_quantum).
+*   - end_of_session (0x00). */
+class input_recorder : static_class
+{
+public:
+	using write_function = void(*)(uint8_t value);
+	///Returns false if no more data is available
+	using read_function = bool(*)(uint8_t& value);
+	
+	static constexpr uint8_t session_signature = 0xa5;
+	static constexpr uint8_t end_of_session = 0x00;
+	static constexpr uint8_t accel_quantum = 4;
+	
+	enum mode : uint8_t
+	{
+		mode_off,
+		mode_record,
+		mode_replay
+	};
+	
+public:
+	/** Starts recording. Seeds random number generator with new seed and writes session header.
+	*   @param id Game which is going to be recorded
+	*   @param write Function to write stream bytes with */
+	static void start_recording(game::game_id id, write_function write);
+	
+	/** Starts replay. Reads session header, seeds random number generator and overrides
+	*   options with recorded ones in RAM (overrides are cleared by stop()).
+	*   @param id Recorded game
+	*   @param read Function to read stream bytes with
+	*   @returns false if stream doesn't start with valid session header */
+	static bool start_replay(game::game_id& id, read_function read);
+	
+	///Stops recording or replay. Recording is finished with end_of_session byte.
+	///If replay stream is over before stop() call, all buttons are released.
+	static void stop();
+	
+	static mode get_mode();
+};
@@ -28,6 +28,7 @@
 #include "debugger.h"
 #include "flight.h"
 #include "i2c_master.h"
+#include "input_recorder.h"
 #include "mode_selector.h"
 #include "maze.h"
 #include "number_display.h"
@@ -58,6 +59,41 @@ void ioinit()
 	power_adc_disable();
 	power_usart0_disable();
 }
+
+///Starts input recording if "forward" button is held when game is selected,
+///or replay if "back" button is held. Session stream is sent or received via UART
+///(see input_recorder.h). Returns game to run (replayed game may differ from selected one).
+mode_selector::mode start_input_recorder(mode_selector::mode selected)
+{
+	if(selected >= static_cast<uint8_t>(game::max_game_id))
+		return selected;
+	
+	if(buttons::is_still_pressed(buttons::button_fwd))
+	{
+		uart::start_raw();
+		input_recorder::start_recording(static_cast<game::game_id>(selected), uart::send_byte);
+	}
+	else if(buttons::is_still_pressed(buttons::button_back))
+	{
+		uart::start_raw();
+		game::game_id id;
+		if(input_recorder::start_replay(id, uart::receive_byte))
+			return static_cast<mode_selector::mode>(id);
+		
+		uart::stop_raw();
+	}
+	
+	return selected;
+}
+
+void stop_input_recorder()
+{
+	if(input_recorder::get_mode() != input_recorder::mode_off)
+	{
+		input_recorder::stop();
+		uart::stop_raw();
+	}
+}
 } //namespace
 
 int main()
@@ -117,6 +153,7 @@ int main()
 		//Select option: "right" button
 		buttons::flush_pressed();
 		auto res = mode_selector::select_mode();
+		res = start_input_recorder(res);
 		buttons::flush_pressed();
 		switch(res)
 		{
@@ -165,5 +202,7 @@ int main()
 			default:
 				break;
 		}
+		
+		stop_input_recorder();
 	}
 }
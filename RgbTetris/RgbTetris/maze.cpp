@@ -11,8 +11,12 @@
 
 #include "accelerometer.h"
 #include "buttons.h"
+#include "chunked_maze.h"
 #include "colors.h"
 #include "game.h"
+#include "maze_distance_field.h"
+#include "maze_grid.h"
+#include "maze_levels.h"
 #include "move_helper.h"
 #include "number_display.h"
 #include "options.h"
@@ -26,37 +30,6 @@
 
 namespace
 {
-enum wall_position : uint8_t
-{
-	wall_up = 1 << 0,
-	wall_down = 1 << 1,
-	wall_left = 1 << 2,
-	wall_right = 1 << 3,
-	wall_count = 4
-};
-
-struct cell
-{
-	void clear_wall(wall_position pos)
-	{
-		wall_state |= pos;
-	}
-
-	bool has_wall(wall_position pos) const
-	{
-		return !(wall_state & pos);
-	}
-
-	uint8_t wall_state : 4;
-	uint8_t prev_cell_x : 6;
-	uint8_t prev_cell_y : 6;
-};
-
-constexpr uint16_t max_maze_size = 1225; //35*35
-using maze_data = cell[max_maze_size];
-static_assert(sizeof(maze_data) == 2450, "Incorrect maze_data size");
-static_assert(sizeof(maze_data) < RAMSIZE - 1500, "Too big maze_data size");
-
 struct maze_dimension
 {
 	uint8_t size;
@@ -74,270 +47,294 @@ struct maze_info
 	{
 		dim_x.size = new_width;
 		dim_y.size = new_height;
-		list_count = 0;
-		memset(data, 0, sizeof(data));
+		chunked = false;
+		grid.init(new_width, new_height);
 	}
-
-	cell* at(uint8_t x, uint8_t y)
+	
+	void init_chunked(uint8_t new_width, uint8_t new_height, uint8_t random_passage_probability)
 	{
-		if (x >= dim_x.size || y >= dim_y.size)
-			return nullptr;
-
-		return &data[y * dim_x.size + x];
+		dim_x.size = new_width;
+		dim_y.size = new_height;
+		chunked = true;
+		chunks.init(new_width, new_height, static_cast<uint16_t>(rand()), random_passage_probability);
 	}
-
-	uint16_t list_count; //For growing tree algorithm
+	
+	bool has_wall(uint8_t x, uint8_t y, maze_grid::wall_position pos)
+	{
+		return chunked ? chunks.has_wall(x, y, pos) : grid.has_wall(x, y, pos);
+	}
+	
 	maze_dimension dim_x, dim_y;
 	uint8_t cell_size;
 	color::rgb start_color;
 	color::rgb end_color;
 	color::rgb exit_color;
-	maze_data data;
+	bool chunked;
+	union
+	{
+		maze_grid grid;
+		chunked_maze chunks;
+	};
+	
+	//Distances to the exit are not available in hard mode
+	bool has_distances;
+	maze_distance_field distances;
+	uint16_t max_distance_to_exit;
+	//Cell of the character and its distance, which are updated when the character moves
+	uint8_t character_cell_x, character_cell_y;
+	uint16_t distance_to_exit;
 };
 
-void get_start_maze_point(uint8_t width, uint8_t height,
-	uint8_t& start_x, uint8_t& start_y)
+///Maze walls on the display. Walls are kept as a mask of display pixels
+///besides the frame, so a scroll by one pixel shifts the frame and draws only
+///the new row or column, and the maze color is changed by recoloring the mask.
+struct maze_view
 {
-	if (rand() % 2)
+	//Maze pixel shown at the top left corner of the display
+	uint16_t origin_x, origin_y;
+	color::rgb wall_color;
+	//Bit X of row Y is set if there's a wall at the pixel
+	uint16_t walls[ws2812_matrix::height];
+	//Character, exit and hint point positions, which are drawn over the walls
+	uint8_t character_x, character_y;
+	int16_t exit_x, exit_y;
+	int16_t hint_x, hint_y;
+	//False if the display doesn't show the maze, then everything is redrawn
+	bool valid;
+};
+
+//Game loop keeps maze_info and maze_view on the stack, and generation,
+//distance calculation or chunk generation adds its scratch buffer on top
+static_assert(sizeof(maze_info) + sizeof(maze_view)
+	+ util::max<uint16_t>(util::max<uint16_t>(maze_grid::max_generation_stack,
+		maze_distance_field::calculation_stack), chunked_maze::generation_stack) < RAMSIZE - 1500,
+	"Too big maze game state");
+
+uint16_t get_view_origin(const maze_dimension& dim, uint8_t cell_size)
+{
+	return dim.cell_offset * (cell_size - 1) + dim.pixel_offset;
+}
+
+uint8_t get_character_cell(const maze_dimension& dim, uint8_t cell_size)
+{
+	return static_cast<uint8_t>((get_view_origin(dim, cell_size) + dim.character_offset) / (cell_size - 1));
+}
+
+///Coordinates are maze pixels. Walls of the cell [X, Y] are pixels
+///[X * (cell_size - 1) ... (X + 1) * (cell_size - 1)], walls are shared with the neighbour cells.
+bool is_wall_pixel(maze_info& maze, uint16_t x, uint16_t y)
+{
+	const uint8_t step = maze.cell_size - 1;
+	const uint16_t cell_x = x / step, cell_y = y / step;
+	if(cell_x > maze.dim_x.size || cell_y > maze.dim_y.size)
+		return false;
+	
+	const bool vertical_line = !(x % step), horizontal_line = !(y % step);
+	if(vertical_line && horizontal_line) //corners
+		return true;
+	
+	if(vertical_line)
 	{
-		start_x = (rand() % 2) ? 0 : width - 1;
-		start_y = rand() % height;
+		if(cell_y == maze.dim_y.size)
+			return false;
+		
+		return cell_x != maze.dim_x.size
+			? maze.has_wall(static_cast<uint8_t>(cell_x), static_cast<uint8_t>(cell_y), maze_grid::wall_left)
+			: maze.has_wall(static_cast<uint8_t>(cell_x - 1), static_cast<uint8_t>(cell_y), maze_grid::wall_right);
 	}
-	else
+	
+	if(horizontal_line)
+	{
+		if(cell_x == maze.dim_x.size)
+			return false;
+		
+		return cell_y != maze.dim_y.size
+			? maze.has_wall(static_cast<uint8_t>(cell_x), static_cast<uint8_t>(cell_y), maze_grid::wall_up)
+			: maze.has_wall(static_cast<uint8_t>(cell_x), static_cast<uint8_t>(cell_y - 1), maze_grid::wall_down);
+	}
+	
+	return false;
+}
+
+///Row and column must be empty
+void draw_maze_row(maze_info& maze, maze_view& view, uint8_t y)
+{
+	for(uint8_t x = 0; x != ws2812_matrix::width; ++x)
 	{
-		start_y = (rand() % 2) ? 0 : height - 1;
-		start_x = rand() % width;
+		if(is_wall_pixel(maze, view.origin_x + x, view.origin_y + y))
+		{
+			view.walls[y] |= 1 << x;
+			ws2812_matrix::set_pixel_color_fast(x, y, view.wall_color.r, view.wall_color.g, view.wall_color.b);
+		}
 	}
 }
 
-void get_unvisited_cells(maze_info& maze, uint8_t x, uint8_t y,
-	uint8_t& unvisited_neighbors_count, util::coord unvisited_neighbors_coords[4],
-	cell* init_cell)
+void draw_maze_column(maze_info& maze, maze_view& view, uint8_t x)
 {
-	unvisited_neighbors_count = 0;
-	//[-1; 0], [1; 0], [0; -1], [0; 1]
-	for(int8_t i = -1; i < 2; i += 2)
+	for(uint8_t y = 0; y != ws2812_matrix::height; ++y)
 	{
-		cell* unvisited_cell = maze.at(static_cast<uint8_t>(x + i), y);
-		if(unvisited_cell && !unvisited_cell->prev_cell_x && unvisited_cell != init_cell)
+		if(is_wall_pixel(maze, view.origin_x + x, view.origin_y + y))
 		{
-			unvisited_neighbors_coords[unvisited_neighbors_count++]
-				= { static_cast<uint8_t>(x + i), y };
+			view.walls[y] |= 1 << x;
+			ws2812_matrix::set_pixel_color_fast(x, y, view.wall_color.r, view.wall_color.g, view.wall_color.b);
 		}
 	}
-	for(int8_t i = -1; i < 2; i += 2)
+}
+
+void recolor_maze(maze_view& view)
+{
+	for(uint8_t y = 0; y != ws2812_matrix::height; ++y)
 	{
-		cell* unvisited_cell = maze.at(x, static_cast<uint8_t>(y + i));
-		if(unvisited_cell && !unvisited_cell->prev_cell_x && unvisited_cell != init_cell)
+		for(uint8_t x = 0; x != ws2812_matrix::width; ++x)
 		{
-			unvisited_neighbors_coords[unvisited_neighbors_count++]
-				= { x, static_cast<uint8_t>(y + i) };
+			if(view.walls[y] & (1 << x))
+				ws2812_matrix::set_pixel_color_fast(x, y, view.wall_color.r, view.wall_color.g, view.wall_color.b);
 		}
 	}
 }
 
-void remove_unneeded_walls(uint8_t x, uint8_t y,
-	const util::coord& next_cell_coords, cell* current_cell, cell* next_cell)
+///Brings walls on the display up to date with maze offsets. Character
+///and exit point must be removed from the display before.
+void draw_maze(maze_info& maze, maze_view& view, uint16_t seconds_for_level, uint16_t original_seconds_for_level)
 {
-	if(next_cell_coords.y < y)
+	color::rgb maze_color;
+	color::gradient(maze.start_color, maze.end_color, original_seconds_for_level / 4,
+		(original_seconds_for_level - seconds_for_level) / 4, maze_color);
+	
+	const uint16_t origin_x = get_view_origin(maze.dim_x, maze.cell_size);
+	const uint16_t origin_y = get_view_origin(maze.dim_y, maze.cell_size);
+	const int16_t scroll_x = origin_x - view.origin_x, scroll_y = origin_y - view.origin_y;
+	if(!view.valid || scroll_x > 1 || scroll_x < -1 || scroll_y > 1 || scroll_y < -1)
 	{
-		current_cell->clear_wall(wall_up);
-		next_cell->clear_wall(wall_down);
+		view.valid = true;
+		view.origin_x = origin_x;
+		view.origin_y = origin_y;
+		view.wall_color = maze_color;
+		memset(view.walls, 0, sizeof(view.walls));
+		ws2812_matrix::clear();
+		for(uint8_t y = 0; y != ws2812_matrix::height; ++y)
+			draw_maze_row(maze, view, y);
+		
+		return;
 	}
-	else if(next_cell_coords.y > y)
+	
+	if(!(view.wall_color == maze_color))
 	{
-		current_cell->clear_wall(wall_down);
-		next_cell->clear_wall(wall_up);
+		view.wall_color = maze_color;
+		recolor_maze(view);
 	}
-	else if(next_cell_coords.x < x)
+	
+	//Column is drawn for the current vertical offset, then the frame is scrolled vertically
+	view.origin_x = origin_x;
+	if(scroll_x > 0)
 	{
-		current_cell->clear_wall(wall_left);
-		next_cell->clear_wall(wall_right);
+		ws2812_matrix::shift_right();
+		for(uint8_t y = 0; y != ws2812_matrix::height; ++y)
+			view.walls[y] >>= 1;
+		
+		draw_maze_column(maze, view, ws2812_matrix::width - 1);
 	}
-	else //next_cell_coords.x > x
+	else if(scroll_x < 0)
 	{
-		current_cell->clear_wall(wall_right);
-		next_cell->clear_wall(wall_left);
+		ws2812_matrix::shift_left();
+		for(uint8_t y = 0; y != ws2812_matrix::height; ++y)
+			view.walls[y] = (view.walls[y] << 1) & ((1 << ws2812_matrix::width) - 1);
+		
+		draw_maze_column(maze, view, 0);
 	}
-}
-
-void generate_maze_dfs(maze_info& maze)
-{
-	uint8_t x, y;
-	get_start_maze_point(maze.dim_x.size, maze.dim_y.size, x, y);
-
-	util::coord unvisited_neighbors_coords[4];
-	uint8_t unvisited_neighbors_count;
-	cell* init_cell = maze.at(x, y);
-	maze.dim_x.exit_cell_coord = x;
-	maze.dim_y.exit_cell_coord = y;
-	uint16_t level = 0, max_level = 0;
-	while(true)
+	
+	view.origin_y = origin_y;
+	if(scroll_y > 0)
 	{
-		cell* current_cell = maze.at(x, y);
-		get_unvisited_cells(maze, x, y, unvisited_neighbors_count, unvisited_neighbors_coords, init_cell);
-		if(!unvisited_neighbors_count)
-		{
-			//Backtrack
-			if(!current_cell->prev_cell_x)
-				break; //Finish generation
-
-			if(level > max_level)
-			{
-				max_level = level;
-				maze.dim_x.entrance_cell_coord = x;
-				maze.dim_y.entrance_cell_coord = y;
-			}
-
-			x = current_cell->prev_cell_x - 1;
-			y = current_cell->prev_cell_y - 1;
-			--level;
-			continue;
-		}
-		else
-		{
-			//Take random unvisited neighbor
-			const util::coord& next_cell_coords = unvisited_neighbors_coords[rand() % unvisited_neighbors_count];
-			cell* next_cell = maze.at(next_cell_coords.x, next_cell_coords.y);
-			next_cell->prev_cell_x = x + 1;
-			next_cell->prev_cell_y = y + 1;
-
-			remove_unneeded_walls(x, y, next_cell_coords, current_cell, next_cell);
-
-			x = next_cell_coords.x;
-			y = next_cell_coords.y;
-			++level;
-		}
+		ws2812_matrix::shift_down();
+		memmove(view.walls, view.walls + 1, sizeof(view.walls) - sizeof(view.walls[0]));
+		view.walls[ws2812_matrix::height - 1] = 0;
+		draw_maze_row(maze, view, ws2812_matrix::height - 1);
+	}
+	else if(scroll_y < 0)
+	{
+		ws2812_matrix::shift_up();
+		memmove(view.walls + 1, view.walls, sizeof(view.walls) - sizeof(view.walls[0]));
+		view.walls[0] = 0;
+		draw_maze_row(maze, view, 0);
 	}
 }
 
-void add_point_to_list(maze_info& maze, cell& value)
+void generate_maze_dfs(maze_info& maze)
 {
-	++maze.list_count;
-	value.prev_cell_x = 1;
+	util::coord start, deepest;
+	maze.grid.generate_dfs(start, deepest);
+	maze.dim_x.exit_cell_coord = start.x;
+	maze.dim_y.exit_cell_coord = start.y;
+	maze.dim_x.entrance_cell_coord = deepest.x;
+	maze.dim_y.entrance_cell_coord = deepest.y;
 }
 
-bool get_point_from_list(maze_info& maze, uint8_t& x, uint8_t& y)
+int16_t get_cell_pixel_coord(const maze_dimension& dim, uint8_t cell_coord, uint8_t cell_size)
 {
-	if(!maze.list_count)
-		return false;
-
-	uint16_t cell_index = rand() % maze.list_count;
-	for(x = 0; x != maze.dim_x.size; ++x)
-	{
-		for(y = 0; y != maze.dim_y.size; ++y)
-		{
-			cell* value = maze.at(x, y);
-			if(value->prev_cell_x == 1)
-			{
-				if(!cell_index)
-					return true;
-
-				--cell_index;
-			}
-		}
-	}
-
-	return false;
+	return cell_coord * (cell_size - 1) + 1 /* wall width */
+		- dim.pixel_offset - dim.cell_offset * (cell_size - 1);
 }
 
-void remove_point_from_list(maze_info& maze, cell& value)
+int16_t get_finish_pixel_coord(const maze_dimension& dim, uint8_t cell_size)
 {
-	--maze.list_count;
-	value.prev_cell_x = 63; //max value
+	return get_cell_pixel_coord(dim, dim.exit_cell_coord, cell_size);
 }
 
-void generate_maze_growing_tree(maze_info& maze)
+///Finds distances to the exit when the maze, its entrance and exit are ready
+void calculate_distances(maze_info& maze)
 {
-	uint8_t x, y;
-	get_start_maze_point(maze.dim_x.size, maze.dim_y.size, x, y);
-
-	util::coord unvisited_neighbors_coords[4];
-	uint8_t unvisited_neighbors_count;
-
-	add_point_to_list(maze, *maze.at(x, y));
-	while(true)
-	{
-		if(!get_point_from_list(maze, x, y))
-			break;
-
-		get_unvisited_cells(maze, x, y, unvisited_neighbors_count, unvisited_neighbors_coords, nullptr);
-
-		cell* current_cell = maze.at(x, y);
-		if(!unvisited_neighbors_count)
-		{
-			remove_point_from_list(maze, *current_cell);
-			continue;
-		}
-		else
-		{
-			//Take random unvisited neighbor
-			const util::coord& next_cell_coords = unvisited_neighbors_coords[rand() % unvisited_neighbors_count];
-			cell* next_cell = maze.at(next_cell_coords.x, next_cell_coords.y);
-			add_point_to_list(maze, *next_cell);
-			remove_unneeded_walls(x, y, next_cell_coords, current_cell, next_cell);
-		}
-	}
+	maze.has_distances = !maze.chunked && maze.distances.calculate(maze.grid,
+		maze.dim_x.exit_cell_coord, maze.dim_y.exit_cell_coord, maze.max_distance_to_exit);
+	if(!maze.has_distances)
+		return;
+	
+	maze.character_cell_x = maze.dim_x.entrance_cell_coord;
+	maze.character_cell_y = maze.dim_y.entrance_cell_coord;
+	maze.distance_to_exit = maze.distances.get_distance(maze.grid,
+		maze.character_cell_x, maze.character_cell_y);
 }
 
-void draw_maze(maze_info& maze, uint16_t seconds_for_level, uint16_t original_seconds_for_level)
+///Character moves to a neighbour cell at most along each axis,
+///vertical move goes first (see scroll_maze)
+void update_distance_to_exit(maze_info& maze)
 {
-	color::rgb maze_color;
-	color::gradient(maze.start_color, maze.end_color, original_seconds_for_level / 4,
-		(original_seconds_for_level - seconds_for_level) / 4, maze_color);
+	if(!maze.has_distances)
+		return;
 	
-	uint8_t horizontal_cells = 1 + (ws2812_matrix::width - 1) / (maze.cell_size - 1);
-	uint8_t vertical_cells = 1 + (ws2812_matrix::height - 1) / (maze.cell_size - 1);
+	const uint8_t x = get_character_cell(maze.dim_x, maze.cell_size);
+	const uint8_t y = get_character_cell(maze.dim_y, maze.cell_size);
+	if(y != maze.character_cell_y)
+	{
+		maze.distance_to_exit += maze.distances.get_distance_change(maze.character_cell_x, maze.character_cell_y,
+			maze.character_cell_x, y);
+		maze.character_cell_y = y;
+	}
 	
-	for(uint8_t cell_x = 0; cell_x != horizontal_cells + 1; ++cell_x)
+	if(x != maze.character_cell_x)
 	{
-		for(uint8_t cell_y = 0; cell_y != vertical_cells + 1; ++cell_y)
-		{
-			cell* current_cell = maze.at(cell_x + maze.dim_x.cell_offset, cell_y + maze.dim_y.cell_offset);
-			if(!current_cell)
-				continue;
-			
-			int8_t cell_pixel_pos_x = cell_x * (maze.cell_size - 1) - maze.dim_x.pixel_offset;
-			int8_t cell_pixel_pos_y = cell_y * (maze.cell_size - 1) - maze.dim_y.pixel_offset;
-			for(int8_t x = cell_pixel_pos_x; x != cell_pixel_pos_x + maze.cell_size; ++x)
-			{
-				if(x == cell_pixel_pos_x || x == cell_pixel_pos_x + maze.cell_size - 1) //corners
-				{
-					ws2812_matrix::set_pixel_color(x, cell_pixel_pos_y, maze_color);
-					ws2812_matrix::set_pixel_color(x, cell_pixel_pos_y + maze.cell_size - 1, maze_color);
-				}
-				else
-				{
-					if(current_cell->has_wall(wall_down))
-						ws2812_matrix::set_pixel_color(x, cell_pixel_pos_y + maze.cell_size - 1, maze_color);
-					if(current_cell->has_wall(wall_up))
-						ws2812_matrix::set_pixel_color(x, cell_pixel_pos_y, maze_color);
-				}
-			}
-			
-			for(int8_t y = cell_pixel_pos_y; y != cell_pixel_pos_y + maze.cell_size; ++y)
-			{
-				if(y == cell_pixel_pos_y || y == cell_pixel_pos_y + maze.cell_size - 1) //corners
-				{
-					ws2812_matrix::set_pixel_color(cell_pixel_pos_x, y, maze_color);
-					ws2812_matrix::set_pixel_color(cell_pixel_pos_x + maze.cell_size - 1, y, maze_color);
-				}
-				else
-				{
-					if(current_cell->has_wall(wall_right))
-						ws2812_matrix::set_pixel_color(cell_pixel_pos_x + maze.cell_size - 1, y, maze_color);
-					if(current_cell->has_wall(wall_left))
-						ws2812_matrix::set_pixel_color(cell_pixel_pos_x, y, maze_color);
-				}
-			}
-		}
+		maze.distance_to_exit += maze.distances.get_distance_change(maze.character_cell_x, maze.character_cell_y,
+			x, maze.character_cell_y);
+		maze.character_cell_x = x;
 	}
 }
 
-int16_t get_finish_pixel_coord(const maze_dimension& dim, uint8_t cell_size)
+///Hint point is the cell next to the character cell on the way to the exit
+bool get_hint_point(maze_info& maze, int16_t& hint_x, int16_t& hint_y)
 {
-	return dim.exit_cell_coord * (cell_size - 1) + 1 /* wall width */
-		- dim.pixel_offset - dim.cell_offset * (cell_size - 1);
+	if(!maze.has_distances)
+		return false;
+	
+	const uint8_t pos = maze.distances.get_exit_direction(maze.grid,
+		maze.character_cell_x, maze.character_cell_y);
+	if(!pos)
+		return false;
+	
+	uint8_t x = maze.character_cell_x, y = maze.character_cell_y;
+	maze_distance_field::move(x, y, static_cast<maze_grid::wall_position>(pos));
+	hint_x = get_cell_pixel_coord(maze.dim_x, x, maze.cell_size);
+	hint_y = get_cell_pixel_coord(maze.dim_y, y, maze.cell_size);
+	return true;
 }
 
 void set_corner_start_and_end(maze_info& maze)
@@ -445,17 +442,27 @@ void scroll_maze(maze_dimension& dim, int8_t scroll,
 	}
 }
 
+///Returns maze pixel coordinate of the character
+uint16_t get_character_pixel(const maze_dimension& dim, uint8_t cell_size)
+{
+	return get_view_origin(dim, cell_size) + dim.character_offset;
+}
+
+///Walls are checked in maze coordinates, because the display is not
+///redrawn between vertical and horizontal moves
 bool scroll_maze(maze_info& maze, int8_t scroll_x, int8_t scroll_y)
 {
 	bool ret = false;
 	
-	if(scroll_y && !ws2812_matrix::is_on(maze.dim_x.character_offset, maze.dim_y.character_offset + scroll_y))
+	if(scroll_y && !is_wall_pixel(maze, get_character_pixel(maze.dim_x, maze.cell_size),
+		get_character_pixel(maze.dim_y, maze.cell_size) + scroll_y))
 	{
 		ret = true;
 		scroll_maze(maze.dim_y, scroll_y, ws2812_matrix::height, character_center_y, maze.cell_size);
 	}
 	
-	if(scroll_x && !ws2812_matrix::is_on(maze.dim_x.character_offset + scroll_x, maze.dim_y.character_offset))
+	if(scroll_x && !is_wall_pixel(maze, get_character_pixel(maze.dim_x, maze.cell_size) + scroll_x,
+		get_character_pixel(maze.dim_y, maze.cell_size)))
 	{
 		ret = true;
 		scroll_maze(maze.dim_x, scroll_x, ws2812_matrix::width, character_center_x, maze.cell_size);
@@ -464,97 +471,38 @@ bool scroll_maze(maze_info& maze, int8_t scroll_x, int8_t scroll_y)
 	return ret;
 }
 
-void draw_exit_point(int16_t exit_x, int16_t exit_y, const color::rgb& rgb)
+void draw_point(int16_t x, int16_t y, const color::rgb& rgb)
 {
-	if(exit_x >= 0 && exit_y >= 0 && exit_x < ws2812_matrix::width && exit_y < ws2812_matrix::height)
-		ws2812_matrix::set_pixel_color(static_cast<uint8_t>(exit_x), static_cast<uint8_t>(exit_y), rgb);
+	if(x >= 0 && y >= 0 && x < ws2812_matrix::width && y < ws2812_matrix::height)
+		ws2812_matrix::set_pixel_color(static_cast<uint8_t>(x), static_cast<uint8_t>(y), rgb);
 }
 
-void add_random_passages(maze_info& maze, uint8_t probability) //0 <= probability <= 128
+constexpr uint8_t max_allowed_time_drop_hard_mode = 25;
+constexpr uint8_t max_random_passage_probability_hard_mode = 3;
+constexpr uint8_t hard_mode_max_cell_size = 2;
+constexpr uint8_t cell_size_increment = 3;
+constexpr uint8_t hard_mode_size_increment = 2;
+constexpr uint8_t last_level_id = sizeof(maze_levels) / sizeof(maze_levels[0]) - 1;
+
+constexpr bool growing_tree_levels_fit(uint8_t level_id)
 {
-	for(uint8_t x = 1; x != maze.dim_x.size - 1; ++x)
-	{
-		for(uint8_t y = 1; y != maze.dim_y.size - 1; ++y)
-		{
-			if(rand() % 128 < probability)
-			{
-				wall_position wall = static_cast<wall_position>(1 << (rand() % wall_count));
-				maze.at(x, y)->clear_wall(wall);
-				switch(wall)
-				{
-				case wall_down:
-					maze.at(x, y + 1)->clear_wall(wall_up);
-					break;
-				
-				case wall_up:
-					maze.at(x, y - 1)->clear_wall(wall_down);
-					break;
-				
-				case wall_left:
-					maze.at(x - 1, y)->clear_wall(wall_right);
-					break;
-				
-				case wall_right:
-					maze.at(x + 1, y)->clear_wall(wall_left);
-					break;
-				}
-			}
-		}
-	}
+	return level_id > last_level_id
+		|| ((maze_levels[level_id].flags != algo_growing_tree_corners
+			|| maze_levels[level_id].width * maze_levels[level_id].height <= maze_grid::max_growing_tree_cell_count)
+		&& growing_tree_levels_fit(level_id + 1));
 }
 
-enum algo_flags : uint8_t
-{
-	algo_dfs_long_path,
-	algo_dfs_corners,
-	algo_growing_tree_corners
-};
+static_assert(growing_tree_levels_fit(0), "Too big growing tree level");
 
-struct level
+constexpr bool distance_field_levels_fit(uint8_t level_id)
 {
-	uint8_t width : 6;
-	uint8_t height : 6;
-	uint8_t score_multiplier : 4;
-	uint8_t allowed_time : 6; // * 10 sec
-	uint8_t cell_size : 2; // + 3
-	uint8_t flags : 3;
-	uint8_t random_passage_probability : 5; //[0 - 31] * 4
-};
+	return level_id > last_level_id
+		|| (maze_levels[level_id].width * maze_levels[level_id].height <= maze_distance_field::max_cell_count
+			&& distance_field_levels_fit(level_id + 1));
+}
 
-const level levels[] PROGMEM = {
-	{ 3, 5, 1, 2, 1, algo_dfs_long_path, 0 },
-	{ 3, 5, 2, 3, 2, algo_dfs_long_path, 0 },
-	{ 5, 8, 3, 3, 0, algo_dfs_long_path, 0 },
-	{ 12, 5, 3, 3, 1, algo_growing_tree_corners, 0 },
-	{ 5, 16, 4, 3, 0, algo_growing_tree_corners, 0 },
-	{ 10, 10, 4, 2, 0, algo_dfs_corners, 16 },
-	{ 12, 12, 5, 4, 1, algo_dfs_long_path, 15 },
-	{ 11, 11, 5, 5, 0, algo_dfs_long_path, 3 },
-	{ 35, 35, 6, 6, 0, algo_dfs_corners, 27 },
-	{ 20, 20, 6, 9, 1, algo_growing_tree_corners, 6 },
-	{ 10, 15, 6, 8, 0, algo_dfs_long_path, 0 },
-	{ 15, 15, 7, 5, 0, algo_growing_tree_corners, 0 },
-	{ 62, 3, 7, 11, 3, algo_dfs_long_path, 0 },
-	{ 15, 15, 7, 10, 1, algo_dfs_corners, 0 },
-	{ 30, 8, 8, 11, 0, algo_dfs_long_path, 1 },
-	{ 4, 62, 8, 4, 1, algo_growing_tree_corners, 5 },
-	{ 5, 45, 9, 7, 0, algo_dfs_corners, 1 },
-	{ 20, 20, 9, 14, 0, algo_dfs_long_path, 0 },
-	{ 16, 16, 9, 16, 1, algo_dfs_long_path, 0 },
-	{ 11, 11, 9, 9, 3, algo_dfs_long_path, 0 },
-	{ 27, 18, 10, 15, 0, algo_dfs_corners, 0 },
-	{ 16, 30, 10, 25, 1, algo_dfs_long_path, 0 },
-	{ 24, 24, 11, 28, 0, algo_dfs_long_path, 0 },
-	{ 25, 30, 12, 32, 0, algo_dfs_long_path, 1 },
-	{ 32, 32, 14, 45, 0, algo_dfs_long_path, 0 },
-	{ 35, 35, 15, 63, 1, algo_dfs_long_path, 0 }
-};
+static_assert(distance_field_levels_fit(0), "Too big level for distance field");
 
-constexpr uint8_t max_allowed_time_drop_hard_mode = 25;
-constexpr uint8_t max_random_passage_probability_hard_mode = 3;
-constexpr uint8_t hard_mode_max_cell_size = 2;
-constexpr uint8_t cell_size_increment = 3;
-constexpr uint8_t last_level_id = sizeof(levels) / sizeof(levels[0]) - 1;
 void load_level(uint8_t& level_id, maze_info& maze, uint8_t& score_multiplier, uint8_t max_brightness,
 	uint16_t& seconds_for_level, int16_t& exit_x, int16_t& exit_y)
 {
@@ -562,8 +510,8 @@ void load_level(uint8_t& level_id, maze_info& maze, uint8_t& score_multiplier, u
 	if(level_id > last_level_id)
 		hardmode = true;
 	
-	level info;
-	memcpy_P(&info, &levels[hardmode ? last_level_id : level_id], sizeof(info));
+	maze_level info;
+	memcpy_P(&info, &maze_levels[hardmode ? last_level_id : level_id], sizeof(info));
 	
 	//Load last level with some modifications in case if no more levels left
 	if(hardmode)
@@ -576,30 +524,41 @@ void load_level(uint8_t& level_id, maze_info& maze, uint8_t& score_multiplier, u
 	maze.cell_size = info.cell_size + cell_size_increment;
 	score_multiplier = info.score_multiplier;
 	
-	maze.init(info.width, info.height);
-	switch(info.flags)
+	if(hardmode)
 	{
-		case algo_dfs_long_path:
-			generate_maze_dfs(maze);
-			break;
-		
-		case algo_dfs_corners:
-			generate_maze_dfs(maze);
-			set_corner_start_and_end(maze);
-			break;
+		//Maze grows each level, chunks are generated when they're drawn
+		const uint8_t size = static_cast<uint8_t>(util::min<uint16_t>(
+			info.width + (level_id - last_level_id) * hard_mode_size_increment, chunked_maze::max_size));
+		maze.init_chunked(size, size, info.random_passage_probability * 4);
+		set_corner_start_and_end(maze);
+	}
+	else
+	{
+		maze.init(info.width, info.height);
+		switch(info.flags)
+		{
+			case algo_dfs_long_path:
+				generate_maze_dfs(maze);
+				break;
+			
+			case algo_dfs_corners:
+				generate_maze_dfs(maze);
+				set_corner_start_and_end(maze);
+				break;
+			
+			case algo_growing_tree_corners:
+				maze.grid.generate_growing_tree();
+				set_corner_start_and_end(maze);
+				break;
 			
-		case algo_growing_tree_corners:
-			generate_maze_growing_tree(maze);
-			set_corner_start_and_end(maze);
-			break;
+			default:
+				break;
+		}
 		
-		default:
-			break;
+		if(info.random_passage_probability)
+			maze.grid.add_random_passages(info.random_passage_probability * 4);
 	}
 	
-	if(info.random_passage_probability)
-		add_random_passages(maze, info.random_passage_probability * 4);	
-	
 	game::get_random_color(maze.start_color, max_brightness);
 	game::get_random_color(maze.end_color, max_brightness);
 	game::get_random_color(maze.exit_color, max_brightness);
@@ -608,6 +567,7 @@ void load_level(uint8_t& level_id, maze_info& maze, uint8_t& score_multiplier, u
 	number_display::output_number(seconds_for_level);
 	
 	scroll_character_into_view(maze);
+	calculate_distances(maze);
 	
 	exit_x = get_finish_pixel_coord(maze.dim_x, maze.cell_size);
 	exit_y = get_finish_pixel_coord(maze.dim_y, maze.cell_size);
@@ -620,25 +580,52 @@ constexpr color::rgb cold_color { 0, 0, 0xff };
 constexpr color::rgb second_cold_color { 0, 0xff, 0 };
 constexpr color::rgb warm_color { 0xff, 0, 0 };
 constexpr color::rgb second_warm_color { 0xff, 0xff, 0 };
-void get_character_color(maze_info& maze, color::rgb& character_color,
-	color::rgb& second_character_color, uint8_t max_brightness)
+///Straight line distance in cells, used when distances in the maze are not available
+void get_straight_distance_to_exit(maze_info& maze, uint16_t& distance_to_exit, uint16_t& max_distance_to_exit)
 {
-	
-	int8_t x_character_cell = static_cast<int8_t>(
-		(maze.dim_x.character_offset + maze.dim_x.pixel_offset) / (maze.cell_size - 1));
-	int8_t y_character_cell = static_cast<int8_t>(
-		(maze.dim_y.character_offset + maze.dim_y.pixel_offset) / (maze.cell_size - 1));
+	int16_t x_character_cell = (maze.dim_x.character_offset + maze.dim_x.pixel_offset) / (maze.cell_size - 1);
+	int16_t y_character_cell = (maze.dim_y.character_offset + maze.dim_y.pixel_offset) / (maze.cell_size - 1);
 	x_character_cell += maze.dim_x.cell_offset;
 	y_character_cell += maze.dim_y.cell_offset;
 	x_character_cell -= maze.dim_x.exit_cell_coord;
 	y_character_cell -= maze.dim_y.exit_cell_coord;
 	
-	uint8_t distance_to_exit = static_cast<uint8_t>(
-		util::isqrt(x_character_cell * x_character_cell + y_character_cell * y_character_cell));
-	uint8_t max_distance_to_exit = static_cast<uint8_t>(
-		util::isqrt(maze.dim_x.size * maze.dim_x.size + maze.dim_y.size * maze.dim_y.size));
+	uint8_t width = maze.dim_x.size, height = maze.dim_y.size;
+	//Keep squares in 16 bits for big hard mode mazes
+	if(width > INT8_MAX || height > INT8_MAX)
+	{
+		x_character_cell /= 2;
+		y_character_cell /= 2;
+		width /= 2;
+		height /= 2;
+	}
+	
+	distance_to_exit = util::isqrt(x_character_cell * x_character_cell + y_character_cell * y_character_cell);
+	max_distance_to_exit = util::isqrt(width * width + height * height);
 	if(distance_to_exit > max_distance_to_exit)
 		distance_to_exit = max_distance_to_exit;
+}
+
+void get_character_color(maze_info& maze, color::rgb& character_color,
+	color::rgb& second_character_color, uint8_t max_brightness)
+{
+	uint16_t distance_to_exit, max_distance_to_exit;
+	if(maze.has_distances)
+	{
+		distance_to_exit = maze.distance_to_exit;
+		max_distance_to_exit = maze.max_distance_to_exit;
+	}
+	else
+	{
+		get_straight_distance_to_exit(maze, distance_to_exit, max_distance_to_exit);
+	}
+	
+	//Gradient takes 8-bit step count
+	while(max_distance_to_exit > UINT8_MAX)
+	{
+		distance_to_exit /= 2;
+		max_distance_to_exit /= 2;
+	}
 	
 	color::gradient(cold_color, warm_color, max_distance_to_exit,
 		max_distance_to_exit - distance_to_exit, character_color);
@@ -665,6 +652,8 @@ uint32_t loop()
 	load_level(level_id, maze, score_multiplier, max_brightness, original_seconds_for_level, exit_x, exit_y);
 	seconds_for_level = original_seconds_for_level;
 	
+	maze_view view;
+	view.valid = false;
 	bool refresh = true;
 	int8_t scroll_x = 0, scroll_y = 0;
 	uint8_t ticks_per_second = static_cast<uint8_t>(timer::frequency);
@@ -674,6 +663,9 @@ uint32_t loop()
 		result_character_color;
 	const color::rgb black { 0, 0, 0 };
 	bool exit_point_visible = true;
+	//Hint point blinks in turn with the exit point, hints halve the level score.
+	//Hint mode stays on for the next level if it has distances to the exit.
+	bool hint_mode = false, hint_used = false;
 	
 	bool accelerometer_enabled = options::is_accelerometer_enabled();
 	accelerometer::speed_state x_speed_state(9), y_speed_state(9);
@@ -688,7 +680,7 @@ uint32_t loop()
 			scroll_x = 1;
 		else if(move_dir & move_direction_right)
 			scroll_x = -1;
-			
+		
 		if(move_dir & move_direction_up)
 			scroll_y = 1;
 		else if(move_dir & move_direction_down)
@@ -704,6 +696,15 @@ uint32_t loop()
 			}
 			
 			number_display::output_number(seconds_for_level);
+			view.valid = false;
+			refresh = true;
+		}
+		
+		//No hints without distances to the exit (hard mode chunked mazes)
+		if(buttons::is_pressed(buttons::button_fwd) && maze.has_distances)
+		{
+			hint_mode = !hint_mode;
+			hint_used = hint_used || hint_mode;
 			refresh = true;
 		}
 		
@@ -719,25 +720,30 @@ uint32_t loop()
 		
 		if(scroll_x || scroll_y)
 		{
-			draw_exit_point(exit_x, exit_y, black);
-			
 			if(scroll_maze(maze, scroll_x, scroll_y))
 			{
 				refresh = true;
+				update_distance_to_exit(maze);
 				exit_x = get_finish_pixel_coord(maze.dim_x, maze.cell_size);
 				exit_y = get_finish_pixel_coord(maze.dim_y, maze.cell_size);
 				if(exit_x == maze.dim_x.character_offset && exit_y == maze.dim_y.character_offset)
 				{
-					score += seconds_for_level * score_multiplier;
+					uint32_t level_score = seconds_for_level * score_multiplier;
+					if(hint_used)
+						level_score /= 2;
+					
+					score += level_score;
 					load_level(level_id, maze, score_multiplier, max_brightness, original_seconds_for_level, exit_x, exit_y);
 					seconds_for_level = original_seconds_for_level;
 					ticks_per_second = static_cast<uint8_t>(timer::frequency);
+					view.valid = false;
+					hint_mode = hint_mode && maze.has_distances;
+					hint_used = hint_mode;
 				}
 				get_character_color(maze, character_color, second_character_color, max_brightness);
 				character_draw_counter = target_character_draw_counter - 1;
 			}
 			
-			draw_exit_point(exit_x, exit_y, exit_point_visible ? maze.exit_color : black);
 			scroll_x = scroll_y = 0;
 		}
 		
@@ -763,11 +769,27 @@ uint32_t loop()
 		if(refresh)
 		{
 			refresh = false;
-			ws2812_matrix::clear();
-			draw_maze(maze, seconds_for_level, original_seconds_for_level);
-			ws2812_matrix::set_pixel_color(maze.dim_x.character_offset, maze.dim_y.character_offset,
-				result_character_color);
-			draw_exit_point(exit_x, exit_y, exit_point_visible ? maze.exit_color : black);
+			if(view.valid)
+			{
+				ws2812_matrix::set_pixel_color(view.character_x, view.character_y, black);
+				draw_point(view.exit_x, view.exit_y, black);
+				draw_point(view.hint_x, view.hint_y, black);
+			}
+			
+			draw_maze(maze, view, seconds_for_level, original_seconds_for_level);
+			view.character_x = maze.dim_x.character_offset;
+			view.character_y = maze.dim_y.character_offset;
+			view.exit_x = exit_x;
+			view.exit_y = exit_y;
+			view.hint_x = view.hint_y = -1;
+			if(hint_mode && !exit_point_visible)
+			{
+				get_hint_point(maze, view.hint_x, view.hint_y);
+				draw_point(view.hint_x, view.hint_y, maze.exit_color);
+			}
+			
+			ws2812_matrix::set_pixel_color(view.character_x, view.character_y, result_character_color);
+			draw_point(exit_x, exit_y, exit_point_visible ? maze.exit_color : black);
 			ws2812_matrix::show();
 		}
 	}
@@ -0,0 +1,177 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "maze_grid.h"
+
+///Distances from maze cells to the exit cell, which are found by breadth-first
+///search once after the maze is generated. Each cell keeps its distance modulo 3
+///in 2 bits. Distances of neighbour cells differ by one at most, so the neighbour
+///which is closer to the exit is the one with the previous value, and distance
+///of a moving character changes by the difference of the neighbour values.
+class maze_distance_field
+{
+public:
+	//Biggest maze level is 35x35 cells
+	static constexpr uint16_t max_cell_count = 35 * 35;
+	//Breadth-first search queue size (power of 2), which keeps cells
+	//of two distances at most
+	static constexpr uint16_t queue_size = 256;
+	//Bytes calculate() keeps on the stack
+	static constexpr uint16_t calculation_stack = queue_size * sizeof(uint16_t);
+	
+public:
+	/** Maze must not have more than max_cell_count cells.
+	*   @param max_distance Distance of the farthest cell from the exit
+	*   @return False if the search queue overflowed, distances are not valid then */
+	bool calculate(const maze_grid& grid, uint8_t exit_x, uint8_t exit_y, uint16_t& max_distance)
+	{
+		width_ = grid.get_width();
+		memset(values_, 0xff, sizeof(values_));
+		
+		uint16_t queue[queue_size];
+		uint16_t read_index = 0, write_index = 0;
+		queue[write_index++] = get_cell_index(exit_x, exit_y);
+		set_value(queue[0], 0);
+		
+		uint16_t layer_end = write_index;
+		uint8_t next_value = 1;
+		max_distance = 0;
+		while(read_index != write_index)
+		{
+			if(read_index == layer_end)
+			{
+				layer_end = write_index;
+				++max_distance;
+				next_value = get_next_value(next_value);
+			}
+			
+			const uint16_t index = queue[read_index++ % queue_size];
+			const uint8_t x = index % width_, y = index / width_;
+			for(uint8_t pos = maze_grid::wall_up; pos != 1 << maze_grid::wall_count; pos <<= 1)
+			{
+				if(grid.has_wall(x, y, static_cast<maze_grid::wall_position>(pos)))
+					continue;
+				
+				uint8_t next_x = x, next_y = y;
+				move(next_x, next_y, static_cast<maze_grid::wall_position>(pos));
+				const uint16_t next_index = get_cell_index(next_x, next_y);
+				if(get_value(next_index) != unreached)
+					continue;
+				
+				if(static_cast<uint16_t>(write_index - read_index) == queue_size)
+					return false;
+				
+				set_value(next_index, next_value);
+				queue[write_index++ % queue_size] = next_index;
+			}
+		}
+		
+		return true;
+	}
+	
+	///Returns wall position of the passage to the neighbour cell, which is
+	///one step closer to the exit, or zero for the exit cell
+	uint8_t get_exit_direction(const maze_grid& grid, uint8_t x, uint8_t y) const
+	{
+		const uint8_t closer_value = get_previous_value(get_value(get_cell_index(x, y)));
+		for(uint8_t pos = maze_grid::wall_up; pos != 1 << maze_grid::wall_count; pos <<= 1)
+		{
+			if(grid.has_wall(x, y, static_cast<maze_grid::wall_position>(pos)))
+				continue;
+			
+			uint8_t next_x = x, next_y = y;
+			move(next_x, next_y, static_cast<maze_grid::wall_position>(pos));
+			if(get_value(get_cell_index(next_x, next_y)) == closer_value)
+				return pos;
+		}
+		
+		return 0;
+	}
+	
+	///Returns change of distance to the exit (-1, 0 or 1) when moving
+	///from the cell to its neighbour
+	int8_t get_distance_change(uint8_t from_x, uint8_t from_y, uint8_t to_x, uint8_t to_y) const
+	{
+		const uint8_t to_value = get_value(get_cell_index(to_x, to_y));
+		const uint8_t from_value = get_value(get_cell_index(from_x, from_y));
+		if(to_value == from_value)
+			return 0;
+		
+		return to_value == get_next_value(from_value) ? 1 : -1;
+	}
+	
+	///Follows the way to the exit, so it takes time proportional to the distance
+	uint16_t get_distance(const maze_grid& grid, uint8_t x, uint8_t y) const
+	{
+		uint16_t distance = 0;
+		while(uint8_t pos = get_exit_direction(grid, x, y))
+		{
+			move(x, y, static_cast<maze_grid::wall_position>(pos));
+			++distance;
+		}
+		
+		return distance;
+	}
+	
+	///Moves coordinates to the neighbour cell behind the wall
+	static void move(uint8_t& x, uint8_t& y, maze_grid::wall_position pos)
+	{
+		switch(pos)
+		{
+			case maze_grid::wall_up:
+				--y;
+				break;
+			
+			case maze_grid::wall_down:
+				++y;
+				break;
+			
+			case maze_grid::wall_left:
+				--x;
+				break;
+			
+			default: //wall_right
+				++x;
+				break;
+		}
+	}
+	
+private:
+	static constexpr uint8_t unreached = 3;
+	
+	static uint8_t get_next_value(uint8_t value)
+	{
+		return value == 2 ? 0 : value + 1;
+	}
+	
+	static uint8_t get_previous_value(uint8_t value)
+	{
+		return value ? value - 1 : 2;
+	}
+	
+	uint16_t get_cell_index(uint8_t x, uint8_t y) const
+	{
+		return y * width_ + x;
+	}
+	
+	uint8_t get_value(uint16_t index) const
+	{
+		return (values_[index / 4] >> (index % 4 * 2)) & 3;
+	}
+	
+	void set_value(uint16_t index, uint8_t value)
+	{
+		const uint8_t shift = index % 4 * 2;
+		values_[index / 4] = (values_[index / 4] & ~(3 << shift)) | (value << shift);
+	}
+	
+private:
+	uint8_t width_;
+	//Distance to the exit modulo 3 (2 bits per cell), or unreached
+	uint8_t values_[(max_cell_count + 3) / 4];
+};
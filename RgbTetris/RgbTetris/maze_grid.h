@@ -0,0 +1,305 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util.h"
+
+///Maze walls and maze generation algorithms. Doesn't depend on
+///hardware, so mazes can be generated and checked on the host.
+///Walls are stored in two bitplanes (right and down wall of each cell),
+///as left and up walls are shared with the neighbour cells. Maze border
+///always has walls.
+class maze_grid
+{
+public:
+	enum wall_position : uint8_t
+	{
+		wall_up = 1 << 0,
+		wall_down = 1 << 1,
+		wall_left = 1 << 2,
+		wall_right = 1 << 3,
+		wall_count = 4
+	};
+	
+	static constexpr uint8_t max_size = 63;
+	static constexpr uint16_t max_cell_count = max_size * max_size;
+	static constexpr uint16_t plane_size = (max_cell_count + 7) / 8;
+	//Frontier array of growing tree algorithm takes as much memory
+	//as depth-first search path (2 bits per cell)
+	static constexpr uint16_t max_growing_tree_cell_count = plane_size;
+	//Bytes generators keep on the stack (path or frontier)
+	static constexpr uint16_t max_generation_stack = plane_size * 2;
+	
+public:
+	///Sets maze size and fills maze with walls
+	void init(uint8_t width, uint8_t height)
+	{
+		width_ = width;
+		height_ = height;
+		memset(right_passages_, 0, sizeof(right_passages_));
+		memset(down_passages_, 0, sizeof(down_passages_));
+	}
+	
+	uint8_t get_width() const
+	{
+		return width_;
+	}
+	
+	uint8_t get_height() const
+	{
+		return height_;
+	}
+	
+	bool contains(uint8_t x, uint8_t y) const
+	{
+		return x < width_ && y < height_;
+	}
+	
+	///Cell must be inside the maze
+	bool has_wall(uint8_t x, uint8_t y, wall_position pos) const
+	{
+		switch(pos)
+		{
+			case wall_up:
+				return !y || !get_bit(down_passages_, get_cell_index(x, y - 1));
+			
+			case wall_down:
+				return !get_bit(down_passages_, get_cell_index(x, y));
+			
+			case wall_left:
+				return !x || !get_bit(right_passages_, get_cell_index(x - 1, y));
+			
+			default: //wall_right
+				return !get_bit(right_passages_, get_cell_index(x, y));
+		}
+	}
+	
+	/** Randomized depth-first search (recursive backtracker), which produces
+	*   long winding passages. Path from the start cell is kept on the stack
+	*   during generation as 2-bit directions.
+	*   @param start Random border cell the generation started from
+	*   @param deepest Cell with the longest path from the start cell */
+	void generate_dfs(util::coord& start, util::coord& deepest)
+	{
+		uint8_t x, y;
+		get_start_point(x, y);
+		
+		uint8_t path[max_generation_stack];
+		uint8_t unvisited_directions[4];
+		uint8_t unvisited_directions_count;
+		start = { x, y };
+		deepest = start;
+		uint16_t level = 0, max_level = 0;
+		while(true)
+		{
+			get_unvisited_cells(x, y, unvisited_directions_count, unvisited_directions, start);
+			if(!unvisited_directions_count)
+			{
+				//Backtrack
+				if(!level)
+					break; //Finish generation
+				
+				if(level > max_level)
+				{
+					max_level = level;
+					deepest = { x, y };
+				}
+				
+				--level;
+				move(x, y, get_opposite_direction(
+					(path[level / 4] >> (level % 4 * 2)) & 3));
+				continue;
+			}
+			
+			//Take random unvisited neighbor
+			const uint8_t direction = unvisited_directions[rand() % unvisited_directions_count];
+			remove_wall(x, y, direction);
+			
+			const uint8_t shift = level % 4 * 2;
+			path[level / 4] = (path[level / 4] & ~(3 << shift)) | (direction << shift);
+			++level;
+			move(x, y, direction);
+		}
+	}
+	
+	///Growing tree algorithm with random cell selection, which produces
+	///short branchy passages. Frontier (cells which may still have unvisited
+	///neighbors) is an array of cell indices with swap-remove, so each step
+	///takes constant time. Frontier is kept on the stack during generation.
+	///Maze must not have more than max_growing_tree_cell_count cells.
+	void generate_growing_tree()
+	{
+		uint8_t x, y;
+		get_start_point(x, y);
+		
+		uint16_t frontier[max_growing_tree_cell_count];
+		static_assert(sizeof(frontier) <= max_generation_stack, "Frontier must fit into generation stack size");
+		uint8_t unvisited_directions[4];
+		uint8_t unvisited_directions_count;
+		const util::coord init_cell { x, y };
+		
+		uint16_t frontier_count = 0;
+		frontier[frontier_count++] = get_cell_index(x, y);
+		while(frontier_count)
+		{
+			const uint16_t frontier_index = rand() % frontier_count;
+			const uint16_t index = frontier[frontier_index];
+			x = index % width_;
+			y = index / width_;
+			
+			get_unvisited_cells(x, y, unvisited_directions_count, unvisited_directions, init_cell);
+			if(!unvisited_directions_count)
+			{
+				frontier[frontier_index] = frontier[--frontier_count];
+				continue;
+			}
+			
+			//Take random unvisited neighbor
+			const uint8_t direction = unvisited_directions[rand() % unvisited_directions_count];
+			remove_wall(x, y, direction);
+			move(x, y, direction);
+			frontier[frontier_count++] = get_cell_index(x, y);
+		}
+	}
+	
+	///Removes random walls of inner cells to create loops
+	void add_random_passages(uint8_t probability) //0 <= probability <= 128
+	{
+		for(uint8_t x = 1; x != width_ - 1; ++x)
+		{
+			for(uint8_t y = 1; y != height_ - 1; ++y)
+			{
+				if(rand() % 128 < probability)
+				{
+					//Bit index of wall_position (up, down, left, right) to direction
+					remove_wall(x, y, (rand() % wall_count) ^ 2);
+				}
+			}
+		}
+	}
+	
+private:
+	//Neighbour cell directions, opposite directions differ in the lowest bit
+	enum direction : uint8_t
+	{
+		direction_left,
+		direction_right,
+		direction_up,
+		direction_down
+	};
+	
+	static uint8_t get_opposite_direction(uint8_t direction)
+	{
+		return direction ^ 1;
+	}
+	
+	static void move(uint8_t& x, uint8_t& y, uint8_t direction)
+	{
+		switch(direction)
+		{
+			case direction_left:
+				--x;
+				break;
+			
+			case direction_right:
+				++x;
+				break;
+			
+			case direction_up:
+				--y;
+				break;
+			
+			default:
+				++y;
+				break;
+		}
+	}
+	
+	uint16_t get_cell_index(uint8_t x, uint8_t y) const
+	{
+		return y * width_ + x;
+	}
+	
+	static bool get_bit(const uint8_t (&plane)[plane_size], uint16_t index)
+	{
+		return plane[index / 8] & (1 << (index % 8));
+	}
+	
+	static void set_bit(uint8_t (&plane)[plane_size], uint16_t index)
+	{
+		plane[index / 8] |= 1 << (index % 8);
+	}
+	
+	///Removes wall between the cell and its neighbour in the direction
+	void remove_wall(uint8_t x, uint8_t y, uint8_t direction)
+	{
+		switch(direction)
+		{
+			case direction_left:
+				set_bit(right_passages_, get_cell_index(x - 1, y));
+				break;
+			
+			case direction_right:
+				set_bit(right_passages_, get_cell_index(x, y));
+				break;
+			
+			case direction_up:
+				set_bit(down_passages_, get_cell_index(x, y - 1));
+				break;
+			
+			default:
+				set_bit(down_passages_, get_cell_index(x, y));
+				break;
+		}
+	}
+	
+	void get_start_point(uint8_t& start_x, uint8_t& start_y) const
+	{
+		if(rand() % 2)
+		{
+			start_x = (rand() % 2) ? 0 : width_ - 1;
+			start_y = rand() % height_;
+		}
+		else
+		{
+			start_y = (rand() % 2) ? 0 : height_ - 1;
+			start_x = rand() % width_;
+		}
+	}
+	
+	void get_unvisited_cells(uint8_t x, uint8_t y,
+		uint8_t& unvisited_directions_count, uint8_t unvisited_directions[4],
+		const util::coord& init_cell) const
+	{
+		unvisited_directions_count = 0;
+		for(uint8_t direction = direction_left; direction != direction_down + 1; ++direction)
+		{
+			uint8_t next_x = x, next_y = y;
+			move(next_x, next_y, direction);
+			if(is_unvisited(next_x, next_y, init_cell))
+				unvisited_directions[unvisited_directions_count++] = direction;
+		}
+	}
+	
+	///Cell is visited by generator if any of its walls is removed.
+	///Generation starts from the init cell, which has all walls at this moment.
+	bool is_unvisited(uint8_t x, uint8_t y, const util::coord& init_cell) const
+	{
+		return contains(x, y) && (x != init_cell.x || y != init_cell.y)
+			&& has_wall(x, y, wall_up) && has_wall(x, y, wall_down)
+			&& has_wall(x, y, wall_left) && has_wall(x, y, wall_right);
+	}
+	
+private:
+	uint8_t width_;
+	uint8_t height_;
+	//Bit is set if there's no wall to the right of the cell
+	uint8_t right_passages_[plane_size];
+	//Bit is set if there's no wall below the cell
+	uint8_t down_passages_[plane_size];
+};
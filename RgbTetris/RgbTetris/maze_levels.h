@@ -0,0 +1,57 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#pragma once
+
+#include <stdint.h>
+
+#include <avr/pgmspace.h>
+
+///Maze generation algorithm of the level
+enum algo_flags : uint8_t
+{
+	algo_dfs_long_path,
+	algo_dfs_corners,
+	algo_growing_tree_corners
+};
+
+///"Maze" game level
+struct maze_level
+{
+	uint8_t width : 6;
+	uint8_t height : 6;
+	uint8_t score_multiplier : 4;
+	uint8_t allowed_time : 6; // * 10 sec
+	uint8_t cell_size : 2; // + 3
+	uint8_t flags : 3;
+	uint8_t random_passage_probability : 5; //[0 - 31] * 4
+};
+
+constexpr maze_level maze_levels[] PROGMEM = {
+	{ 3, 5, 1, 2, 1, algo_dfs_long_path, 0 },
+	{ 3, 5, 2, 3, 2, algo_dfs_long_path, 0 },
+	{ 5, 8, 3, 3, 0, algo_dfs_long_path, 0 },
+	{ 12, 5, 3, 3, 1, algo_growing_tree_corners, 0 },
+	{ 5, 16, 4, 3, 0, algo_growing_tree_corners, 0 },
+	{ 10, 10, 4, 2, 0, algo_dfs_corners, 16 },
+	{ 12, 12, 5, 4, 1, algo_dfs_long_path, 15 },
+	{ 11, 11, 5, 5, 0, algo_dfs_long_path, 3 },
+	{ 35, 35, 6, 6, 0, algo_dfs_corners, 27 },
+	{ 20, 20, 6, 9, 1, algo_growing_tree_corners, 6 },
+	{ 10, 15, 6, 8, 0, algo_dfs_long_path, 0 },
+	{ 15, 15, 7, 5, 0, algo_growing_tree_corners, 0 },
+	{ 62, 3, 7, 11, 3, algo_dfs_long_path, 0 },
+	{ 15, 15, 7, 10, 1, algo_dfs_corners, 0 },
+	{ 30, 8, 8, 11, 0, algo_dfs_long_path, 1 },
+	{ 4, 62, 8, 4, 1, algo_growing_tree_corners, 5 },
+	{ 5, 45, 9, 7, 0, algo_dfs_corners, 1 },
+	{ 20, 20, 9, 14, 0, algo_dfs_long_path, 0 },
+	{ 16, 16, 9, 16, 1, algo_dfs_long_path, 0 },
+	{ 11, 11, 9, 9, 3, algo_dfs_long_path, 0 },
+	{ 27, 18, 10, 15, 0, algo_dfs_corners, 0 },
+	{ 16, 30, 10, 25, 1, algo_dfs_long_path, 0 },
+	{ 24, 24, 11, 28, 0, algo_dfs_long_path, 0 },
+	{ 25, 30, 12, 32, 0, algo_dfs_long_path, 1 },
+	{ 32, 32, 14, 45, 0, algo_dfs_long_path, 0 },
+	{ 35, 35, 15, 63, 1, algo_dfs_long_path, 0 }
+};
@@ -14,6 +14,8 @@
 #include "font.h"
 #include "number_display.h"
 #include "options.h"
+#include "snake.h"
+#include "tetris.h"
 #include "timer.h"
 #include "ws2812_matrix.h"
 
@@ -233,6 +235,8 @@ void output_high_score(mode_selector::mode mode, uint8_t point_mask)
 
 constexpr uint8_t target_led_count = 25;
 constexpr uint8_t target_menu_letter_count = 9;
+///Idle time in menu before game demo starts
+constexpr uint16_t demo_idle_ticks = timer::ms_to_ticks(30000);
 void mode_selector::edit_options()
 {
 	current_letter = 0;
@@ -323,6 +327,7 @@ mode_selector::mode mode_selector::select_mode()
 	
 	uint8_t led_count = 0;
 	uint8_t menu_letter_count = 0;
+	uint16_t idle_ticks = 0;
 	uint16_t rand_seed = rand();
 	
 	while(!buttons::is_pressed(buttons::button_right))
@@ -331,6 +336,7 @@ mode_selector::mode mode_selector::select_mode()
 		
 		if(buttons::is_pressed(buttons::button_up))
 		{
+			idle_ticks = 0;
 			srand(rand_seed);
 			if(current_mode != max_mode - 1)
 			{
@@ -342,6 +348,7 @@ mode_selector::mode mode_selector::select_mode()
 		}
 		else if(buttons::is_pressed(buttons::button_down))
 		{
+			idle_ticks = 0;
 			srand(rand_seed);
 			if(current_mode != 0)
 			{
@@ -369,6 +376,21 @@ mode_selector::mode mode_selector::select_mode()
 		
 		++rand_seed;
 		
+		if(++idle_ticks == demo_idle_ticks)
+		{
+			idle_ticks = 0;
+			if(current_mode == mode_tetris || current_mode == mode_snake)
+			{
+				if(current_mode == mode_tetris)
+					tetris::run_demo();
+				else
+					snake::run_demo();
+				
+				output_menu_letter(current_mode, true);
+				output_high_score(static_cast<mode>(current_mode), point_mask);
+			}
+		}
+		
 		redraw_if_needed();
 	}
 	
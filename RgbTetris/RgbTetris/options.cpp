@@ -23,6 +23,10 @@ checked_uint8_t max_brightness_saved EEMEM { options::default_max_brightness, op
 checked_uint8_t accelerometer_state_saved EEMEM { options::default_accelerometer_state, options::default_accelerometer_state };
 checked_uint32_t high_score[game::max_game_id] EEMEM { };
 
+bool overridden = false;
+uint8_t max_brightness_override = 0;
+bool accelerometer_state_override = false;
+
 uint8_t calc_checksum(uint32_t value)
 {
 	return static_cast<uint8_t>(value & 0xFF)
@@ -66,8 +70,8 @@ void save_eemem_with_check(checked_uint32_t* data, uint32_t value)
 
 uint8_t options::get_max_brightness()
 {
-	uint8_t result;
-	if(!load_eemem_with_check(&max_brightness_saved, result))
+	uint8_t result = max_brightness_override;
+	if(!overridden && !load_eemem_with_check(&max_brightness_saved, result))
 		return default_max_brightness;
 	
 	if(result > max_available_brightness)
@@ -86,6 +90,9 @@ void options::set_max_brightness(uint8_t value)
 
 bool options::is_accelerometer_enabled()
 {
+	if(overridden)
+		return accelerometer_state_override;
+	
 	uint8_t result;
 	return load_eemem_with_check(&accelerometer_state_saved, result)
 		? static_cast<bool>(result) : default_accelerometer_state;
@@ -96,6 +103,18 @@ void options::set_accelerometer_enabled(bool value)
 	save_eemem_with_check(&accelerometer_state_saved, value);
 }
 
+void options::set_overrides(uint8_t max_brightness, bool accelerometer_enabled)
+{
+	overridden = true;
+	max_brightness_override = max_brightness;
+	accelerometer_state_override = accelerometer_enabled;
+}
+
+void options::clear_overrides()
+{
+	overridden = false;
+}
+
 void options::reset_high_scores()
 {
 	for(uint8_t i = 0; i != game::max_game_id; ++i)
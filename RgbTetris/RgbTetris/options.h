@@ -20,7 +20,7 @@ public:
 	static constexpr uint8_t max_available_brightness = 200;
 	static constexpr uint8_t min_available_brightness = 15;
 	static constexpr bool default_accelerometer_state = false;
-
+	
 public:
 	static uint8_t get_max_brightness();
 	static void set_max_brightness(uint8_t value);
@@ -28,6 +28,11 @@ public:
 	static bool is_accelerometer_enabled();
 	static void set_accelerometer_enabled(bool value);
 	
+	///Overrides max brightness and accelerometer state in RAM
+	///(EEPROM is not changed) until clear_overrides() call
+	static void set_overrides(uint8_t max_brightness, bool accelerometer_enabled);
+	static void clear_overrides();
+	
 	static void reset_high_scores();
 	static void reset_high_score(game::game_id id);
 	static uint32_t get_high_score(game::game_id id);
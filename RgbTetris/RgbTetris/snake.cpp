@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <avr/io.h>
 #include <avr/pgmspace.h>
 
 #include "accelerometer.h"
@@ -15,10 +16,15 @@
 #include "number_display.h"
 #include "options.h"
 #include "queue.h"
+#include "snake_ai.h"
 #include "timer.h"
 #include "util.h"
 #include "ws2812_matrix.h"
 
+#ifndef RAMSIZE
+#	define RAMSIZE (RAMEND - RAMSTART + 1)
+#endif //RAMSIZE
+
 namespace
 {
 enum class direction : uint8_t
@@ -61,46 +67,122 @@ using snake_queue = queue<util::round_to_power_of_2(ws2812_matrix::width * ws281
 	snake_coord>;
 
 constexpr uint16_t max_snake_length = ws2812_matrix::width * ws2812_matrix::height;
+static_assert(max_snake_length <= UINT8_MAX, "Cell index must fit into 8 bits");
+
+///Snake occupancy, kept in sync with snake_queue
+struct snake_field
+{
+	static constexpr uint8_t byte_count = (max_snake_length + 7) / 8;
+	
+	//Bit (y * width + x) is set if cell is occupied by snake
+	uint8_t cells[byte_count];
+	uint8_t free_count;
+};
+
+///Snake color wave. Colors of the last wave steps are stored in a ring,
+///so the segment which is N segments away from the head has the color
+///the head had N steps ago, and each step calculates the head color only.
+///Ring takes 3 * 160 = 480 bytes of stack while the game runs. It keeps full
+///colors, because a segment color depends on the gradient colors and step count
+///of its own step (they change when food is eaten and snake grows), so it can't
+///be derived from a per-segment phase.
+struct snake_wave
+{
+	color::rgb colors[max_snake_length];
+	uint8_t head_color_index;
+	color::rgb prev_color, current_color;
+	uint16_t step;
+};
+
+using autopilot = snake_ai<ws2812_matrix::width, ws2812_matrix::height>;
+
+//Game loop keeps these on the stack, and autopilot search adds its scratch buffers
+static_assert(sizeof(snake_wave) + sizeof(snake_queue) + sizeof(snake_field)
+	+ sizeof(autopilot) + autopilot::search_stack < RAMSIZE - 1500,
+	"Too big snake game state");
+static_assert(autopilot::cell_count == max_snake_length, "Autopilot must cover the whole field");
+
+constexpr uint16_t demo_game_over_ticks = timer::ms_to_ticks(1100);
 
 constexpr uint8_t food_color_change_count = 15;
 constexpr uint8_t snake_color_change_count = 5;
 constexpr uint8_t max_snake_wave_steps = 16;
 
-bool move_head(snake_queue& snake_data, uint8_t x, uint8_t y, bool pop_tail)
+uint8_t get_cell_index(uint8_t x, uint8_t y)
+{
+	return y * ws2812_matrix::width + x;
+}
+
+bool is_occupied(const snake_field& field, uint8_t x, uint8_t y)
+{
+	const uint8_t index = get_cell_index(x, y);
+	return field.cells[index / 8] & (1 << (index % 8));
+}
+
+void init_field(snake_field& field)
 {
+	memset(field.cells, 0, sizeof(field.cells));
+	field.free_count = max_snake_length;
+	
+	//Bits after the last cell are never free
+	for(uint8_t index = max_snake_length; index != snake_field::byte_count * 8; ++index)
+		field.cells[index / 8] |= 1 << (index % 8);
+}
+
+bool move_head(snake_queue& snake_data, snake_field& field, uint8_t x, uint8_t y, bool pop_tail)
+{
+	uint8_t index;
 	if(pop_tail)
 	{
 		snake_coord tail;
 		if(snake_data.pop_front(tail))
+		{
 			ws2812_matrix::clear_pixel(tail.x, tail.y);
+			index = get_cell_index(tail.x, tail.y);
+			field.cells[index / 8] &= ~(1 << (index % 8));
+			++field.free_count;
+		}
 	}
 	
-	return snake_data.push_back({ x, y });
+	if(!snake_data.push_back({ x, y }))
+		return false;
+	
+	index = get_cell_index(x, y);
+	field.cells[index / 8] |= 1 << (index % 8);
+	--field.free_count;
+	return true;
 }
 
-bool create_food(const snake_queue& snake_data,
-	color::rgb& food_color, uint8_t max_brightness, util::coord& food)
+///Returns index of free cell with specified rank (0 is the first free cell).
+///Skips whole bytes using their free cell count.
+uint8_t select_free_cell(const snake_field& field, uint8_t rank)
 {
-	if(snake_data.count() >= max_snake_length)
-		return false;
+	uint8_t i = 0;
+	uint8_t free_cells = ~field.cells[0];
+	for(uint8_t count; rank >= (count = util::count_bits(free_cells)); free_cells = ~field.cells[++i])
+		rank -= count;
 	
-	food.x = rand() % ws2812_matrix::width;
-	food.y = rand() % ws2812_matrix::height;
-	
-	while(ws2812_matrix::is_on(food))
+	uint8_t bit = 0;
+	for(;; ++bit)
 	{
-		++food.x;
-		if(food.x == ws2812_matrix::width)
-		{
-			food.x = 0;
-			++food.y;
-			if(food.y == ws2812_matrix::height)
-			{
-				food.y = 0;
-			}
-		}
+		if((free_cells & (1 << bit)) && !rank--)
+			break;
 	}
 	
+	return i * 8 + bit;
+}
+
+///Places food to uniformly chosen free cell
+bool create_food(const snake_field& field,
+	color::rgb& food_color, uint8_t max_brightness, util::coord& food)
+{
+	if(!field.free_count)
+		return false;
+	
+	const uint8_t index = select_free_cell(field, rand() % field.free_count);
+	food.x = index % ws2812_matrix::width;
+	food.y = index / ws2812_matrix::width;
+	
 	game::get_random_color(food_color, max_brightness);
 	return true;
 }
@@ -124,45 +206,60 @@ void set_difficulty(uint32_t score, bool accelerometer_enabled,
 	}
 }
 
-void snake_color_wave(const snake_queue& snake_data,
-	color::rgb& prev_color, color::rgb& current_color, uint16_t& snake_wave_step_count)
+void draw_snake(const snake_queue& snake_data, const snake_wave& wave)
 {
-	snake_coord coord {0, 0}, prev_coord {0, 0};
-	color::rgb rgb;
-	uint8_t count = static_cast<uint8_t>(snake_data.count());
-	uint8_t step_count = util::max(max_snake_wave_steps, count);
-	uint16_t doubled_step_count = static_cast<uint16_t>(step_count) * 2;
-	
-	snake_data.get(coord, count - 1);
-	color::gradient(prev_color, current_color,
-		step_count, static_cast<uint16_t>(snake_wave_step_count) % doubled_step_count, rgb);
-	ws2812_matrix::set_pixel_color(coord.x, coord.y, rgb);
-	
-	snake_data.get(coord, 0);
-	for(uint8_t i = 0; i != count - 1; ++i)
+	snake_coord coord {0, 0};
+	uint8_t color_index = wave.head_color_index;
+	for(uint8_t i = static_cast<uint8_t>(snake_data.count()); i; --i)
 	{
-		snake_data.get(prev_coord, i + 1);
-		
-		ws2812_matrix::get_pixel_color(prev_coord.x, prev_coord.y, rgb.r, rgb.g, rgb.b);
-		ws2812_matrix::set_pixel_color(coord.x, coord.y, rgb);
+		snake_data.get(coord, i - 1);
+		const color::rgb& rgb = wave.colors[color_index];
+		ws2812_matrix::set_pixel_color_fast(coord.x, coord.y, rgb.r, rgb.g, rgb.b);
 		
-		coord = prev_coord;
+		color_index = color_index ? color_index - 1 : max_snake_length - 1;
 	}
+}
+
+///Calculates color of the next wave step and puts it to the head of color ring
+void advance_wave(const snake_queue& snake_data, snake_wave& wave)
+{
+	uint8_t step_count = util::max(max_snake_wave_steps, static_cast<uint8_t>(snake_data.count()));
+	uint16_t doubled_step_count = static_cast<uint16_t>(step_count) * 2;
+	
+	if(++wave.head_color_index == max_snake_length)
+		wave.head_color_index = 0;
+	
+	color::gradient(wave.prev_color, wave.current_color,
+		step_count, wave.step % doubled_step_count, wave.colors[wave.head_color_index]);
 	
-	if(++snake_wave_step_count >= doubled_step_count)
-		snake_wave_step_count = 0;
+	if(++wave.step >= doubled_step_count)
+		wave.step = 0;
 }
 
-void restore_snake(const snake_queue& snake_data,
-	color::rgb& prev_color, color::rgb& current_color, uint16_t& snake_wave_step_count)
+void snake_color_wave(const snake_queue& snake_data, snake_wave& wave)
 {
+	advance_wave(snake_data, wave);
+	draw_snake(snake_data, wave);
+}
+
+void init_wave(const snake_queue& snake_data, snake_wave& wave, uint8_t max_brightness)
+{
+	game::get_random_color(wave.current_color, max_brightness);
+	game::get_random_color(wave.prev_color, max_brightness);
+	wave.head_color_index = 0;
+	wave.step = 0;
+	
+	//Fill colors of all segments
 	for(uint8_t i = 0, count = snake_data.count(); i != count; ++i)
-		snake_color_wave(snake_data, prev_color, current_color, snake_wave_step_count);
+		advance_wave(snake_data, wave);
+	
+	draw_snake(snake_data, wave);
 }
 
-void init(snake_queue& snake_data, direction& snake_direction)
+void init(snake_queue& snake_data, snake_field& field, direction& snake_direction)
 {
 	snake_data.clear();
+	init_field(field);
 	
 	//Generate random initial direction
 	snake_direction = static_cast<direction>(rand() % static_cast<uint8_t>(direction::max));
@@ -199,7 +296,7 @@ void init(snake_queue& snake_data, direction& snake_direction)
 	
 	//Create snake
 	for(uint8_t i = 0; i != snake::init_len; ++i, *coord_to_grow += add)
-		move_head(snake_data, start_x, start_y, false);
+		move_head(snake_data, field, start_x, start_y, false);
 }
 
 bool get_head(const snake_queue& snake_data, uint8_t& x, uint8_t& y)
@@ -224,35 +321,77 @@ void food_blink(const color::rgb& food_color, const util::coord& food)
 		ws2812_matrix::set_pixel_color(food, food_color);
 }
 
-uint32_t loop(snake_queue& snake_data, direction snake_direction)
+///Occupancy functor for autopilot
+struct field_occupancy
+{
+	const snake_field* field;
+	
+	bool operator()(uint8_t x, uint8_t y) const
+	{
+		return is_occupied(*field, x, y);
+	}
+};
+
+///Returns direction to the cell chosen by autopilot
+direction get_demo_direction(autopilot& ai, const snake_queue& snake_data,
+	const snake_field& field, const util::coord& food, direction snake_direction)
+{
+	uint8_t x = 0, y = 0;
+	get_head(snake_data, x, y);
+	const uint8_t head_x = x, head_y = y;
+	
+	snake_coord tail {0, 0};
+	snake_data.get(tail, 0);
+	if(!ai.get_next_cell(field_occupancy { &field }, static_cast<uint8_t>(snake_data.count()),
+		tail.x, tail.y, food.x, food.y, x, y))
+	{
+		return snake_direction;
+	}
+	
+	if(x > head_x)
+		return direction::left;
+	if(x < head_x)
+		return direction::right;
+	if(y > head_y)
+		return direction::fwd;
+	
+	return direction::back;
+}
+
+///Runs game until game over or exit. In demo mode snake is controlled
+///by autopilot, and any button press exits the game.
+///Returns true if game was interrupted.
+bool loop(snake_queue& snake_data, snake_field& field, direction snake_direction,
+	uint32_t& score, bool demo)
 {
 	uint8_t action_counter = 0;
 	direction new_direction = snake_direction;
 	uint8_t food_color_change_counter = food_color_change_count - 1;
 	uint8_t snake_color_change_counter = snake_color_change_count - 1;
-	const bool accelerometer_enabled = options::is_accelerometer_enabled();
-	uint32_t score = 0;
+	const bool accelerometer_enabled = !demo && options::is_accelerometer_enabled();
+	autopilot ai;
+	score = 0;
 	uint8_t difficulty, multiplier;
 	set_difficulty(score, accelerometer_enabled, difficulty, multiplier);
 	util::coord food { 0, 0 };
-	color::rgb snake_prev_color, snake_current_color;
 	const uint8_t max_brightness = options::get_max_brightness();
-	game::get_random_color(snake_current_color, max_brightness);
-	game::get_random_color(snake_prev_color, max_brightness);
-	
-	uint16_t snake_wave_step_count = 0;
-	restore_snake(snake_data, snake_prev_color,
-		snake_current_color, snake_wave_step_count);
+	snake_wave wave;
+	init_wave(snake_data, wave, max_brightness);
 	
 	color::rgb food_color;
-	create_food(snake_data, food_color, max_brightness, food);
+	create_food(field, food_color, max_brightness, food);
 	
 	uint8_t steps_to_food = max_steps_to_food_bonus;
 	while(true)
 	{
 		timer::wait_for_interrupt();
 		
-		if(accelerometer_enabled)
+		if(demo)
+		{
+			if(buttons::is_any_pressed())
+				return true;
+		}
+		else if(accelerometer_enabled)
 		{
 			switch(accelerometer::get_exclusive_direction())
 			{
@@ -299,8 +438,7 @@ uint32_t loop(snake_queue& snake_data, direction snake_direction)
 			
 			//Force snake re-draw
 			number_display::output_number(score);
-			restore_snake(snake_data, snake_prev_color,
-				snake_current_color, snake_wave_step_count);
+			draw_snake(snake_data, wave);
 			snake_color_change_counter = snake_color_change_count - 1;
 		}
 		
@@ -308,6 +446,9 @@ uint32_t loop(snake_queue& snake_data, direction snake_direction)
 		{
 			action_counter = 0;
 			
+			if(demo)
+				new_direction = get_demo_direction(ai, snake_data, field, food, snake_direction);
+			
 			if(new_direction != snake_direction)
 			{
 				//Opposite direction is not allowed
@@ -345,7 +486,7 @@ uint32_t loop(snake_queue& snake_data, direction snake_direction)
 						--new_x;
 					}
 					break;
-					
+				
 				case direction::fwd:
 					if(new_y < ws2812_matrix::height - 1)
 					{
@@ -353,7 +494,7 @@ uint32_t loop(snake_queue& snake_data, direction snake_direction)
 						++new_y;
 					}
 					break;
-					
+				
 				case direction::back:
 					if(new_y)
 					{
@@ -361,7 +502,7 @@ uint32_t loop(snake_queue& snake_data, direction snake_direction)
 						--new_y;
 					}
 					break;
-					
+				
 				default:
 					break;
 			}
@@ -370,10 +511,10 @@ uint32_t loop(snake_queue& snake_data, direction snake_direction)
 				break;
 			
 			bool has_food = new_x == food.x && new_y == food.y;
-			if(ws2812_matrix::is_on_fast(new_x, new_y) && !has_food) //Snake collision
+			if(is_occupied(field, new_x, new_y)) //Snake collision
 				break;
 			
-			move_head(snake_data, new_x, new_y, !has_food);
+			move_head(snake_data, field, new_x, new_y, !has_food);
 			
 			if(has_food)
 			{
@@ -387,18 +528,17 @@ uint32_t loop(snake_queue& snake_data, direction snake_direction)
 					set_difficulty(score, accelerometer_enabled, difficulty, multiplier);
 				}
 				
-				if(snake_current_color != food_color)
+				if(wave.current_color != food_color)
 				{
-					snake_prev_color = snake_current_color;
-					snake_current_color = food_color;
-					snake_wave_step_count = snake_data.count();
+					wave.prev_color = wave.current_color;
+					wave.current_color = food_color;
+					wave.step = snake_data.count();
 				}
 				
 				//Redraw snake before creating food
-				snake_color_wave(snake_data, snake_prev_color,
-					snake_current_color, snake_wave_step_count);
+				snake_color_wave(snake_data, wave);
 				
-				if(!create_food(snake_data, food_color, max_brightness, food)) //No more place
+				if(!create_food(field, food_color, max_brightness, food)) //No more place
 					break;
 				
 				steps_to_food = max_steps_to_food_bonus;
@@ -416,8 +556,7 @@ uint32_t loop(snake_queue& snake_data, direction snake_direction)
 		if(++snake_color_change_counter == snake_color_change_count)
 		{
 			snake_color_change_counter = 0;
-			snake_color_wave(snake_data, snake_prev_color,
-				snake_current_color, snake_wave_step_count);
+			snake_color_wave(snake_data, wave);
 			ws2812_matrix::show();
 		}
 		else if(++food_color_change_counter == food_color_change_count)
@@ -428,7 +567,22 @@ uint32_t loop(snake_queue& snake_data, direction snake_direction)
 		}
 	}
 	
-	return score;
+	return false;
+}
+
+///Keeps final game field on display for a while.
+///Any button press skips the delay, returns true in this case.
+bool wait_after_game_over()
+{
+	buttons::flush_pressed();
+	for(uint16_t i = 0; i != demo_game_over_ticks; ++i)
+	{
+		timer::wait_for_interrupt();
+		if(buttons::is_any_pressed())
+			return true;
+	}
+	
+	return false;
 }
 } //namespace
 
@@ -440,10 +594,35 @@ void snake::run()
 	
 	{
 		snake_queue snake_data;
+		snake_field field;
 		direction snake_direction;
-		init(snake_data, snake_direction);
-		score = loop(snake_data, snake_direction);
+		init(snake_data, field, snake_direction);
+		loop(snake_data, field, snake_direction, score, false);
 	}
 	
 	game::end(score, game::game_snake);
 }
+
+void snake::run_demo()
+{
+	buttons::flush_pressed();
+	
+	uint32_t score;
+	while(true)
+	{
+		ws2812_matrix::clear();
+		number_display::output_number(0);
+		
+		snake_queue snake_data;
+		snake_field field;
+		direction snake_direction;
+		init(snake_data, field, snake_direction);
+		if(loop(snake_data, field, snake_direction, score, true) || wait_after_game_over())
+			break;
+	}
+	
+	buttons::flush_pressed();
+	ws2812_matrix::clear();
+	ws2812_matrix::show();
+	number_display::clear();
+}
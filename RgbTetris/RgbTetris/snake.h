@@ -17,4 +17,8 @@ public:
 	
 public:
 	static void run();
+	
+	///Runs autopilot demo until any button is pressed.
+	///Autopilot fills the whole field, so the demo also stress tests the game.
+	static void run_demo();
 };
@@ -0,0 +1,248 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#pragma once
+
+#include <stdint.h>
+
+///Snake autopilot. Snake follows a Hamiltonian cycle over the field, so it
+///never gets trapped and eventually fills the whole field. While the field is
+///mostly free, it takes shortcuts towards food (chosen by breadth-first search
+///over free cells) which skip part of the cycle, but never overtake the tail
+///in cycle order.
+template<uint8_t Width, uint8_t Height>
+class snake_ai
+{
+	static_assert(Width % 2 == 0, "Hamiltonian cycle requires even field width");
+	static_assert(Width * Height < UINT8_MAX, "Cell index must fit into 8 bits");
+	
+public:
+	static constexpr uint8_t cell_count = Width * Height;
+	static constexpr uint8_t unreachable = UINT8_MAX;
+	
+	//Shortcuts are not taken if less than this number of cells is free
+	static constexpr uint8_t min_free_cells_for_shortcuts = cell_count / 2;
+	//Extra free cells kept ahead of the head when taking a shortcut
+	static constexpr uint8_t free_cells_margin = 4;
+	//Bytes get_next_cell() keeps on the stack (distances and search queue)
+	static constexpr uint16_t search_stack = cell_count * 2;
+	
+public:
+	snake_ai()
+		:cycle_steps_(0),
+		ordered_(false)
+	{
+	}
+	
+	///Must be called when a new snake is created
+	void start()
+	{
+		cycle_steps_ = 0;
+		ordered_ = false;
+	}
+	
+	/** Chooses the next head cell.
+	*   @param is_occupied Functor (x, y), returns true if cell is occupied by snake
+	*   @param length Snake length
+	*   @param x Head X coordinate on input, next head X coordinate on output
+	*   @param y Head Y coordinate on input, next head Y coordinate on output
+	*   @returns false if all neighbour cells are occupied */
+	template<typename IsOccupied>
+	bool get_next_cell(const IsOccupied& is_occupied, uint8_t length,
+		uint8_t tail_x, uint8_t tail_y, uint8_t food_x, uint8_t food_y, uint8_t& x, uint8_t& y)
+	{
+		const uint8_t head = get_cycle_index(x, y);
+		uint8_t distances[cell_count];
+		
+		if(ordered_)
+			return get_ordered_next_cell(is_occupied, length, head, tail_x, tail_y, food_x, food_y, distances, x, y);
+		
+		//Initial snake is placed randomly. It's ordered along the cycle
+		//after it makes as many cycle steps in a row as its length.
+		const bool found = get_unordered_next_cell(is_occupied, head, distances, x, y);
+		if(found && get_cycle_distance(head, get_cycle_index(x, y)) == 1)
+			ordered_ = ++cycle_steps_ >= length;
+		else
+			cycle_steps_ = 0;
+		
+		return found;
+	}
+	
+	///Returns position of a cell in the cycle. Cycle goes up even columns
+	///and down odd columns (excluding row 0), then returns along row 0.
+	static uint8_t get_cycle_index(uint8_t x, uint8_t y)
+	{
+		if(!y)
+			return cell_count - 1 - x;
+		
+		const uint8_t column_start = x * (Height - 1);
+		return (x & 1) ? column_start + Height - 1 - y : column_start + y - 1;
+	}
+	
+	///Returns number of cycle steps from one cell to another
+	static uint8_t get_cycle_distance(uint8_t from, uint8_t to)
+	{
+		return to >= from ? to - from : cell_count - from + to;
+	}
+	
+private:
+	static constexpr uint8_t neighbour_count = 4;
+	
+	static uint8_t get_cell_index(uint8_t x, uint8_t y)
+	{
+		return y * Width + x;
+	}
+	
+	static bool get_neighbour(uint8_t x, uint8_t y, uint8_t index, uint8_t& next_x, uint8_t& next_y)
+	{
+		next_x = x;
+		next_y = y;
+		switch(index)
+		{
+			case 0:
+				return ++next_x != Width;
+			
+			case 1:
+				return next_x-- != 0;
+			
+			case 2:
+				return ++next_y != Height;
+			
+			default:
+				return next_y-- != 0;
+		}
+	}
+	
+	///Takes the next cycle cell or a shortcut which doesn't overtake the tail
+	///and doesn't skip food. Of these cells, the closest to food is taken,
+	///then the farthest along the cycle.
+	template<typename IsOccupied>
+	static bool get_ordered_next_cell(const IsOccupied& is_occupied, uint8_t length, uint8_t head,
+		uint8_t tail_x, uint8_t tail_y, uint8_t food_x, uint8_t food_y,
+		uint8_t (&distances)[cell_count], uint8_t& x, uint8_t& y)
+	{
+		const uint8_t tail_distance = get_cycle_distance(head, get_cycle_index(tail_x, tail_y));
+		const uint8_t food_distance = get_cycle_distance(head, get_cycle_index(food_x, food_y));
+		//Free cells between tail and head in cycle order, which were skipped by previous shortcuts
+		const uint8_t skipped_cells = cell_count + 1 - tail_distance - length;
+		
+		//Longest allowed jump along the cycle. Free cells left ahead of the head
+		//(tail_distance - 1 - distance) must not be less than skipped cells
+		//(skipped_cells + distance - 1) plus free_cells_margin, otherwise eating
+		//several foods in a row may leave no free cell ahead of the head.
+		uint8_t max_distance = 1;
+		if(cell_count - length >= min_free_cells_for_shortcuts
+			&& tail_distance > skipped_cells + free_cells_margin + 2)
+		{
+			max_distance = (tail_distance - skipped_cells - free_cells_margin) / 2;
+			if(food_distance && food_distance < max_distance)
+				max_distance = food_distance;
+		}
+		
+		if(max_distance > 1)
+			find_distances(is_occupied, food_x, food_y, distances);
+		
+		bool found = false;
+		uint8_t best_x = 0, best_y = 0;
+		uint8_t best_distance = 0, best_food_steps = unreachable;
+		for(uint8_t i = 0; i != neighbour_count; ++i)
+		{
+			uint8_t next_x, next_y;
+			if(!get_neighbour(x, y, i, next_x, next_y) || is_occupied(next_x, next_y))
+				continue;
+			
+			const uint8_t distance = get_cycle_distance(head, get_cycle_index(next_x, next_y));
+			if(distance > max_distance)
+				continue;
+			
+			const uint8_t food_steps = max_distance > 1
+				? distances[get_cell_index(next_x, next_y)] : unreachable;
+			if(!found || food_steps < best_food_steps
+				|| (food_steps == best_food_steps && distance > best_distance))
+			{
+				found = true;
+				best_x = next_x;
+				best_y = next_y;
+				best_distance = distance;
+				best_food_steps = food_steps;
+			}
+		}
+		
+		if(!found)
+			return get_unordered_next_cell(is_occupied, head, distances, x, y);
+		
+		x = best_x;
+		y = best_y;
+		return true;
+	}
+	
+	///Takes the free cell with the largest reachable area, then the closest
+	///along the cycle, so the snake doesn't get trapped until it's ordered
+	template<typename IsOccupied>
+	static bool get_unordered_next_cell(const IsOccupied& is_occupied, uint8_t head,
+		uint8_t (&distances)[cell_count], uint8_t& x, uint8_t& y)
+	{
+		const uint8_t head_x = x, head_y = y;
+		bool found = false;
+		uint8_t best_area = 0, best_distance = 0;
+		for(uint8_t i = 0; i != neighbour_count; ++i)
+		{
+			uint8_t next_x, next_y;
+			if(!get_neighbour(head_x, head_y, i, next_x, next_y) || is_occupied(next_x, next_y))
+				continue;
+			
+			const uint8_t area = find_distances(is_occupied, next_x, next_y, distances);
+			const uint8_t distance = get_cycle_distance(head, get_cycle_index(next_x, next_y));
+			if(!found || area > best_area || (area == best_area && distance < best_distance))
+			{
+				found = true;
+				x = next_x;
+				y = next_y;
+				best_area = area;
+				best_distance = distance;
+			}
+		}
+		
+		return found;
+	}
+	
+	///Breadth-first search from the cell over free cells, stores number
+	///of steps to the cell for each cell. Returns number of reached cells.
+	template<typename IsOccupied>
+	static uint8_t find_distances(const IsOccupied& is_occupied, uint8_t from_x, uint8_t from_y,
+		uint8_t (&distances)[cell_count])
+	{
+		for(uint8_t i = 0; i != cell_count; ++i)
+			distances[i] = unreachable;
+		
+		uint8_t cells[cell_count];
+		uint8_t read_index = 0, write_index = 0;
+		cells[write_index++] = get_cell_index(from_x, from_y);
+		distances[cells[0]] = 0;
+		while(read_index != write_index)
+		{
+			const uint8_t cell = cells[read_index++];
+			const uint8_t x = cell % Width, y = cell / Width;
+			for(uint8_t i = 0; i != neighbour_count; ++i)
+			{
+				uint8_t next_x, next_y;
+				if(!get_neighbour(x, y, i, next_x, next_y))
+					continue;
+				
+				const uint8_t next = get_cell_index(next_x, next_y);
+				if(distances[next] == unreachable && !is_occupied(next_x, next_y))
+				{
+					distances[next] = distances[cell] + 1;
+					cells[write_index++] = next;
+				}
+			}
+		}
+		
+		return write_index;
+	}
+	
+private:
+	//Number of cycle steps made in a row before snake is ordered
+	uint8_t cycle_steps_;
+	bool ordered_;
+};
@@ -10,9 +10,11 @@
 #include <avr/pgmspace.h>
 
 #include "accelerometer.h"
+#include "animation.h"
 #include "bitmap.h"
 #include "buttons.h"
 #include "colors.h"
+#include "entity_pool.h"
 #include "game.h"
 #include "move_helper.h"
 #include "number_display.h"
@@ -54,10 +56,13 @@ struct alien
 struct loaded_alien : alien
 {
 	uint8_t current_lives;
+	//Scaled color, updated when current lives change (see update_alien_color)
+	color::rgb rgb;
 };
 
 constexpr uint8_t boss_frame_count = 2;
 constexpr uint8_t max_weak_points = 2;
+constexpr uint8_t max_boss_height = 8;
 struct weak_point
 {
 	uint8_t x : 4;
@@ -114,7 +119,7 @@ const boss_level boss_levels[] PROGMEM = {
 	{ 200,  0xF, 0xF, 0xF,  0, 0xF, 0x3,  8, 8, { boss_1_frame_0, boss_1_frame_1 }, { { 2, 3 }, { 5, 3 } } }
 };
 
-const level_info levels[] PROGMEM = {
+constexpr level_info levels[] PROGMEM = {
 	{ 1, 0, level_type_usual },
 	{ 1, 1, level_type_usual },
 	{ 1, 1, level_type_usual },
@@ -140,6 +145,27 @@ const level_info levels[] PROGMEM = {
 	{ 6, 6, level_type_boss }
 };
 
+///Returns number of boss levels before the level
+constexpr uint8_t count_boss_levels(uint8_t level_id)
+{
+	return level_id ? count_boss_levels(level_id - 1) + (levels[level_id - 1].type == level_type_boss) : 0;
+}
+
+///Index in boss_levels for each level (only boss level values are used)
+const uint8_t boss_level_index[] PROGMEM = {
+	count_boss_levels(0), count_boss_levels(1), count_boss_levels(2), count_boss_levels(3),
+	count_boss_levels(4), count_boss_levels(5), count_boss_levels(6), count_boss_levels(7),
+	count_boss_levels(8), count_boss_levels(9), count_boss_levels(10), count_boss_levels(11),
+	count_boss_levels(12), count_boss_levels(13), count_boss_levels(14), count_boss_levels(15),
+	count_boss_levels(16), count_boss_levels(17), count_boss_levels(18), count_boss_levels(19),
+	count_boss_levels(20), count_boss_levels(21), count_boss_levels(22)
+};
+
+static_assert(sizeof(boss_level_index) == sizeof(levels) / sizeof(levels[0]),
+	"Each level must have boss level index");
+static_assert(count_boss_levels(sizeof(levels) / sizeof(levels[0]))
+	== sizeof(boss_levels) / sizeof(boss_levels[0]), "Each boss level must have boss");
+
 constexpr alien level_end { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 
 constexpr uint8_t h = ws2812_matrix::height;
@@ -476,6 +502,20 @@ const alien alien_level_19[] PROGMEM = {
 	level_end
 };
 
+//Alien formation is drawn once when level is loaded. After that only leading and trailing
+//edges of moved aliens and rectangles of hit aliens are redrawn (see update_aliens), and
+//alien colors are recalculated only when aliens lose lives. Previously the whole formation
+//was cleared before each move and recalculated and redrawn after each bullet step (about
+//36 times per second): about 1000 cycles per alien color (6 divisions) and 50 cycles
+//per bounds-checked pixel. For the densest levels (cycles per redraw, cycles per move now):
+//- alien_level_9 (16 aliens, 32 pixels): ~17600 each redraw; 32 edge pixels per lateral
+//  and 64 per downward move, ~200 cycles each (~6400 and ~12800).
+//- alien_level_18 (16 aliens, 65 pixels): ~19300 each redraw; 68 and 58 edge pixels
+//  (~13600 and ~11600).
+//- alien_level_19 (12 aliens, 84 pixels): ~16200 each redraw; 56 and 56 edge pixels,
+//  ~170 cycles each (~9500).
+//Bullet steps don't redraw aliens at all, which saves 600000 - 700000 cycles per second
+//(about 4% of CPU time) on these levels.
 const alien* const level_map[] PROGMEM = {
 	alien_level_0,
 	alien_level_1,
@@ -502,6 +542,12 @@ const alien* const level_map[] PROGMEM = {
 	nullptr //boss level 4
 };
 
+///Decoded boss frame, bit X of row Y is set if boss pixel (X, Y) is on
+struct boss_frame_rows
+{
+	uint16_t rows[max_boss_height];
+};
+
 constexpr uint8_t max_aliens = 16;
 struct loaded_level
 {
@@ -525,6 +571,7 @@ struct loaded_level
 			uint8_t boss_max_lives;
 			uint8_t boss_x;
 			uint8_t boss_y;
+			boss_frame_rows boss_frames[boss_frame_count];
 		};
 	};
 };
@@ -573,85 +620,160 @@ const gun_color gun_color_map[] PROGMEM = {
 struct bullet
 {
 	util::coord coords;
-	uint8_t is_valid;
+};
+
+using bullet_pool = entity_pool<bullet, max_bullet_count>;
+
+//Collision map cell: bits 0-4 hold entity (alien index + 1, boss or boss weak point),
+//bit 7 is set if there's a player bullet. Alien bullets are not stored in the map.
+constexpr uint8_t entity_none = 0;
+constexpr uint8_t entity_alien_first = 1;
+constexpr uint8_t entity_boss = entity_alien_first + max_aliens;
+constexpr uint8_t entity_boss_weak_point = entity_boss + 1;
+constexpr uint8_t entity_mask = 0x1f;
+constexpr uint8_t player_bullet_flag = 0x80;
+
+///Persistent collision map. It is updated incrementally when aliens, boss and
+///player bullets move, so each collision check is a single cell lookup.
+struct collision_map
+{
+	collision_map()
+	{
+		memset(cells, 0, sizeof(cells));
+	}
+	
+	uint8_t cells[ws2812_matrix::height][ws2812_matrix::width];
 };
 
 struct bullet_info
 {
-	bullet_info()
+	explicit bullet_info(uint8_t map_flag)
 		:bullet_counter(0),
-		bullet_count(0)
+		map_flag(map_flag)
 	{
-		memset(bullets, 0, sizeof(bullets));
 	}
 	
 	uint8_t bullet_counter;
-	uint8_t bullet_count;
-	bullet bullets[max_bullet_count];
+	//Collision map flag of these bullets, 0 if bullets are not stored in the map
+	uint8_t map_flag;
+	bullet_pool bullets;
 };
 
-void load_level(uint8_t level_id, loaded_level& level)
+uint8_t get_entity(const collision_map& map, const util::coord& coords)
 {
-	memcpy_P(&level.info, &levels[level_id], sizeof(level.info));
-	level.info.fall_speed = 0b111 - level.info.fall_speed;
-	level.info.move_speed = 0b111 - level.info.move_speed;
-	level.alien_count = 0;
+	return map.cells[coords.y][coords.x] & entity_mask;
+}
+
+void set_entity(collision_map& map, uint8_t x, uint8_t y, uint8_t entity)
+{
+	map.cells[y][x] = (map.cells[y][x] & ~entity_mask) | entity;
+}
+
+///Aliens may overlap, in this case the first alive alien in level order is hit,
+///and the last one is drawn on top. Returns entity of the first alien or entity_none,
+///top_alien is set to index of the last alien.
+uint8_t find_alien_entity(const loaded_level& level, uint8_t x, uint8_t y, uint8_t& top_alien)
+{
+	uint8_t entity = entity_none;
+	for(uint8_t i = 0; i != level.alien_count; ++i)
+	{
+		const loaded_alien& obj = level.aliens[i];
+		if(obj.current_lives && x >= obj.init_x && x <= obj.init_x + obj.width
+			&& y >= obj.init_y && y <= obj.init_y + obj.height)
+		{
+			if(entity == entity_none)
+				entity = entity_alien_first + i;
+			
+			top_alien = i;
+		}
+	}
 	
-	if(level.info.type == level_type_boss)
+	return entity;
+}
+
+///Updates alien entities of map cells in the rectangle and redraws its pixels
+///with cached alien colors. Rows above the matrix are skipped, X coordinates
+///must be inside the matrix.
+void update_aliens(collision_map& map, const loaded_level& level,
+	uint8_t from_x, uint8_t to_x, uint8_t from_y, uint8_t to_y)
+{
+	if(to_y > ws2812_matrix::height)
+		to_y = ws2812_matrix::height;
+	
+	for(uint8_t y = from_y; y < to_y; ++y)
 	{
-		uint8_t boss_level_id = 0;
-		level.boss_frame_number = 0;
-		
+		for(uint8_t x = from_x; x != to_x; ++x)
 		{
-			//Count current boss level number
-			level_info info;
-			for(uint8_t i = 0; i != level_id; ++i)
+			uint8_t top_alien;
+			const uint8_t entity = find_alien_entity(level, x, y, top_alien);
+			set_entity(map, x, y, entity);
+			if(entity == entity_none)
 			{
-				memcpy_P(&info, &levels[i], sizeof(info));
-				if(info.type == level_type_boss)
-					++boss_level_id;
+				ws2812_matrix::set_pixel_color_fast(x, y, 0, 0, 0);
+			}
+			else
+			{
+				const color::rgb& rgb = level.aliens[top_alien].rgb;
+				ws2812_matrix::set_pixel_color_fast(x, y, rgb.r, rgb.g, rgb.b);
 			}
 		}
-		
-		memcpy_P(&level.boss_level_info, &boss_levels[boss_level_id],
-			sizeof(level.boss_level_info));
-		
-		level.boss_max_lives = level.boss_level_info.lives;
-		level.boss_x = (ws2812_matrix::width - level.boss_level_info.width) / 2;
-		level.boss_y = ws2812_matrix::height - level.boss_level_info.height;
 	}
-	else
+}
+
+void update_aliens(collision_map& map, const loaded_level& level, const loaded_alien& obj)
+{
+	update_aliens(map, level, obj.init_x, obj.init_x + obj.width + 1,
+		obj.init_y, obj.init_y + obj.height + 1);
+}
+
+///Draws pixels of the current boss frame, other pixels are left as is
+void fill_boss(const loaded_level& level, uint8_t r, uint8_t g, uint8_t b)
+{
+	const boss_frame_rows& frame = level.boss_frames[level.boss_frame_number];
+	for(uint8_t y = 0; y != level.boss_level_info.height; ++y)
 	{
-		alien* level_ptr;
-		memcpy_P(&level_ptr, &level_map[level_id], sizeof(level_ptr));
-		
-		while(true)
+		uint8_t x = level.boss_x;
+		for(uint16_t row = frame.rows[y]; row; row >>= 1, ++x)
 		{
-			memcpy_P(&level.aliens[level.alien_count], &level_ptr[level.alien_count], sizeof(alien));
-			if(!level.aliens[level.alien_count].color_r
-				&& !level.aliens[level.alien_count].color_g
-				&& !level.aliens[level.alien_count].color_b)
-			{
-				break;
-			}
-			
-			level.aliens[level.alien_count].current_lives = level.aliens[level.alien_count].lives + 1;
-			if(++level.alien_count == max_aliens)
-				break;
+			if(row & 1)
+				ws2812_matrix::set_pixel_color_fast(x, level.boss_y + y, r, g, b);
 		}
 	}
 }
 
-void get_alien_color(const loaded_alien& obj, uint8_t& r, uint8_t& g, uint8_t& b,
-	uint8_t max_brightness)
+///Marks boss pixels of the current frame and its weak points in collision map
+void set_boss_entity(collision_map& map, const loaded_level& level, bool is_set)
+{
+	const boss_frame_rows& frame = level.boss_frames[level.boss_frame_number];
+	const uint8_t entity = is_set ? entity_boss : entity_none;
+	for(uint8_t y = 0; y != level.boss_level_info.height; ++y)
+	{
+		uint8_t x = level.boss_x;
+		for(uint16_t row = frame.rows[y]; row; row >>= 1, ++x)
+		{
+			if(row & 1)
+				set_entity(map, x, level.boss_y + y, entity);
+		}
+	}
+	
+	for(uint8_t i = 0; i != max_weak_points; ++i)
+	{
+		set_entity(map, level.boss_x + level.boss_level_info.weak_points[i].x,
+			level.boss_y + level.boss_level_info.weak_points[i].y,
+			is_set ? entity_boss_weak_point : entity_none);
+	}
+}
+
+///Caches alien color scaled to its current lives and brightness
+void update_alien_color(loaded_alien& obj, uint8_t max_brightness)
 {
 	//Min color value=36
 	//If brightness=15 then (36 * 15) / 256 = 2.
 	//Max color value=255
 	//If brightness=15 then (255 * 15) / 256 = 14.
-	r = obj.color_r ? 0xff / (10 - obj.color_r * 3) : 0;
-	g = obj.color_g ? 0xff / (10 - obj.color_g * 3) : 0;
-	b = obj.color_b ? 0xff / (10 - obj.color_b * 3) : 0;
+	uint8_t r = obj.color_r ? 0xff / (10 - obj.color_r * 3) : 0;
+	uint8_t g = obj.color_g ? 0xff / (10 - obj.color_g * 3) : 0;
+	uint8_t b = obj.color_b ? 0xff / (10 - obj.color_b * 3) : 0;
 	
 	//If max lives = 8 and current_lives = 1, then min color = 4
 	//If brightness = 15 then (4 * 15) / 256 = 0
@@ -668,79 +790,166 @@ void get_alien_color(const loaded_alien& obj, uint8_t& r, uint8_t& g, uint8_t& b
 		g = 1;
 	if(prev_b && !b)
 		b = 1;
+	
+	obj.rgb = { r, g, b };
+}
+
+///Fills collision map for the loaded level. Alien formation is drawn here as well,
+///after that it's redrawn only where aliens move or change.
+void set_level_entities(collision_map& map, const loaded_level& level)
+{
+	if(level.alien_count)
+	{
+		for(uint8_t i = 0; i != level.alien_count; ++i)
+			update_aliens(map, level, level.aliens[i]);
+	}
+	else
+	{
+		set_boss_entity(map, level, true);
+	}
 }
 
-void fill_alien(const loaded_alien& obj, uint8_t r, uint8_t g, uint8_t b)
+///Decodes monochrome bitmap of boss frame (see bitmap::display_bitmap_P) to rows.
+///Bitmap bits go column by column.
+void decode_boss_frame(const boss_level& info, uint8_t frame_number, boss_frame_rows& frame)
 {
-	uint8_t from_x = obj.init_x;
-	uint8_t to_x = from_x + obj.width + 1;
-	uint8_t from_y = obj.init_y;
-	uint8_t to_y = from_y + obj.height + 1;
-	for(uint8_t x = from_x; x != to_x; ++x)
+	const uint8_t* data = info.boss_frame[frame_number]
+		+ sizeof(bitmap::bitmap_header) + sizeof(bitmap::bitmap_flags);
+	memset(&frame, 0, sizeof(frame));
+	uint8_t color_byte = pgm_read_byte(data++);
+	uint8_t current_bit = 0;
+	for(uint8_t x = 0; x != info.width; ++x)
 	{
-		for(uint8_t y = from_y; y != to_y; ++y)
-			ws2812_matrix::set_pixel_color(x, y, r, g, b);
+		for(uint8_t y = 0; y != info.height; ++y)
+		{
+			if(color_byte & (1 << current_bit))
+				frame.rows[y] |= 1 << x;
+			
+			if(++current_bit == 8)
+			{
+				color_byte = pgm_read_byte(data++);
+				current_bit = 0;
+			}
+		}
+	}
+}
+
+void load_level(uint8_t level_id, loaded_level& level, uint8_t max_brightness)
+{
+	memcpy_P(&level.info, &levels[level_id], sizeof(level.info));
+	level.info.fall_speed = 0b111 - level.info.fall_speed;
+	level.info.move_speed = 0b111 - level.info.move_speed;
+	level.alien_count = 0;
+	
+	if(level.info.type == level_type_boss)
+	{
+		const uint8_t boss_level_id = pgm_read_byte(&boss_level_index[level_id]);
+		level.boss_frame_number = 0;
+		
+		memcpy_P(&level.boss_level_info, &boss_levels[boss_level_id],
+			sizeof(level.boss_level_info));
+		
+		for(uint8_t i = 0; i != boss_frame_count; ++i)
+			decode_boss_frame(level.boss_level_info, i, level.boss_frames[i]);
+		
+		level.boss_max_lives = level.boss_level_info.lives;
+		level.boss_x = (ws2812_matrix::width - level.boss_level_info.width) / 2;
+		level.boss_y = ws2812_matrix::height - level.boss_level_info.height;
+	}
+	else
+	{
+		alien* level_ptr;
+		memcpy_P(&level_ptr, &level_map[level_id], sizeof(level_ptr));
+		
+		while(true)
+		{
+			memcpy_P(&level.aliens[level.alien_count], &level_ptr[level.alien_count], sizeof(alien));
+			if(!level.aliens[level.alien_count].color_r
+				&& !level.aliens[level.alien_count].color_g
+				&& !level.aliens[level.alien_count].color_b)
+			{
+				break;
+			}
+			
+			level.aliens[level.alien_count].current_lives = level.aliens[level.alien_count].lives + 1;
+			update_alien_color(level.aliens[level.alien_count], max_brightness);
+			if(++level.alien_count == max_aliens)
+				break;
+		}
 	}
 }
 
 constexpr uint8_t animation_step_count = 100;
 constexpr uint8_t boss_animation_frame_count = 7;
-void display_boss(const loaded_level& level, const color::rgb& rgb, uint16_t delay)
+constexpr uint8_t boss_blink_count = 7;
+constexpr uint16_t boss_blink_ticks = timer::ms_to_ticks(160);
+
+///Boss killed animation state
+struct boss_killed_animation_state
 {
-	util::delay(delay);
-	bitmap::display_bitmap_P(level.boss_level_info.boss_frame[level.boss_frame_number],
-		level.boss_x, level.boss_y, rgb.r, rgb.g, rgb.b);
+	const loaded_level* level;
+	uint8_t max_brightness;
+	color::rgb prev_rgb, next_rgb;
+};
+
+void display_boss(const loaded_level& level, const color::rgb& rgb)
+{
+	fill_boss(level, rgb.r, rgb.g, rgb.b);
 	ws2812_matrix::show();
 }
 
-void boss_killed_animation(const loaded_level& level, uint8_t max_brightness)
+uint16_t boss_killed_animation(uint16_t step, void* context)
 {
+	boss_killed_animation_state& state = *static_cast<boss_killed_animation_state*>(context);
+	
 	//First blink
-	color::rgb prev_rgb
-		{ level.boss_level_info.r_to, level.boss_level_info.g_to, level.boss_level_info.b_to };
-	for(uint8_t i = 0; i != 7; ++i)
+	if(step < boss_blink_count * 2)
 	{
-		display_boss(level, { 0, 0, 0 }, 700);
-		display_boss(level, prev_rgb, 700);
+		display_boss(*state.level, step % 2 ? state.prev_rgb : color::rgb { 0, 0, 0 });
+		return boss_blink_ticks;
 	}
 	
-	//Now some random gradients
-	color::rgb next_rgb, rgb;
-	for(uint8_t frame = 0; frame != boss_animation_frame_count; ++frame)
+	//Now some random gradients, one gradient step per tick
+	step -= boss_blink_count * 2;
+	const uint8_t frame = step / animation_step_count;
+	const uint8_t animation_step = step % animation_step_count;
+	if(frame == boss_animation_frame_count)
+		return 0;
+	
+	if(!animation_step)
 	{
+		if(frame)
+			state.prev_rgb = state.next_rgb;
+		
 		if(frame == boss_animation_frame_count - 1)
-			next_rgb = { 0, 0, 0 };
+			state.next_rgb = { 0, 0, 0 };
 		else
-			game::get_random_color(next_rgb, max_brightness);
-		
-		for(uint8_t animation_step = 0; animation_step != animation_step_count; ++animation_step)
-		{
-			color::gradient(prev_rgb, next_rgb,
-				animation_step_count, animation_step, rgb);
-			display_boss(level, rgb, 10);
-		}
-		
-		prev_rgb = next_rgb;
+			game::get_random_color(state.next_rgb, state.max_brightness);
 	}
+	
+	color::rgb rgb;
+	color::gradient(state.prev_rgb, state.next_rgb,
+		animation_step_count, animation_step, rgb);
+	display_boss(*state.level, rgb);
+	return 1;
 }
 
+void start_boss_killed_animation(animation& boss_animation, boss_killed_animation_state& state,
+	const loaded_level& level, uint8_t max_brightness)
+{
+	state.level = &level;
+	state.max_brightness = max_brightness;
+	state.prev_rgb = { level.boss_level_info.r_to, level.boss_level_info.g_to, level.boss_level_info.b_to };
+	boss_animation.start(boss_killed_animation, &state);
+	boss_animation.tick();
+}
+
+///Alien formation is drawn incrementally by update_aliens(), so only boss is drawn here
 void draw_level(const loaded_level& level, uint8_t max_brightness)
 {
-	color::rgb rgb;
-	if(level.alien_count)
-	{
-		for(uint8_t i = 0; i != level.alien_count; ++i)
-		{
-			const loaded_alien& obj = level.aliens[i];
-			if(!obj.current_lives)
-				continue;
-			
-			get_alien_color(obj, rgb.r, rgb.g, rgb.b, max_brightness);
-			fill_alien(obj, rgb.r, rgb.g, rgb.b);
-		}
-	}
-	else if(level.boss_level_info.lives)
+	if(!level.alien_count && level.boss_level_info.lives)
 	{
+		color::rgb rgb;
 		color::rgb from { static_cast<uint8_t>(level.boss_level_info.r_from * 17),
 			static_cast<uint8_t>(level.boss_level_info.g_from * 17),
 			static_cast<uint8_t>(level.boss_level_info.b_from * 17) };
@@ -750,8 +959,7 @@ void draw_level(const loaded_level& level, uint8_t max_brightness)
 		color::gradient(to, from, level.boss_max_lives,
 			level.boss_level_info.lives, rgb);
 		color::scale_to_brightness(rgb, max_brightness);
-		bitmap::display_bitmap_P(level.boss_level_info.boss_frame[level.boss_frame_number],
-			level.boss_x, level.boss_y, rgb.r, rgb.g, rgb.b);
+		fill_boss(level, rgb.r, rgb.g, rgb.b);
 		
 		color::scale_to_brightness(to, max_brightness);
 		for(uint8_t i = 0; i != max_weak_points; ++i)
@@ -762,23 +970,12 @@ void draw_level(const loaded_level& level, uint8_t max_brightness)
 	}
 }
 
+///Alien formation is cleared incrementally by update_aliens(), so only boss is cleared here
 void clear_level(const loaded_level& level)
 {
-	if(level.alien_count)
-	{
-		for(uint8_t i = 0; i != level.alien_count; ++i)
-		{
-			const loaded_alien& obj = level.aliens[i];
-			if(!obj.current_lives)
-				continue;
-			
-			fill_alien(obj, 0, 0, 0);
-		}
-	}
-	else
+	if(!level.alien_count)
 	{
-		bitmap::display_bitmap_P(level.boss_level_info.boss_frame[level.boss_frame_number],
-			level.boss_x, level.boss_y, 0, 0, 0);
+		fill_boss(level, 0, 0, 0);
 	}
 }
 
@@ -805,7 +1002,7 @@ void draw_gun(int8_t prev_gun_x, int8_t gun_x, uint8_t lives, uint8_t max_bright
 		ws2812_matrix::set_pixel_color(static_cast<uint8_t>(gun_x + i), gun_y, rgb);
 }
 
-bool move_down(loaded_level& level)
+bool move_down(loaded_level& level, collision_map& map)
 {
 	if(level.alien_count)
 	{
@@ -818,33 +1015,47 @@ bool move_down(loaded_level& level)
 			if(!--obj.init_y)
 				return false;
 		}
+		
+		//Only bottom rows and previous top rows of aliens change
+		for(uint8_t i = 0; i != level.alien_count; ++i)
+		{
+			const loaded_alien& obj = level.aliens[i];
+			if(!obj.current_lives)
+				continue;
+			
+			const uint8_t to_x = obj.init_x + obj.width + 1;
+			const uint8_t top_y = obj.init_y + obj.height + 1;
+			update_aliens(map, level, obj.init_x, to_x, obj.init_y, obj.init_y + 1);
+			update_aliens(map, level, obj.init_x, to_x, top_y, top_y + 1);
+		}
 	}
 	else if(level.boss_level_info.lives)
 	{
 		//Move boss down and up
+		set_boss_entity(map, level, false);
 		if(level.boss_y == ws2812_matrix::height - level.boss_level_info.height)
 			--level.boss_y;
 		else
 			++level.boss_y;
+		set_boss_entity(map, level, true);
 	}
 	
 	return true;
 }
 
-void move_left_right(loaded_level& level, bullet_info& alien_bullets, int8_t direction)
+void move_left_right(loaded_level& level, collision_map& map,
+	bullet_info& alien_bullets, int8_t direction)
 {
 	if(level.alien_count)
 	{
 		uint8_t max_bullet_heights[ws2812_matrix::width];
 		memset(max_bullet_heights, 0, sizeof(max_bullet_heights));
-		for(uint8_t i = 0; i != max_bullet_count; ++i)
+		for(uint8_t i = alien_bullets.bullets.first_active(); i != bullet_pool::no_slot;
+			i = alien_bullets.bullets.next_active(i))
 		{
-			bullet& b = alien_bullets.bullets[i];
-			if(b.is_valid)
-			{
-				if(max_bullet_heights[b.coords.x] < b.coords.y)
-					max_bullet_heights[b.coords.x] = b.coords.y;
-			}
+			const bullet& b = alien_bullets.bullets[i];
+			if(max_bullet_heights[b.coords.x] < b.coords.y)
+				max_bullet_heights[b.coords.x] = b.coords.y;
 		}
 		
 		for(uint8_t i = 0; i != level.alien_count; ++i)
@@ -874,6 +1085,20 @@ void move_left_right(loaded_level& level, bullet_info& alien_bullets, int8_t dir
 			auto& obj = level.aliens[i];
 			obj.init_x += direction;
 		}
+		
+		//Only leading and trailing columns of aliens change
+		for(uint8_t i = 0; i != level.alien_count; ++i)
+		{
+			const auto& obj = level.aliens[i];
+			if(!obj.current_lives)
+				continue;
+			
+			const uint8_t leading_x = direction > 0 ? obj.init_x + obj.width : obj.init_x;
+			const uint8_t trailing_x = direction > 0 ? obj.init_x - 1 : obj.init_x + obj.width + 1;
+			const uint8_t to_y = obj.init_y + obj.height + 1;
+			update_aliens(map, level, leading_x, leading_x + 1, obj.init_y, to_y);
+			update_aliens(map, level, trailing_x, trailing_x + 1, obj.init_y, to_y);
+		}
 	}
 	else if(level.boss_level_info.lives)
 	{
@@ -881,71 +1106,77 @@ void move_left_right(loaded_level& level, bullet_info& alien_bullets, int8_t dir
 		if((direction < 0 && level.boss_x)
 			|| (direction > 0 && level.boss_x + level.boss_level_info.width < ws2812_matrix::width))
 		{
+			set_boss_entity(map, level, false);
 			level.boss_x += direction;
+			set_boss_entity(map, level, true);
 		}
 	}
 }
 
-uint8_t find_free_bullet(const bullet_info& info)
+uint8_t find_bullet(const bullet_info& info, const util::coord& coords)
 {
-	for(uint8_t i = 0; i != max_bullet_count; ++i)
+	for(uint8_t i = info.bullets.first_active(); i != bullet_pool::no_slot;
+		i = info.bullets.next_active(i))
 	{
-		if(!info.bullets[i].is_valid)
+		const bullet& b = info.bullets[i];
+		if(b.coords.x == coords.x && b.coords.y == coords.y)
 			return i;
 	}
 	
-	return 0xff;
+	return bullet_pool::no_slot;
 }
 
-bool add_bullet(uint8_t x, uint8_t y, bullet_info& info)
+///Returns false if there's no more free space for bullets
+bool add_bullet(uint8_t x, uint8_t y, bullet_info& info, collision_map& map)
 {
-	if(info.bullet_count >= max_bullet_count)
-		return false;
-	
-	uint8_t free_bullet_index = find_free_bullet(info);
-	info.bullets[free_bullet_index].coords.y = y;
-	info.bullets[free_bullet_index].coords.x = x;
-	info.bullets[free_bullet_index].is_valid = true;
-	if(++info.bullet_count >= max_bullet_count)
+	const uint8_t index = info.bullets.allocate();
+	if(index == bullet_pool::no_slot)
 		return false;
 	
-	return true;
+	info.bullets[index].coords.y = y;
+	info.bullets[index].coords.x = x;
+	map.cells[y][x] |= info.map_flag;
+	return !info.bullets.is_full();
 }
 
-void hide_bullet_point(const bullet& b, uint8_t gun_x)
+///Bullets are not drawn over gun, aliens and boss, so their pixels are kept
+void hide_bullet_point(const bullet& b, const collision_map& map, uint8_t gun_x)
 {
+	if(get_entity(map, b.coords) != entity_none)
+		return;
+	
 	if(b.coords.y || b.coords.x < gun_x || b.coords.x >= gun_x + gun_width)
 		ws2812_matrix::clear_pixel(b.coords);
 }
 
-void invalidate_bullet(bullet_info& info, bullet& b, uint8_t gun_x)
+void invalidate_bullet(bullet_info& info, uint8_t index, collision_map& map, uint8_t gun_x)
 {
-	b.is_valid = false;
-	--info.bullet_count;
-	hide_bullet_point(b, gun_x);
+	const bullet& b = info.bullets[index];
+	info.bullets.release(index);
+	map.cells[b.coords.y][b.coords.x] &= ~info.map_flag;
+	hide_bullet_point(b, map, gun_x);
 }
 
-void move_bullets(bullet_info& info, uint8_t gun_x, uint8_t border_value, int8_t offset)
+void move_bullets(bullet_info& info, collision_map& map, uint8_t gun_x, uint8_t border_value, int8_t offset)
 {
-	for(uint8_t i = 0; i != max_bullet_count; ++i)
+	for(uint8_t i = info.bullets.first_active(); i != bullet_pool::no_slot; i = info.bullets.next_active(i))
 	{
 		auto& b = info.bullets[i];
-		if(b.is_valid)
+		if(b.coords.y == border_value)
 		{
-			if(b.coords.y == border_value)
-			{
-				invalidate_bullet(info, b, gun_x);
-			}
-			else
-			{
-				hide_bullet_point(b, gun_x);
-				b.coords.y += offset;
-			}
+			invalidate_bullet(info, i, map, gun_x);
+		}
+		else
+		{
+			hide_bullet_point(b, map, gun_x);
+			map.cells[b.coords.y][b.coords.x] &= ~info.map_flag;
+			b.coords.y += offset;
+			map.cells[b.coords.y][b.coords.x] |= info.map_flag;
 		}
 	}
 }
 
-void draw_bullets_color(const bullet bullets[max_bullet_count],
+void draw_bullets_color(const bullet_pool& bullets, const collision_map& map,
 	const color::rgb& from, const color::rgb& to,
 	uint8_t& gradient_step, uint8_t max_brightness)
 {
@@ -955,136 +1186,94 @@ void draw_bullets_color(const bullet bullets[max_bullet_count],
 		gradient_step = 0;
 	
 	color::scale_to_brightness(rgb, max_brightness);
-	for(uint8_t i = 0; i != max_bullet_count; ++i)
+	for(uint8_t i = bullets.first_active(); i != bullet_pool::no_slot; i = bullets.next_active(i))
 	{
 		const auto& obj = bullets[i];
-		if(obj.is_valid)
+		if(get_entity(map, obj.coords) == entity_none)
 			ws2812_matrix::set_pixel_color(obj.coords, rgb);
 	}
 }
 
-void invalidate_alien(loaded_alien& obj)
-{
-	fill_alien(obj, 0, 0, 0);
-}
-
 bool process_bullets(bullet_info& player_bullets, bullet_info& alien_bullets,
-	loaded_level& level, uint32_t& score, uint8_t score_multiplier,
-	bool& load_next_level, uint8_t gun_x, uint8_t& lives,
-	uint8_t max_brightness)
+	loaded_level& level, collision_map& map, uint32_t& score, uint8_t score_multiplier,
+	bool& load_next_level, uint8_t gun_x, uint8_t& lives, uint8_t max_brightness)
 {
 	bool score_changed = false;
 	
+	//First check bullet & alien bullet collisions
+	for(uint8_t i = alien_bullets.bullets.first_active(); i != bullet_pool::no_slot;
+		i = alien_bullets.bullets.next_active(i))
 	{
-		uint8_t bullet_positions[ws2812_matrix::height][ws2812_matrix::width];
-		memset(bullet_positions, 0, sizeof(bullet_positions));
-		
-		//First check bullet & alien bullet collisions
-		for(uint8_t i = 0; i != max_bullet_count; ++i)
-		{
-			bullet& b = player_bullets.bullets[i];
-			if(b.is_valid)
-				bullet_positions[b.coords.y][b.coords.x] = i + 1; //Save bullet id + 1
-		}
-		
-		for(uint8_t i = 0; i != max_bullet_count; ++i)
+		const bullet& b = alien_bullets.bullets[i];
+		if(map.cells[b.coords.y][b.coords.x] & player_bullet_flag)
 		{
-			bullet& b = alien_bullets.bullets[i];
-			uint8_t player_bullet_id = bullet_positions[b.coords.y][b.coords.x];
-			if(b.is_valid && player_bullet_id)
-			{
-				//Alien bullet & player bullet collision!
-				invalidate_bullet(alien_bullets, b, gun_x);
-				invalidate_bullet(player_bullets,
-					player_bullets.bullets[player_bullet_id - 1], gun_x);
-				score += score_multiplier;
-				score_changed = true;
-			}
+			//Alien bullet & player bullet collision!
+			const uint8_t player_bullet_id = find_bullet(player_bullets, b.coords);
+			invalidate_bullet(alien_bullets, i, map, gun_x);
+			invalidate_bullet(player_bullets, player_bullet_id, map, gun_x);
+			score += score_multiplier;
+			score_changed = true;
 		}
 	}
 	
-	for(uint8_t i = 0; i != max_bullet_count; ++i)
+	for(uint8_t i = player_bullets.bullets.first_active(); i != bullet_pool::no_slot;
+		i = player_bullets.bullets.next_active(i))
 	{
-		bullet& b = player_bullets.bullets[i];
-		if(!b.is_valid)
+		const uint8_t entity = get_entity(map, player_bullets.bullets[i].coords);
+		if(entity == entity_none)
 			continue;
 		
-		if(level.alien_count)
+		//Player bullet + alien or boss collision
+		invalidate_bullet(player_bullets, i, map, gun_x);
+		if(entity < entity_boss)
 		{
-			for(uint8_t a = 0; a != level.alien_count; ++a)
+			loaded_alien& obj = level.aliens[entity - entity_alien_first];
+			if(--obj.current_lives)
 			{
-				loaded_alien& obj = level.aliens[a];
-				if(obj.current_lives)
-				{
-					if(b.coords.x >= obj.init_x && b.coords.x < obj.init_x + obj.width + 1
-						&& b.coords.y >= obj.init_y && b.coords.y < obj.init_y + obj.height + 1)
-					{
-						//Player bullet + alien collision
-						invalidate_bullet(player_bullets, b, gun_x);
-						if(!--obj.current_lives)
-						{
-							score += (obj.lives + 1) * score_multiplier;
-							score_changed = true;
-							invalidate_alien(obj);
-						}
-						
-						break;
-					}
-				}
+				update_alien_color(obj, max_brightness);
 			}
+			else
+			{
+				score += (obj.lives + 1) * score_multiplier;
+				score_changed = true;
+			}
+			
+			update_aliens(map, level, obj);
 		}
-		else if(level.boss_level_info.lives)
+		else
 		{
-			//Boss level is already drawn at this point, we can use led matrix data to check collisions
-			//Bullets are not drawn at this point
-			if(ws2812_matrix::is_on(b.coords))
+			if(rand() % 8 == 0)
 			{
-				invalidate_bullet(player_bullets, b, gun_x);
-				
-				if(rand() % 8 == 0)
-				{
-					score += strong_point_score;
-					score_changed = true;
-					--level.boss_level_info.lives;
-				}
-				else
-				{
-					for(uint8_t i = 0; i != max_weak_points; ++i)
-					{
-						uint8_t weak_x = level.boss_x + level.boss_level_info.weak_points[i].x;
-						uint8_t weak_y = level.boss_y + level.boss_level_info.weak_points[i].y;
-						if(b.coords.x == weak_x && b.coords.y == weak_y)
-						{
-							score += weak_point_score;
-							score_changed = true;
-							--level.boss_level_info.lives;
-							break;
-						}
-					}
-				}
-				
-				if(!level.boss_level_info.lives)
-				{
-					boss_killed_animation(level, max_brightness);
-					score += score_multiplier * boss_score_multiplier;
-					score_changed = true;
-					load_next_level = true;
-					break;
-				}
+				score += strong_point_score;
+				score_changed = true;
+				--level.boss_level_info.lives;
+			}
+			else if(entity == entity_boss_weak_point)
+			{
+				score += weak_point_score;
+				score_changed = true;
+				--level.boss_level_info.lives;
+			}
+			
+			if(!level.boss_level_info.lives)
+			{
+				set_boss_entity(map, level, false);
+				score += score_multiplier * boss_score_multiplier;
+				score_changed = true;
+				load_next_level = true;
+				break;
 			}
 		}
 	}
 	
-	for(uint8_t i = 0; i != max_bullet_count; ++i)
+	for(uint8_t i = alien_bullets.bullets.first_active(); i != bullet_pool::no_slot;
+		i = alien_bullets.bullets.next_active(i))
 	{
-		bullet& b = alien_bullets.bullets[i];
-		if(!b.is_valid)
-			continue;
-		
 		//Alien bullet + gun collision
+		const bullet& b = alien_bullets.bullets[i];
 		if(b.coords.y == gun_y && b.coords.x >= gun_x && b.coords.x < gun_x + gun_width)
 		{
-			invalidate_bullet(alien_bullets, b, gun_x);
+			invalidate_bullet(alien_bullets, i, map, gun_x);
 			if(!--lives)
 				return score_changed;
 		}
@@ -1109,30 +1298,32 @@ bool process_bullets(bullet_info& player_bullets, bullet_info& alien_bullets,
 	return score_changed;
 }
 
-void add_boss_bullets(bullet_info& alien_bullets, loaded_level& level, uint8_t shoot_probability)
+void add_boss_bullets(bullet_info& alien_bullets, loaded_level& level,
+	collision_map& map, uint8_t shoot_probability)
 {
 	//Boss bullets should be created below the boss
 	shoot_probability += boss_additional_shoot_probability;
 	for(uint8_t x = level.boss_x; x != level.boss_x + level.boss_level_info.width; ++x)
 	{
-		if(ws2812_matrix::is_on(x, level.boss_y)
+		if((map.cells[level.boss_y][x] & entity_mask)
 			&& rand() % max_alien_shoot_probability < shoot_probability)
 		{
-			if(!add_bullet(x, level.boss_y, alien_bullets))
+			if(!add_bullet(x, level.boss_y, alien_bullets, map))
 				return;
 		}
 	}
 }
 
 //shoot_probability = 0 to 128 (max_alien_shoot_probability)
-void add_alien_bullets(bullet_info& alien_bullets, loaded_level& level, uint8_t shoot_probability)
+void add_alien_bullets(bullet_info& alien_bullets, loaded_level& level,
+	collision_map& map, uint8_t shoot_probability)
 {
-	if(alien_bullets.bullet_count >= max_bullet_count)
+	if(alien_bullets.bullets.is_full())
 		return;
 	
 	if(!level.alien_count)
 	{
-		add_boss_bullets(alien_bullets, level, shoot_probability);
+		add_boss_bullets(alien_bullets, level, map, shoot_probability);
 		return;
 	}
 	
@@ -1163,7 +1354,7 @@ void add_alien_bullets(bullet_info& alien_bullets, loaded_level& level, uint8_t
 				
 				if(rand() % max_alien_shoot_probability < shoot_probability)
 				{
-					if(!add_bullet(x, obj.init_y - 1, alien_bullets))
+					if(!add_bullet(x, obj.init_y - 1, alien_bullets, map))
 						return;
 				}
 			}
@@ -1183,8 +1374,9 @@ uint32_t loop()
 	uint8_t game_counter = 0;
 	uint8_t lives = total_lives;
 	bool need_redraw = false;
-	bullet_info bullets;
-	bullet_info alien_bullets;
+	bullet_info bullets(player_bullet_flag);
+	bullet_info alien_bullets(0);
+	collision_map map;
 	uint8_t bullet_draw_counter = 0;
 	bool need_process_bullets = true;
 	bool aliens_moved_down_or_shooted = false;
@@ -1192,6 +1384,8 @@ uint32_t loop()
 	bool boss_animation = false;
 	uint8_t load_next_level_counter = 1;
 	uint8_t boss_animation_counter = 0;
+	animation boss_killed;
+	boss_killed_animation_state boss_killed_state;
 	
 	loaded_level level;
 	draw_gun(gun_x, gun_x, lives, max_brightness);
@@ -1202,6 +1396,23 @@ uint32_t loop()
 	{
 		timer::wait_for_interrupt();
 		
+		if(boss_killed.tick())
+		{
+			if(buttons::get_button_status(buttons::button_up) == buttons::button_status_still_pressed
+				&& buttons::get_button_status(buttons::button_down) == buttons::button_status_still_pressed)
+			{
+				if(!game::pause_with_screen_backup())
+				{
+					number_display::output_number(score);
+					return score;
+				}
+				
+				number_display::output_number(score);
+			}
+			
+			continue;
+		}
+		
 		if(load_next_level && !--load_next_level_counter)
 		{
 			if(level_id == sizeof(levels) / sizeof(levels[0]))
@@ -1214,13 +1425,14 @@ uint32_t loop()
 			boss_animation = false;
 			game_counter = 0;
 			
-			load_level(level_id, level);
+			load_level(level_id, level, max_brightness);
 			if(hard_mode)
 			{
 				level.info.fall_speed = 1;
 				level.info.move_speed = 1;
 			}
 			
+			set_level_entities(map, level);
 			draw_level(level, max_brightness);
 			need_process_bullets = true;
 			fall_counter = static_cast<uint8_t>(rand()) % level.info.fall_speed;
@@ -1237,7 +1449,7 @@ uint32_t loop()
 			{
 				shoot_counter = 0;
 				need_process_bullets = true;
-				add_alien_bullets(alien_bullets, level, base_alien_shoot_probability + level_id * 2);
+				add_alien_bullets(alien_bullets, level, map, base_alien_shoot_probability + level_id * 2);
 				aliens_moved_down_or_shooted = true;
 			}
 			else //Don't shoot and fall at the same time
@@ -1247,7 +1459,7 @@ uint32_t loop()
 					fall_counter = 0;
 					
 					clear_level(level);
-					if(!move_down(level))
+					if(!move_down(level, map))
 						break; //Game over
 					
 					need_process_bullets = true;
@@ -1263,7 +1475,7 @@ uint32_t loop()
 			{
 				move_counter = 0;
 				clear_level(level);
-				move_left_right(level, alien_bullets, rand() % 2 ? 1 : -1);
+				move_left_right(level, map, alien_bullets, rand() % 2 ? 1 : -1);
 				need_process_bullets = true;
 			}
 			else
@@ -1300,7 +1512,7 @@ uint32_t loop()
 		auto button_down_state = buttons::get_button_status(buttons::button_down);
 		if(button_up_state == buttons::button_status_pressed) //Shoot
 		{
-			if(bullets.bullet_count < max_bullet_count && !bullets.bullet_counter)
+			if(!bullets.bullets.is_full() && !bullets.bullet_counter)
 			{
 				if(score)
 				{
@@ -1308,7 +1520,7 @@ uint32_t loop()
 					number_display::output_number(score);
 				}
 				
-				add_bullet(gun_x + (gun_width / 2), gun_y + 1, bullets);
+				add_bullet(gun_x + (gun_width / 2), gun_y + 1, bullets, map);
 				bullets.bullet_counter = target_bullet_counter;
 				need_process_bullets = true;
 			}
@@ -1338,7 +1550,7 @@ uint32_t loop()
 			if(bullet_draw_counter == target_bullet_draw_counter)
 			{
 				bullet_draw_counter = 0;
-				move_bullets(bullets, gun_x, ws2812_matrix::height - 1, 1);
+				move_bullets(bullets, map, gun_x, ws2812_matrix::height - 1, 1);
 				need_process_bullets = true;
 				if(!level.alien_count)
 					boss_animation = true;
@@ -1346,7 +1558,7 @@ uint32_t loop()
 			else if(bullet_draw_counter == target_bullet_draw_counter - 1)
 			{
 				++bullet_draw_counter;
-				move_bullets(alien_bullets, gun_x, 0, -1);
+				move_bullets(alien_bullets, map, gun_x, 0, -1);
 				need_process_bullets = true;
 			}
 			else
@@ -1365,24 +1577,22 @@ uint32_t loop()
 				boss_animation_counter = 0;
 				boss_animation = false;
 				clear_level(level);
+				const bool is_boss_alive = !level.alien_count && level.boss_level_info.lives;
+				if(is_boss_alive)
+					set_boss_entity(map, level, false);
+				
 				if(++level.boss_frame_number == boss_frame_count)
 					level.boss_frame_number = 0;
-			}
-			
-			if(!level.alien_count && level.boss_level_info.lives)
-			{
-				//Boss mode (boss is alive)
-				//Clear bullets on led matrix
-				move_bullets(bullets, gun_x, ws2812_matrix::height, 0);
-				//Draw boss level if changed, as graphical matrix data is used to detect collisions
-				draw_level(level, max_brightness);
+				
+				if(is_boss_alive)
+					set_boss_entity(map, level, true);
 			}
 			
 			//1. Calculates bullets and aliens intersections
 			//2. Calculates bullets and alien bullets intersections
 			//3. Calculates gun and alien bullets intersections
 			uint8_t old_lives = lives;
-			if(process_bullets(bullets, alien_bullets, level, score, level_id,
+			if(process_bullets(bullets, alien_bullets, level, map, score, level_id,
 				load_next_level, gun_x, lives, max_brightness))
 			{
 				number_display::output_number(score);
@@ -1394,14 +1604,17 @@ uint32_t loop()
 			if(load_next_level && !load_next_level_counter)
 			{
 				boss_animation = false;
+				if(!level.alien_count)
+					start_boss_killed_animation(boss_killed, boss_killed_state, level, max_brightness);
+				
 				clear_level(level);
 				load_next_level_counter = target_load_next_level_counter;
 			}
 			
 			//Draw level and bullets after processing, first bullets
-			draw_bullets_color(bullets.bullets, player_bullet_color, player_bullet_color_2,
+			draw_bullets_color(bullets.bullets, map, player_bullet_color, player_bullet_color_2,
 				gradient_player_bullet_step, max_brightness);
-			draw_bullets_color(alien_bullets.bullets, alien_bullet_color, alien_bullet_color_2,
+			draw_bullets_color(alien_bullets.bullets, map, alien_bullet_color, alien_bullet_color_2,
 				gradient_alien_bullet_step, max_brightness);
 			draw_level(level, max_brightness);
 			
@@ -10,14 +10,16 @@
 #include <avr/pgmspace.h>
 
 #include "accelerometer.h"
+#include "animation.h"
 #include "buttons.h"
 #include "colors.h"
 #include "game.h"
 #include "move_helper.h"
 #include "number_display.h"
 #include "options.h"
+#include "tetris_ai.h"
+#include "tetris_field.h"
 #include "timer.h"
-#include "util.h"
 #include "ws2812_matrix.h"
 
 namespace
@@ -50,10 +52,24 @@ constexpr uint8_t invalid_block_pos = 0xff;
 constexpr uint8_t combo_multiplier = 3;
 constexpr uint8_t fast_fall_game_difficulty = 7;
 
+constexpr uint8_t flash_step_count = 6;
+constexpr uint16_t flash_step_ticks = timer::ms_to_ticks(120);
+constexpr uint16_t color_light_column_ticks = timer::ms_to_ticks(40);
+constexpr uint8_t color_light_fade_step = 7;
+constexpr uint16_t game_over_ticks = timer::ms_to_ticks(1100);
+
+constexpr uint16_t demo_action_ticks = timer::ms_to_ticks(100);
+constexpr uint8_t demo_placements_per_tick = 2;
+
+///Fallen blocks occupancy, kept in sync with display pixels.
+///Falling block is not included.
+tetris_field<ws2812_matrix::width, ws2812_matrix::height> field;
+
 struct block
 {
 	static constexpr uint8_t max_columns = 4;
 	static constexpr uint8_t max_rows = 4;
+	static constexpr uint8_t rotation_count = 4;
 	
 	uint8_t width : 4;
 	uint8_t height : 4;
@@ -71,45 +87,110 @@ struct block
 		uint16_t data;
 	};
 	
-	bool at(uint8_t x, uint8_t y) const
+	uint8_t row(uint8_t y) const
 	{
-		return static_cast<bool>(data & (1 << (y * max_columns + x)));
+		return (data >> (y * max_columns)) & 0x0f;
 	}
 	
-	void set(uint8_t x, uint8_t y, bool value)
+	bool at(uint8_t x, uint8_t y) const
 	{
-		data ^= (-static_cast<int8_t>(value) ^ data) & (1 << (y * max_columns + x));
+		return static_cast<bool>(data & (1 << (y * max_columns + x)));
 	}
 };
 
-const block blocks[] PROGMEM = {
-	{ 4, 1, 0b1111, 0, 0, 0 }, //line 4x1
+///Block description used to generate rotations at compile time
+struct block_shape
+{
+	uint8_t width;
+	uint8_t height;
+	uint8_t row1, row2, row3, row4;
+};
+
+constexpr uint8_t get_shape_row(const block_shape& shape, uint8_t y)
+{
+	return y == 0 ? shape.row1 : y == 1 ? shape.row2 : y == 2 ? shape.row3 : shape.row4;
+}
+
+constexpr bool shape_at(const block_shape& shape, uint8_t x, uint8_t y)
+{
+	return x < shape.width && y < shape.height && ((get_shape_row(shape, y) >> x) & 1);
+}
+
+///Returns row y of shape rotated clockwise (built from column y of source shape)
+constexpr uint8_t get_rotated_row(const block_shape& shape, uint8_t y, uint8_t x = 0)
+{
+	return x == block::max_columns ? 0
+		: (shape_at(shape, y, shape.height - 1 - x) << x) | get_rotated_row(shape, y, x + 1);
+}
+
+constexpr block_shape rotate_shape(const block_shape& shape)
+{
+	return { shape.height, shape.width,
+		get_rotated_row(shape, 0), get_rotated_row(shape, 1),
+		get_rotated_row(shape, 2), get_rotated_row(shape, 3) };
+}
+
+constexpr block_shape rotate_shape(const block_shape& shape, uint8_t rotations)
+{
+	return rotations ? rotate_shape(rotate_shape(shape), rotations - 1) : shape;
+}
+
+constexpr block make_block(const block_shape& shape)
+{
+	return { shape.width, shape.height, shape.row1, shape.row2, shape.row3, shape.row4 };
+}
+
+struct block_rotations
+{
+	block rotations[block::rotation_count];
+};
+
+constexpr block_rotations make_rotations(const block_shape& shape)
+{
+	return { { make_block(shape), make_block(rotate_shape(shape, 1)),
+		make_block(rotate_shape(shape, 2)), make_block(rotate_shape(shape, 3)) } };
+}
+
+///All clockwise rotations of all blocks
+constexpr block_rotations blocks[] PROGMEM = {
+	make_rotations({ 4, 1, 0b1111, 0, 0, 0 }), //line 4x1
 		
-	{ 3, 2, 0b0011, 0b0110, 0, 0 }, //"Z" left
-	{ 3, 2, 0b0110, 0b0011, 0, 0 }, //"Z" right
-	{ 3, 2, 0b0010, 0b0111, 0, 0 }, //"T"
-	{ 3, 2, 0b0001, 0b0111, 0, 0 }, //"L" left
-	{ 3, 2, 0b0100, 0b0111, 0, 0 }, //"L" right
-	{ 2, 2, 0b0011, 0b0011, 0, 0 }, //cube
+	make_rotations({ 3, 2, 0b0011, 0b0110, 0, 0 }), //"Z" left
+	make_rotations({ 3, 2, 0b0110, 0b0011, 0, 0 }), //"Z" right
+	make_rotations({ 3, 2, 0b0010, 0b0111, 0, 0 }), //"T"
+	make_rotations({ 3, 2, 0b0001, 0b0111, 0, 0 }), //"L" left
+	make_rotations({ 3, 2, 0b0100, 0b0111, 0, 0 }), //"L" right
+	make_rotations({ 2, 2, 0b0011, 0b0011, 0, 0 }), //cube
 	
 	//7
-	{ 1, 1, 0b0001, 0, 0, 0 }, //"."
+	make_rotations({ 1, 1, 0b0001, 0, 0, 0 }), //"."
 	
 	//8
-	{ 3, 2, 0b0111, 0b0111, 0, 0 }, //block 3x2
+	make_rotations({ 3, 2, 0b0111, 0b0111, 0, 0 }), //block 3x2
 	
 	//9
-	{ 3, 3, 0b0111, 0b0010, 0b0010, 0 }, //Huge "T"
+	make_rotations({ 3, 3, 0b0111, 0b0010, 0b0010, 0 }), //Huge "T"
 	
 	//10
-	{ 3, 3, 0b0111, 0b0111, 0b0111, 0 }, //Huge cube
+	make_rotations({ 3, 3, 0b0111, 0b0111, 0b0111, 0 }), //Huge cube
 	
 	//11
-	{ 3, 1, 0b0111, 0, 0, 0 }, //line 3x1
+	make_rotations({ 3, 1, 0b0111, 0, 0, 0 }), //line 3x1
 	
 	//12
-	{ 3, 3, 0b0011, 0b0010, 0b0110, 0 }, //Huge "Z" left
-	{ 3, 3, 0b0110, 0b0010, 0b0011, 0 } //Huge "Z" right
+	make_rotations({ 3, 3, 0b0011, 0b0010, 0b0110, 0 }), //Huge "Z" left
+	make_rotations({ 3, 3, 0b0110, 0b0010, 0b0011, 0 }) //Huge "Z" right
+};
+
+using autoplayer = tetris_ai<ws2812_matrix::width, ws2812_matrix::height>;
+static_assert(autoplayer::max_rotations >= block::rotation_count, "Autoplayer can't handle all block rotations");
+
+///Autoplayer state used in demo mode
+struct demo_state
+{
+	autoplayer ai;
+	uint8_t rotations_left;
+	uint16_t action_counter;
 };
 
 tetris_difficulty_map get_difficulty(uint32_t score)
@@ -125,45 +206,75 @@ tetris_difficulty_map get_difficulty(uint32_t score)
 	return elem;
 }
 
-block rotate_block(const block& b)
+block load_block(uint8_t block_id, uint8_t rotation)
 {
-	block ret { b.height, b.width, 0, 0, 0, 0 };
-	
-	for(uint8_t i = 0; i != b.width; ++i)
-	{
-		for(uint8_t j = 0; j != b.height; ++j)
-		{
-			//ret.set(j, i, b.at(b.width - i - 1, j)); //ccw
-			ret.set(b.height - 1 - j, i, b.at(i, j)); //cw
-		}
-	}
-	
+	block ret;
+	memcpy_P(&ret, &blocks[block_id].rotations[rotation], sizeof(ret));
 	return ret;
 }
 
-block create_block(uint8_t max_block_id)
+block create_block(uint8_t max_block_id, uint8_t& block_id, uint8_t& rotation)
 {
-	uint8_t block_id = rand() % (max_block_id + 1);
-	block ret;
-	memcpy_P(&ret, &blocks[block_id], sizeof(ret));
-	for(uint8_t i = 0, rotations = rand() % 4; i != rotations; ++i)
-		ret = rotate_block(ret);
+	block_id = rand() % (max_block_id + 1);
+	rotation = rand() % block::rotation_count;
+	return load_block(block_id, rotation);
+}
+
+void start_demo_search(demo_state& demo, uint8_t block_id)
+{
+	autoplayer::piece rotations[block::rotation_count];
+	for(uint8_t rotation = 0; rotation != block::rotation_count; ++rotation)
+	{
+		const block b = load_block(block_id, rotation);
+		rotations[rotation].width = b.width;
+		rotations[rotation].height = b.height;
+		for(uint8_t i = 0; i != block::max_rows; ++i)
+			rotations[rotation].rows[i] = b.row(i);
+	}
 	
-	return ret;
+	demo.ai.start(field.get_rows(), rotations, block::rotation_count);
+	demo.rotations_left = block::rotation_count - 1;
+	demo.action_counter = 0;
 }
 
-bool intersects(const block& b, uint8_t x, uint8_t y)
+///Emulates player input in demo mode. Continues placement search, then
+///rotates block to the rotation chosen by autoplayer, moves it to the chosen
+///column and drops it, one action per demo_action_ticks.
+void get_demo_action(demo_state& demo, uint8_t block_x, uint8_t block_rotation,
+	buttons::button_status& rotate, buttons::button_status& drop, move_direction& direction)
 {
-	for(uint8_t i = 0; i != b.height; ++i)
+	rotate = buttons::button_status_not_pressed;
+	drop = buttons::button_status_not_pressed;
+	direction = move_direction_none;
+	
+	if(!demo.ai.search(demo_placements_per_tick) || ++demo.action_counter != demo_action_ticks)
+		return;
+	
+	demo.action_counter = 0;
+	if(!demo.ai.is_found())
 	{
-		for(uint8_t j = 0; j != b.width; ++j)
-		{
-			if(b.at(j, i) && ws2812_matrix::is_on(x + j, y - i))
-				return true;
-		}
+		drop = buttons::button_status_pressed;
+		return;
 	}
 	
-	return false;
+	//Rotation may fail near walls or other blocks, give up after several attempts
+	if(block_rotation != demo.ai.get_rotation() && demo.rotations_left)
+	{
+		--demo.rotations_left;
+		rotate = buttons::button_status_pressed;
+	}
+	else if(block_x < demo.ai.get_x())
+	{
+		direction = move_direction_left;
+	}
+	else if(block_x > demo.ai.get_x())
+	{
+		direction = move_direction_right;
+	}
+	else
+	{
+		drop = buttons::button_status_pressed;
+	}
 }
 
 void hide_block(uint8_t x, uint8_t y, const block& fig)
@@ -193,13 +304,13 @@ void show_block(uint8_t x, uint8_t y, const block& fig, const color::rgb& rgb)
 bool get_new_block_pos(const block& b, uint8_t& x)
 {
 	x = (ws2812_matrix::width - b.width) / 2;
-	if(!intersects(b, x, ws2812_matrix::height - 1))
+	if(!field.intersects(b, x, ws2812_matrix::height - 1))
 		return true;
 	
 	//Try to fit block somewhere else
 	for(uint8_t new_x = 0; new_x != ws2812_matrix::width - b.width + 1; ++new_x)
 	{
-		if(!intersects(b, new_x, ws2812_matrix::height - 1))
+		if(!field.intersects(b, new_x, ws2812_matrix::height - 1))
 		{
 			x = new_x;
 			return true;
@@ -227,133 +338,163 @@ void create_bright_color(color::rgb& rgb)
 		rgb.r = 0xff;
 }
 
-void remove_rows_flash(uint8_t full_rows[ws2812_matrix::height], uint8_t row_count,
-	uint8_t max_brightness)
+///Full rows removal animation state
+struct rows_animation_state
 {
+	uint8_t full_rows[ws2812_matrix::height];
+	uint8_t row_count;
+	uint8_t max_brightness;
 	color::rgb rgb;
-	create_bright_color(rgb);
-	color::scale_to_brightness(rgb, max_brightness);
-	
-	color::rgb current;
-	for(uint8_t step = 0; step != 6; ++step)
+};
+
+void fill_full_rows(const rows_animation_state& state, const color::rgb& rgb)
+{
+	for(uint8_t i = 0; i != state.row_count; ++i)
 	{
-		if(step % 2)
-			current = { 0, 0, 0 };
-		else
-			current = rgb;
-		
 		for(uint8_t x = 0; x != ws2812_matrix::width; ++x)
-		{
-			for(int8_t i = row_count - 1; i >= 0; --i)
-				ws2812_matrix::set_pixel_color(x, full_rows[i], current);
-		}
-		
-		ws2812_matrix::show();
-		util::delay(500);
+			ws2812_matrix::set_pixel_color(x, state.full_rows[i], rgb);
 	}
 }
 
-void remove_rows_color_light(uint8_t full_rows[ws2812_matrix::height], uint8_t row_count,
-	uint8_t max_brightness)
+uint16_t remove_rows_flash(uint16_t step, void* context)
 {
-	color::rgb rgb;
-	create_bright_color(rgb);
+	const rows_animation_state& state = *static_cast<const rows_animation_state*>(context);
+	if(step == flash_step_count)
+		return 0;
 	
-	color::rgb scaled(rgb);
-	color::scale_to_brightness(scaled, max_brightness);
-	for(uint8_t x = 0; x != ws2812_matrix::width; ++x)
-	{
-		for(int8_t i = row_count - 1; i >= 0; --i)
-			ws2812_matrix::set_pixel_color(x, full_rows[i], scaled);
-		
-		ws2812_matrix::show();
-		util::delay(150);
-	}
+	fill_full_rows(state, step % 2 ? color::rgb { 0, 0, 0 } : state.rgb);
+	ws2812_matrix::show();
+	return flash_step_ticks;
+}
+
+void fade_out(uint8_t& value)
+{
+	value = value > color_light_fade_step ? value - color_light_fade_step : 0;
+}
+
+uint16_t remove_rows_color_light(uint16_t step, void* context)
+{
+	rows_animation_state& state = *static_cast<rows_animation_state*>(context);
+	color::rgb scaled;
 	
-	for(uint8_t c = 0x33; c; --c)
+	//Light rows column by column
+	if(step < ws2812_matrix::width)
 	{
-		if(rgb.r)
-			rgb.r -= 5;
-		if(rgb.g)
-			rgb.g -= 5;
-		if(rgb.b)
-			rgb.b -= 5;
-		
-		scaled = rgb;
-		color::scale_to_brightness(scaled, max_brightness);
-		
-		for(int8_t i = row_count - 1; i >= 0; --i)
-		{
-			for(uint8_t x = 0; x != ws2812_matrix::width; ++x)
-				ws2812_matrix::set_pixel_color(x, full_rows[i], scaled);
-		}
+		scaled = state.rgb;
+		color::scale_to_brightness(scaled, state.max_brightness);
+		for(uint8_t i = 0; i != state.row_count; ++i)
+			ws2812_matrix::set_pixel_color(step, state.full_rows[i], scaled);
 		
 		ws2812_matrix::show();
+		return color_light_column_ticks;
 	}
+	
+	//Then fade them out, one fade step per tick
+	if(!state.rgb.r && !state.rgb.g && !state.rgb.b)
+		return 0;
+	
+	fade_out(state.rgb.r);
+	fade_out(state.rgb.g);
+	fade_out(state.rgb.b);
+	
+	scaled = state.rgb;
+	color::scale_to_brightness(scaled, state.max_brightness);
+	fill_full_rows(state, scaled);
+	ws2812_matrix::show();
+	return 1;
 }
 
-void check_filled_rows(uint32_t& score, uint8_t& multiplier,
-	uint8_t& game_difficulty, uint8_t& max_block_id, uint8_t max_brightness)
+///Removes full rows from the field and the display
+void remove_full_rows()
 {
-	uint8_t full_rows[ws2812_matrix::height];
-	uint8_t current_row_id = 0;
+	const uint8_t row_count = field.remove_full_rows([](uint8_t from_y, uint8_t to_y)
+		{ ws2812_matrix::copy_horizontal_line(from_y, to_y); });
+	if(row_count != ws2812_matrix::height)
+		ws2812_matrix::clear_horizontal_lines(row_count, ws2812_matrix::height - 1);
+}
+
+///Finds full rows and starts their removal animation.
+///Returns false if there are no full rows.
+bool start_rows_removal(animation& rows_animation, rows_animation_state& state,
+	uint8_t max_brightness)
+{
+	state.row_count = 0;
 	for(uint8_t y = 0; y != ws2812_matrix::height; ++y)
 	{
-		bool is_full = true;
-		for(uint8_t x = 0; x != ws2812_matrix::width; ++x)
-		{
-			if(!ws2812_matrix::is_on_fast(x, y))
-			{
-				is_full = false;
-				break;
-			}
-		}
-		
-		if(is_full)
-		{
-			full_rows[current_row_id] = y;
-			++current_row_id;
-		}
+		if(field.is_full(y))
+			state.full_rows[state.row_count++] = y;
 	}
 	
-	if(current_row_id)
+	if(!state.row_count)
+		return false;
+	
+	state.max_brightness = max_brightness;
+	const bool flash = rand() % 2;
+	create_bright_color(state.rgb);
+	if(flash)
 	{
-		if(rand() % 2)
-			remove_rows_flash(full_rows, current_row_id, max_brightness);
-		else
-			remove_rows_color_light(full_rows, current_row_id, max_brightness);
-		
-		for(uint8_t i = 0; i != current_row_id; ++i)
-		{
-			for(uint8_t y = full_rows[i] + 1 - i; y <= ws2812_matrix::height; ++y)
-			{
-				for(uint8_t x = 0; x != ws2812_matrix::width; ++x)
-					ws2812_matrix::copy_color(x, y, x, y - 1);
-			}
-		}
-		
-		ws2812_matrix::show();
-		
-		score += multiplier * current_row_id;
-		if(current_row_id > 1) //Combo
-			score += (multiplier * current_row_id) / combo_multiplier;
-		
-		if(score >= game::max_score)
-			score = game::max_score;
-		
-		number_display::output_number(score);
+		color::scale_to_brightness(state.rgb, max_brightness);
+		rows_animation.start(remove_rows_flash, &state);
+	}
+	else
+	{
+		rows_animation.start(remove_rows_color_light, &state);
 	}
 	
-	init_difficulty(score, multiplier, game_difficulty, max_block_id);
+	//Draw first step right away
+	rows_animation.tick();
+	return true;
+}
+
+void finish_rows_removal(uint8_t row_count, uint32_t& score, uint8_t multiplier)
+{
+	remove_full_rows();
+	ws2812_matrix::show();
+	
+	score += multiplier * row_count;
+	if(row_count > 1) //Combo
+		score += (multiplier * row_count) / combo_multiplier;
+	
+	if(score >= game::max_score)
+		score = game::max_score;
+	
+	number_display::output_number(score);
 }
 
-bool loop(uint32_t& score)
+uint16_t game_over_delay(uint16_t step, void*)
+{
+	return step ? 0 : game_over_ticks;
+}
+
+///Keeps final game field on display for a while.
+///Any button press skips the delay, returns true in this case.
+bool wait_after_game_over()
+{
+	buttons::flush_pressed();
+	
+	animation delay;
+	delay.start(game_over_delay, nullptr);
+	while(delay.tick())
+	{
+		timer::wait_for_interrupt();
+		if(buttons::is_any_pressed())
+			return true;
+	}
+	
+	return false;
+}
+
+///Runs game until game over or exit. In demo mode blocks are placed
+///by autoplayer, and any button press exits the game.
+///Returns true if game was interrupted.
+bool loop(uint32_t& score, bool demo)
 {
 	score = 0;
 	const uint8_t max_brightness = options::get_max_brightness();
-	const bool accelerometer_enabled = options::is_accelerometer_enabled();
+	const bool accelerometer_enabled = !demo && options::is_accelerometer_enabled();
 	
 	block fig;
+	uint8_t block_id = 0, block_rotation = 0;
 	uint8_t block_x = invalid_block_pos, block_y = invalid_block_pos;
 	color::rgb block_color;
 	uint8_t new_x;
@@ -365,16 +506,46 @@ bool loop(uint32_t& score)
 	uint8_t max_block_id;
 	accelerometer::speed_state speed_state(5);
 	accelerometer::direction last_direction = accelerometer::direction_none;
+	animation rows_animation;
+	rows_animation_state rows_state;
+	demo_state demo_player;
+	move_direction demo_direction = move_direction_none;
 	
 	init_difficulty(score, multiplier, game_difficulty, max_block_id);
+	field.clear();
 	
 	while(true)
 	{
 		timer::wait_for_interrupt();
 		
+		if(demo && buttons::is_any_pressed())
+			return true;
+		
+		if(rows_animation.is_running())
+		{
+			if(!rows_animation.tick())
+			{
+				finish_rows_removal(rows_state.row_count, score, multiplier);
+				init_difficulty(score, multiplier, game_difficulty, max_block_id);
+			}
+			else if(buttons::get_button_status(buttons::button_up) != buttons::button_status_not_pressed
+				&& buttons::get_button_status(buttons::button_down) != buttons::button_status_not_pressed)
+			{
+				if(!game::pause_with_screen_backup())
+				{
+					number_display::output_number(score);
+					return true;
+				}
+				
+				number_display::output_number(score);
+			}
+			
+			continue;
+		}
+		
 		if(block_x == invalid_block_pos)
 		{
-			fig = create_block(max_block_id);
+			fig = create_block(max_block_id, block_id, block_rotation);
 			game::get_random_color(block_color, max_brightness);
 			
 			block_y = ws2812_matrix::height - 1;
@@ -383,20 +554,25 @@ bool loop(uint32_t& score)
 			ws2812_matrix::show();
 			if(!have_space)
 				break; //No more space
+			
+			if(demo)
+				start_demo_search(demo_player, block_id);
 		}
 		
 		if(++game_counter == game_difficulty)
 		{
 			game_counter = 0;
 			hide_block(block_x, block_y, fig);
-			if(block_y == fig.height - 1 || intersects(fig, block_x, block_y - 1))
+			if(block_y == fig.height - 1 || field.intersects(fig, block_x, block_y - 1))
 			{
 				show_block(block_x, block_y, fig, block_color);
+				field.add_block(block_x, block_y, fig);
 				block_y = invalid_block_pos;
 				block_x = invalid_block_pos; //Force new block creation
 				//Re-initializes difficulty in case of fast drop
-				check_filled_rows(score, multiplier, game_difficulty, max_block_id,
-					max_brightness);
+				//(after full rows removal, if there are any)
+				if(!start_rows_removal(rows_animation, rows_state, max_brightness))
+					init_difficulty(score, multiplier, game_difficulty, max_block_id);
 				continue;
 			}
 			
@@ -404,8 +580,18 @@ bool loop(uint32_t& score)
 			need_redraw = true;
 		}
 		
-		auto button_up_status = buttons::get_button_status(buttons::button_up);
-		auto button_down_status = buttons::get_button_status(buttons::button_down);
+		buttons::button_status button_up_status, button_down_status;
+		if(demo)
+		{
+			get_demo_action(demo_player, block_x, block_rotation,
+				button_up_status, button_down_status, demo_direction);
+		}
+		else
+		{
+			button_up_status = buttons::get_button_status(buttons::button_up);
+			button_down_status = buttons::get_button_status(buttons::button_down);
+		}
+		
 		if(button_up_status != buttons::button_status_not_pressed
 			&& button_down_status != buttons::button_status_not_pressed)
 		{
@@ -429,7 +615,8 @@ bool loop(uint32_t& score)
 		if(button_up_status == buttons::button_status_pressed)
 		{
 			hide_block(block_x, block_y, fig);
-			const block new_fig = rotate_block(fig);
+			const uint8_t new_rotation = (block_rotation + 1) % block::rotation_count;
+			const block new_fig = load_block(block_id, new_rotation);
 			uint8_t move_left = 0;
 			
 			bool rotated = true;
@@ -442,7 +629,7 @@ bool loop(uint32_t& score)
 				if(new_fig.width + block_x > ws2812_matrix::width)
 					move_left = block_x + new_fig.width - ws2812_matrix::width;
 				
-				while(intersects(new_fig, block_x - move_left, block_y))
+				while(field.intersects(new_fig, block_x - move_left, block_y))
 				{
 					++move_left;
 					if(move_left == new_fig.width || block_x < move_left)
@@ -458,6 +645,7 @@ bool loop(uint32_t& score)
 				block_x -= move_left;
 				new_x = block_x;
 				fig = new_fig;
+				block_rotation = new_rotation;
 				need_redraw = true;
 			}
 			else
@@ -466,7 +654,9 @@ bool loop(uint32_t& score)
 			}
 		}
 		
-		switch(move_helper::process_speed(&speed_state, nullptr, accelerometer_enabled))
+		const move_direction direction = demo ? demo_direction
+			: move_helper::process_speed(&speed_state, nullptr, accelerometer_enabled);
+		switch(direction)
 		{
 			case move_direction_left:
 				if(new_x < ws2812_matrix::width - fig.width)
@@ -511,7 +701,7 @@ bool loop(uint32_t& score)
 		if(new_x != block_x)
 		{
 			hide_block(block_x, block_y, fig);
-			if(!intersects(fig, new_x, block_y))
+			if(!field.intersects(fig, new_x, block_y))
 			{
 				block_x = new_x;
 				need_redraw = true;
@@ -540,11 +730,30 @@ void tetris::run()
 	buttons::enable_repeat(buttons::mask_right | buttons::mask_left, true);
 	
 	uint32_t score = 0;
-	bool interrupted = loop(score);
+	bool interrupted = loop(score, false);
 	
 	buttons::enable_repeat(buttons::mask_right | buttons::mask_left, false);
 	
 	if(!interrupted)
-		util::delay(5000);
+		wait_after_game_over();
 	game::end(score, game::game_tetris);
 }
+
+void tetris::run_demo()
+{
+	buttons::flush_pressed();
+	
+	uint32_t score;
+	do
+	{
+		ws2812_matrix::clear();
+		ws2812_matrix::show();
+		number_display::output_number(0);
+	}
+	while(!loop(score, true) && !wait_after_game_over());
+	
+	buttons::flush_pressed();
+	ws2812_matrix::clear();
+	ws2812_matrix::show();
+	number_display::clear();
+}
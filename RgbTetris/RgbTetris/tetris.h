@@ -12,4 +12,7 @@ class tetris : static_class
 {
 public:
 	static void run();
+	
+	///Runs autoplayer demo until any button is pressed
+	static void run_demo();
 };
@@ -0,0 +1,301 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "util.h"
+
+///Tetris autoplayer. Evaluates every rotation and column of a block on the
+///field bitboard and picks the best placement using El-Tetris heuristic
+///(weighted Dellacherie features: landing height, eroded block cells, row and
+///column transitions, holes and wells).
+///Search can be spread over several calls to fit into the timer tick budget.
+///Only placements the block can reach by sliding along the top row from its
+///spawn column are evaluated. Blocks falling while they're moved and
+///rotation near walls are not simulated, so some chosen placements may
+///still be missed by the player.
+template<uint8_t Width, uint8_t Height>
+class tetris_ai
+{
+	//Row transitions are counted with walls on both sides
+	static_assert(Width < 16, "Field rows with walls must fit into 16-bit masks");
+	
+public:
+	///Field row, bit x is set if cell in column x is filled
+	using row_mask = uint16_t;
+	
+	static constexpr row_mask full_row_mask = static_cast<row_mask>((1ul << Width) - 1);
+	static constexpr uint8_t max_rotations = 4;
+	static constexpr uint8_t max_block_size = 4;
+	
+	///Block drop result
+	struct placement
+	{
+		//Landing height multiplied by 2
+		uint8_t landing_height_2;
+		uint8_t cleared_lines;
+		//Cleared lines multiplied by number of removed block cells
+		uint8_t eroded_cells;
+	};
+	
+	//Heuristic weights (multiplied by 100)
+	static constexpr int16_t landing_height_weight = -450;
+	static constexpr int16_t eroded_cells_weight = 342;
+	static constexpr int16_t row_transitions_weight = -322;
+	static constexpr int16_t column_transitions_weight = -935;
+	static constexpr int16_t holes_weight = -790;
+	static constexpr int16_t wells_weight = -339;
+	
+	///Block in a single rotation. Row 0 is the top row, bit x of a row is column x.
+	struct piece
+	{
+		uint8_t width;
+		uint8_t height;
+		uint8_t rows[max_block_size];
+	};
+	
+public:
+	tetris_ai()
+		:field_(nullptr),
+		rotation_count_(0),
+		rotation_(0),
+		x_(0),
+		found_(false),
+		duplicate_rotations_(0),
+		best_rotation_(0),
+		best_x_(0),
+		best_score_(0)
+	{
+	}
+	
+	/** Starts search. Field must not be changed until search is complete.
+	*   Rotations which are the same as one of previous rotations are skipped.
+	*   @param field Field rows, bottom row first
+	*   @param rotations All rotations of a block
+	*   @param rotation_count Number of rotations */
+	void start(const row_mask* field, const piece* rotations, uint8_t rotation_count)
+	{
+		field_ = field;
+		memcpy(rotations_, rotations, rotation_count * sizeof(piece));
+		rotation_count_ = rotation_count;
+		rotation_ = 0;
+		x_ = 0;
+		found_ = false;
+		
+		duplicate_rotations_ = 0;
+		for(uint8_t i = 1; i != rotation_count; ++i)
+		{
+			for(uint8_t j = 0; j != i; ++j)
+			{
+				if(!memcmp(&rotations_[i], &rotations_[j], sizeof(piece)))
+				{
+					duplicate_rotations_ |= 1 << i;
+					break;
+				}
+			}
+		}
+	}
+	
+	///Evaluates up to max_count placements. Returns true if search is complete.
+	bool search(uint8_t max_count)
+	{
+		row_mask field[Height];
+		for(; max_count && rotation_ != rotation_count_; --max_count)
+		{
+			const piece& p = rotations_[rotation_];
+			if(x_ + p.width > Width || (duplicate_rotations_ & (1 << rotation_)))
+			{
+				++rotation_;
+				x_ = 0;
+				continue;
+			}
+			
+			memcpy(field, field_, sizeof(field));
+			placement result;
+			if(is_reachable(field_, p, x_) && drop(field, p, x_, result))
+			{
+				const int32_t score = evaluate(field, result);
+				if(!found_ || score > best_score_)
+				{
+					found_ = true;
+					best_score_ = score;
+					best_rotation_ = rotation_;
+					best_x_ = x_;
+				}
+			}
+			
+			++x_;
+		}
+		
+		return is_complete();
+	}
+	
+	bool is_complete() const
+	{
+		return rotation_ == rotation_count_;
+	}
+	
+	///Returns true if block can be placed somewhere
+	bool is_found() const
+	{
+		return found_;
+	}
+	
+	uint8_t get_rotation() const
+	{
+		return best_rotation_;
+	}
+	
+	uint8_t get_x() const
+	{
+		return best_x_;
+	}
+	
+	///Returns true if block can slide along the top row from its spawn column to column x.
+	///Block spawns in the middle column, or in the first free column if the middle one is taken.
+	static bool is_reachable(const row_mask* field, const piece& p, uint8_t x)
+	{
+		uint8_t spawn_x = (Width - p.width) / 2;
+		if(intersects(field, p, spawn_x, Height - 1))
+		{
+			spawn_x = 0;
+			while(spawn_x != x && intersects(field, p, spawn_x, Height - 1))
+				++spawn_x;
+		}
+		
+		for(; spawn_x != x; spawn_x < x ? ++spawn_x : --spawn_x)
+		{
+			if(intersects(field, p, spawn_x, Height - 1))
+				return false;
+		}
+		
+		return !intersects(field, p, x, Height - 1);
+	}
+	
+	static bool intersects(const row_mask* field, const piece& p, uint8_t x, uint8_t y)
+	{
+		for(uint8_t i = 0; i != p.height; ++i)
+		{
+			if(field[y - i] & (static_cast<row_mask>(p.rows[i]) << x))
+				return true;
+		}
+		
+		return false;
+	}
+	
+	/** Drops block from the top of the field straight down and removes full rows.
+	*   @param field Field rows, bottom row first
+	*   @param p Block
+	*   @param x Block left column
+	*   @param result Placement result
+	*   @returns false if there's no space for block at the top of the field */
+	static bool drop(row_mask* field, const piece& p, uint8_t x, placement& result)
+	{
+		uint8_t y = Height - 1;
+		if(intersects(field, p, x, y))
+			return false;
+		
+		while(y != p.height - 1 && !intersects(field, p, x, y - 1))
+			--y;
+		
+		uint8_t block_cells_removed = 0;
+		for(uint8_t i = 0; i != p.height; ++i)
+		{
+			field[y - i] |= static_cast<row_mask>(p.rows[i]) << x;
+			if(field[y - i] == full_row_mask)
+				block_cells_removed += util::count_bits(p.rows[i]);
+		}
+		
+		//Sum of 1-based bottom and top row numbers
+		result.landing_height_2 = 2 * y - p.height + 3;
+		result.cleared_lines = remove_full_rows(field);
+		result.eroded_cells = result.cleared_lines * block_cells_removed;
+		return true;
+	}
+	
+	///Removes full rows, returns number of removed rows
+	static uint8_t remove_full_rows(row_mask* field)
+	{
+		uint8_t write_y = 0;
+		for(uint8_t y = 0; y != Height; ++y)
+		{
+			if(field[y] != full_row_mask)
+				field[write_y++] = field[y];
+		}
+		
+		const uint8_t cleared_lines = Height - write_y;
+		memset(field + write_y, 0, cleared_lines * sizeof(row_mask));
+		return cleared_lines;
+	}
+	
+	///Returns field score after block placement, the higher the better
+	static int32_t evaluate(const row_mask* field, const placement& result)
+	{
+		//Walls and the floor are treated as filled cells
+		constexpr uint32_t walls = 1ul | (1ul << (Width + 1));
+		constexpr uint32_t transition_mask = (1ul << (Width + 1)) - 1;
+		
+		uint8_t row_transitions = 0;
+		uint8_t column_transitions = 0;
+		uint8_t holes = 0;
+		uint16_t wells = 0;
+		uint8_t well_depths[Width] {};
+		row_mask well_columns = 0;
+		row_mask filled_above = 0;
+		for(uint8_t y = Height; y; --y)
+		{
+			const row_mask row = field[y - 1];
+			const uint32_t walled_row = (static_cast<uint32_t>(row) << 1) | walls;
+			row_transitions += count_row_bits(
+				static_cast<row_mask>((walled_row ^ (walled_row >> 1)) & transition_mask));
+			column_transitions += count_row_bits(row ^ (y == 1 ? full_row_mask : field[y - 2]));
+			holes += count_row_bits(filled_above & ~row);
+			filled_above |= row;
+			
+			//Empty cells with filled cells on the left and on the right
+			const row_mask well_cells = static_cast<row_mask>(
+				(~walled_row & (walled_row << 1) & (walled_row >> 1)) >> 1);
+			if(well_cells | well_columns)
+			{
+				for(uint8_t x = 0; x != Width; ++x)
+				{
+					if(well_cells & (1 << x))
+						wells += ++well_depths[x];
+					else
+						well_depths[x] = 0;
+				}
+				
+				well_columns = well_cells;
+			}
+		}
+		
+		return static_cast<int32_t>(landing_height_weight / 2) * result.landing_height_2
+			+ static_cast<int32_t>(eroded_cells_weight) * result.eroded_cells
+			+ static_cast<int32_t>(row_transitions_weight) * row_transitions
+			+ static_cast<int32_t>(column_transitions_weight) * column_transitions
+			+ static_cast<int32_t>(holes_weight) * holes
+			+ static_cast<int32_t>(wells_weight) * wells;
+	}
+	
+	static uint8_t count_row_bits(row_mask value)
+	{
+		return util::count_bits(static_cast<uint8_t>(value))
+			+ util::count_bits(static_cast<uint8_t>(value >> 8));
+	}
+	
+private:
+	const row_mask* field_;
+	piece rotations_[max_rotations];
+	uint8_t rotation_count_;
+	uint8_t rotation_;
+	uint8_t x_;
+	bool found_;
+	//Bit r is set if rotation r is the same as one of previous rotations
+	uint8_t duplicate_rotations_;
+	uint8_t best_rotation_;
+	uint8_t best_x_;
+	int32_t best_score_;
+};
@@ -0,0 +1,96 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+///Fallen tetris blocks occupancy bitboard. Each row is a bit mask
+///(bit x is set if cell in column x is filled), bottom row first.
+///Blocks must provide height and row(i) (row 0 is the top one, bit x of a row is column x).
+template<uint8_t Width, uint8_t Height>
+class tetris_field
+{
+	static_assert(Width <= 16, "Field rows must fit into 16-bit masks");
+	
+public:
+	using row_mask = uint16_t;
+	
+	static constexpr row_mask full_row_mask = static_cast<row_mask>((1ul << Width) - 1);
+	
+public:
+	void clear()
+	{
+		memset(rows_, 0, sizeof(rows_));
+	}
+	
+	///Returns true if block with top left cell at [x, y] overlaps filled cells.
+	///Cells outside of the field are free.
+	template<typename Block>
+	bool intersects(const Block& b, uint8_t x, uint8_t y) const
+	{
+		if(x >= Width)
+			return false;
+		
+		for(uint8_t i = 0; i != b.height; ++i)
+		{
+			const uint8_t row_y = y - i;
+			if(row_y < Height && (rows_[row_y] & (static_cast<row_mask>(b.row(i)) << x)))
+				return true;
+		}
+		
+		return false;
+	}
+	
+	///Fills block cells with top left cell at [x, y]
+	template<typename Block>
+	void add_block(uint8_t x, uint8_t y, const Block& b)
+	{
+		for(uint8_t i = 0; i != b.height; ++i)
+		{
+			const uint8_t row_y = y - i;
+			if(row_y < Height)
+				rows_[row_y] |= (static_cast<row_mask>(b.row(i)) << x) & full_row_mask;
+		}
+	}
+	
+	bool is_full(uint8_t y) const
+	{
+		return rows_[y] == full_row_mask;
+	}
+	
+	/** Removes full rows, moving each remaining row down only once
+	*   @param move_row Called as move_row(from_y, to_y) for each moved row
+	*   @returns Number of remaining rows, rows above are empty */
+	template<typename MoveRow>
+	uint8_t remove_full_rows(MoveRow move_row)
+	{
+		uint8_t write_y = 0;
+		for(uint8_t y = 0; y != Height; ++y)
+		{
+			if(is_full(y))
+				continue;
+			
+			if(write_y != y)
+			{
+				move_row(y, write_y);
+				rows_[write_y] = rows_[y];
+			}
+			
+			++write_y;
+		}
+		
+		memset(rows_ + write_y, 0, (Height - write_y) * sizeof(rows_[0]));
+		return write_y;
+	}
+	
+	///Returns field rows, bottom row first
+	const row_mask* get_rows() const
+	{
+		return rows_;
+	}
+	
+private:
+	row_mask rows_[Height];
+};
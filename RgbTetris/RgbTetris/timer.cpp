@@ -15,6 +15,7 @@ void empty_function()
 }
 
 volatile timer::on_interrupt_function on_interrupt_callback = empty_function;
+timer::on_interrupt_function on_wait_callback = nullptr;
 } //namespace
 
 ISR(TIMER0_COMPA_vect)
@@ -38,6 +39,11 @@ void timer::on_interrupt(on_interrupt_function func)
 	on_interrupt_callback = func;
 }
 
+void timer::on_wait(on_interrupt_function func)
+{
+	on_wait_callback = func;
+}
+
 void timer::wait_for_interrupt()
 {
 	while(!signaled)
@@ -45,4 +51,7 @@ void timer::wait_for_interrupt()
 	}
 	
 	signaled = false;
+	
+	if(on_wait_callback)
+		on_wait_callback();
 }
@@ -18,6 +18,12 @@ public:
 	static constexpr uint8_t counter_value = 109;
 	static constexpr float frequency = (static_cast<float>(F_CPU) / prescaler) / counter_value;
 	
+	///Converts milliseconds to timer tick count (at least one tick)
+	static constexpr uint16_t ms_to_ticks(uint16_t ms)
+	{
+		return ms * frequency < 1000 ? 1 : static_cast<uint16_t>(ms * frequency / 1000 + 0.5f);
+	}
+	
 public:
 	static void init();
 	
@@ -25,6 +31,11 @@ public:
 	///one function can be specified at a time.
 	static void on_interrupt(on_interrupt_function func);
 	
+	///Function func will be called by wait_for_interrupt() after
+	///each timer interrupt (outside of interrupt handler).
+	///Only one function can be specified at a time, nullptr removes it.
+	static void on_wait(on_interrupt_function func);
+	
 	///Waits until timer interrupt occurs.
 	///Provides possibility to run code with timer interrupt frequency,
 	///but outside of interrupt handler routine.
@@ -7,6 +7,8 @@
 #include <avr/io.h>
 #include <avr/sfr_defs.h>
 
+#include <util/delay.h>
+
 #include "accelerometer.h"
 #include "adxl345.h"
 #include "buttons.h"
@@ -21,7 +23,9 @@
 
 namespace
 {
-void init_uart()
+constexpr uint16_t receive_timeout_ms = 1000;
+
+void init_uart(bool enable_receive_interrupt)
 {
 #	define BAUD_TOL 3
 #	define BAUD 115200 //2.1% error on 16 MHz
@@ -40,8 +44,10 @@ void init_uart()
 
 	//Default uart mode is 8 bit data, 1 stop bit
 	
-	//Enable send and receive, also enable data received interrupt
-	UCSR1B |= _BV(RXEN1) | _BV(TXEN1) | _BV(RXCIE1);
+	//Enable send and receive, also enable data received interrupt if needed
+	UCSR1B |= _BV(RXEN1) | _BV(TXEN1);
+	if(enable_receive_interrupt)
+		UCSR1B |= _BV(RXCIE1);
 }
 
 void stop_uart()
@@ -350,7 +356,7 @@ void reset()
 
 void uart::run()
 {
-	init_uart();
+	init_uart(true);
 	
 	reset();
 	process_uart();
@@ -358,3 +364,47 @@ void uart::run()
 	stop_uart();
 	reset();
 }
+
+void uart::start_raw()
+{
+	init_uart(false);
+	
+	//Drop stale incoming data
+	while(bit_is_set(UCSR1A, RXC1))
+		static_cast<void>(UDR1);
+}
+
+void uart::stop_raw()
+{
+	//Wait until last byte is sent
+	if(bit_is_set(UCSR1B, TXEN1))
+		loop_until_bit_is_set(UCSR1A, UDRE1);
+	
+	stop_uart();
+}
+
+void uart::send_byte(uint8_t value)
+{
+	loop_until_bit_is_set(UCSR1A, UDRE1);
+	UDR1 = value;
+}
+
+bool uart::receive_byte(uint8_t& value)
+{
+	send_byte(ready_sequence);
+	for(uint16_t i = 0; i != receive_timeout_ms; ++i)
+	{
+		for(uint8_t j = 0; j != 100; ++j)
+		{
+			if(bit_is_set(UCSR1A, RXC1))
+			{
+				value = UDR1;
+				return true;
+			}
+			
+			_delay_us(10);
+		}
+	}
+	
+	return false;
+}
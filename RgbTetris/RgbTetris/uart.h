@@ -120,4 +120,16 @@ public:
 	
 public:
 	static void run();
+	
+	///Starts UART for raw data transfer without protocol processing
+	///(used by input recorder, see input_recorder.h)
+	static void start_raw();
+	static void stop_raw();
+	
+	///Sends byte in raw mode, waits until transmitter is ready
+	static void send_byte(uint8_t value);
+	
+	///Sends ready_sequence in raw mode and waits for a byte from other
+	///device. Returns false if nothing was received within ~1 second.
+	static bool receive_byte(uint8_t& value);
 };
@@ -4,6 +4,12 @@
 #include "util.h"
 
 #include <avr/cpufunc.h>
+#include <avr/pgmspace.h>
+
+namespace
+{
+const uint8_t nibble_bit_count[16] PROGMEM = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+} //namespace
 
 void util::delay(uint16_t x)
 {
@@ -45,3 +51,8 @@ uint16_t util::isqrt(uint16_t n)
 		
 	return root;
 }
+
+uint8_t util::count_bits(uint8_t value)
+{
+	return pgm_read_byte(&nibble_bit_count[value & 0x0f]) + pgm_read_byte(&nibble_bit_count[value >> 4]);
+}
@@ -62,6 +62,9 @@ public:
 	///Fast integer square root
 	static uint16_t isqrt(uint16_t n);
 	
+	///Returns number of set bits
+	static uint8_t count_bits(uint8_t value);
+	
 	static constexpr uint16_t round_to_power_of_2(uint16_t value)
 	{
 		--value;
@@ -340,6 +340,11 @@ void ws2812_matrix::clear_horizontal_lines(uint8_t y_from, uint8_t y_to)
 		0, (y_to - y_from + 1) * width * bytes_per_led);
 }
 
+void ws2812_matrix::copy_horizontal_line(uint8_t from_y, uint8_t to_y)
+{
+	memmove(pixels_[to_y], pixels_[from_y], width * bytes_per_led);
+}
+
 void ws2812_matrix::shift_right(uint8_t y_from, uint8_t y_to)
 {
 	for(uint8_t y = y_from; y != y_to + 1; ++y)
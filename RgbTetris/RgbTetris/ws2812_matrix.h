@@ -42,6 +42,7 @@ public:
 	static void set_pixel_color(uint8_t x, uint8_t y, uint32_t color);
 	static void clear();
 	static void clear_horizontal_lines(uint8_t y_from, uint8_t y_to);
+	static void copy_horizontal_line(uint8_t from_y, uint8_t to_y);
 	
 	static uint32_t get_pixel_color(uint8_t x, uint8_t y);
 	static uint8_t* get_pixels();
@@ -0,0 +1,8 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#pragma once
+
+//Host replacement of avr-libc CPU helpers used by util.cpp
+
+#define _NOP()
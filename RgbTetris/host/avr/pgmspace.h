@@ -0,0 +1,14 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+#pragma once
+
+//Host replacement of avr-libc program memory helpers, so that firmware
+//tables can be used by host builds as is
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define memcpy_P memcpy
+#define pgm_read_byte(address) (*reinterpret_cast<const uint8_t*>(address))
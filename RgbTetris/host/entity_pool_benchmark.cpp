@@ -0,0 +1,178 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+//Host benchmark of entity pool. Runs the same random bullet workload (shoot,
+//move, hit) on entity_pool and on the former bullet arrays with active flags
+//and linear scans, checks that both produce the same slots and reports speed.
+
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "entity_pool.h"
+
+namespace
+{
+constexpr uint8_t field_height = 16;
+//Probabilities are out of 256
+constexpr uint8_t shoot_probability = 96;
+constexpr uint8_t hit_probability = 8;
+
+struct bullet
+{
+	uint8_t x;
+	uint8_t y;
+};
+
+///Former bullet storage: active flag per bullet, free slot is found by linear scan
+template<uint8_t Capacity>
+struct scan_pool
+{
+	struct entry
+	{
+		bullet value;
+		bool active;
+	};
+	
+	scan_pool()
+		:count(0)
+	{
+		memset(entries, 0, sizeof(entries));
+	}
+	
+	uint8_t allocate()
+	{
+		if(count == Capacity)
+			return 0xff;
+		
+		for(uint8_t i = 0; i != Capacity; ++i)
+		{
+			if(!entries[i].active)
+			{
+				entries[i].active = true;
+				++count;
+				return i;
+			}
+		}
+		
+		return 0xff;
+	}
+	
+	void release(uint8_t index)
+	{
+		entries[index].active = false;
+		--count;
+	}
+	
+	template<typename Func>
+	void for_each(Func func)
+	{
+		for(uint8_t i = 0; i != Capacity; ++i)
+		{
+			if(entries[i].active)
+				func(entries[i].value, i);
+		}
+	}
+	
+	bullet& operator[](uint8_t index)
+	{
+		return entries[index].value;
+	}
+	
+	uint8_t count;
+	entry entries[Capacity];
+};
+
+template<uint8_t Capacity>
+struct bitmask_pool : entity_pool<bullet, Capacity>
+{
+	using base = entity_pool<bullet, Capacity>;
+	
+	template<typename Func>
+	void for_each(Func func)
+	{
+		for(uint8_t i = base::first_active(); i != base::no_slot; i = base::next_active(i))
+			func((*this)[i], i);
+	}
+};
+
+uint32_t xorshift(uint32_t& state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+///Returns checksum of allocated slots and hits
+template<typename Pool>
+uint64_t run(uint32_t steps, uint32_t seed)
+{
+	Pool pool;
+	uint64_t checksum = 0;
+	for(uint32_t step = 0; step != steps; ++step)
+	{
+		if((xorshift(seed) & 0xff) < shoot_probability)
+		{
+			const uint8_t index = pool.allocate();
+			if(index != 0xff)
+			{
+				pool[index] = { static_cast<uint8_t>(step % 10), 0 };
+				checksum = checksum * 31 + index;
+			}
+		}
+		
+		const uint32_t random = xorshift(seed);
+		pool.for_each([&pool, &checksum, random](bullet& b, uint8_t index) {
+			if(++b.y == field_height || ((random >> (index * 2)) & 0xff) < hit_probability)
+			{
+				pool.release(index);
+				checksum = checksum * 31 + b.y;
+			}
+		});
+	}
+	
+	return checksum;
+}
+
+template<uint8_t Capacity>
+bool compare(uint32_t steps, uint32_t seed)
+{
+	auto start = std::chrono::steady_clock::now();
+	const uint64_t scan_checksum = run<scan_pool<Capacity>>(steps, seed);
+	const double scan_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	
+	start = std::chrono::steady_clock::now();
+	const uint64_t pool_checksum = run<bitmask_pool<Capacity>>(steps, seed);
+	const double pool_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	
+	printf("Capacity %u: linear scan %.1f ns per step, entity pool %.1f ns per step\n",
+		Capacity, scan_seconds * 1e9 / steps, pool_seconds * 1e9 / steps);
+	if(scan_checksum != pool_checksum)
+	{
+		printf("Capacity %u: results differ\n", Capacity);
+		return false;
+	}
+	
+	return true;
+}
+} //namespace
+
+int main(int argc, char** argv)
+{
+	const uint32_t steps = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 10000000;
+	const uint32_t seed = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 1;
+	if(!steps || !seed)
+	{
+		fprintf(stderr, "Usage: entity_pool_benchmark [step count] [seed]\n");
+		return 1;
+	}
+	
+	//Flight and space invaders bullet pool sizes, and the largest supported size
+	bool same = compare<4>(steps, seed);
+	same = compare<8>(steps, seed) && same;
+	same = compare<16>(steps, seed) && same;
+	return same ? 0 : 1;
+}
@@ -0,0 +1,448 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+//Host benchmark of maze generation. Generates mazes of every maze game level,
+//checks that each maze is a spanning tree (every cell is reachable, no loops)
+//and reports generation time per level.
+//Growing tree levels are also generated with the former selection of the
+//frontier cell by scanning the whole maze, for comparison. Then checks the
+//largest lazily generated (chunked) maze the same way, and checks that its
+//chunks are the same when they're generated again.
+//Finally generates level mazes as the game does (entrance, exit and loops)
+//and solves them by following distances to the exit, to check that each
+//level can be passed in its allowed time.
+
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "chunked_maze.h"
+#include "maze_distance_field.h"
+#include "maze_grid.h"
+#include "maze_levels.h"
+
+namespace
+{
+constexpr uint8_t level_count = sizeof(maze_levels) / sizeof(maze_levels[0]);
+
+constexpr uint32_t max_cell_count = chunked_maze::max_size * chunked_maze::max_size;
+
+//Same as in maze.cpp
+constexpr uint8_t cell_size_increment = 3;
+//Timer ticks per game second (see timer.h) and direction
+//button repeat ticks when it's held (see buttons.cpp)
+constexpr uint32_t ticks_per_second = 143;
+constexpr uint32_t first_repeat_ticks = 50;
+constexpr uint32_t repeat_ticks = 50 - 37;
+
+maze_grid grid;
+chunked_maze chunks;
+maze_distance_field distances;
+
+///Returns number of cells reachable from the top left cell
+template<typename Maze>
+uint32_t count_reachable_cells(Maze& maze)
+{
+	static bool visited[max_cell_count];
+	static uint16_t cells[max_cell_count];
+	const uint8_t width = maze.get_width();
+	memset(visited, 0, sizeof(visited));
+	
+	uint32_t read_index = 0, write_index = 0;
+	cells[write_index++] = 0;
+	visited[0] = true;
+	while(read_index != write_index)
+	{
+		const uint16_t cell = cells[read_index++];
+		const uint8_t x = cell % width, y = cell / width;
+		const uint16_t neighbours[] = {
+			!maze.has_wall(x, y, maze_grid::wall_left) ? static_cast<uint16_t>(cell - 1) : cell,
+			!maze.has_wall(x, y, maze_grid::wall_right) ? static_cast<uint16_t>(cell + 1) : cell,
+			!maze.has_wall(x, y, maze_grid::wall_up) ? static_cast<uint16_t>(cell - width) : cell,
+			!maze.has_wall(x, y, maze_grid::wall_down) ? static_cast<uint16_t>(cell + width) : cell
+		};
+		
+		for(uint16_t next : neighbours)
+		{
+			if(!visited[next])
+			{
+				visited[next] = true;
+				cells[write_index++] = next;
+			}
+		}
+	}
+	
+	return write_index;
+}
+
+///Returns number of removed walls between cells, or -1 if
+///walls of neighbour cells don't match or border walls are removed
+template<typename Maze>
+int32_t count_passages(Maze& maze)
+{
+	int32_t passages = 0;
+	for(uint8_t y = 0; y != maze.get_height(); ++y)
+	{
+		for(uint8_t x = 0; x != maze.get_width(); ++x)
+		{
+			const bool right_open = !maze.has_wall(x, y, maze_grid::wall_right);
+			const bool down_open = !maze.has_wall(x, y, maze_grid::wall_down);
+			if((x + 1 == maze.get_width() ? right_open : right_open == maze.has_wall(x + 1, y, maze_grid::wall_left))
+				|| (y + 1 == maze.get_height() ? down_open : down_open == maze.has_wall(x, y + 1, maze_grid::wall_up))
+				|| (!x && !maze.has_wall(x, y, maze_grid::wall_left))
+				|| (!y && !maze.has_wall(x, y, maze_grid::wall_up)))
+			{
+				return -1;
+			}
+			
+			passages += right_open + down_open;
+		}
+	}
+	
+	return passages;
+}
+
+///Returns distance between cells in the grid found by plain breadth-first search
+uint16_t get_shortest_distance(const util::coord& from, const util::coord& to)
+{
+	static uint16_t cell_distances[maze_grid::max_cell_count];
+	static uint16_t cells[maze_grid::max_cell_count];
+	const uint8_t width = grid.get_width();
+	memset(cell_distances, 0xff, sizeof(cell_distances));
+	
+	uint16_t read_index = 0, write_index = 0;
+	cells[write_index++] = from.y * width + from.x;
+	cell_distances[cells[0]] = 0;
+	while(read_index != write_index)
+	{
+		const uint16_t cell = cells[read_index++];
+		const uint8_t x = cell % width, y = cell / width;
+		const uint16_t neighbours[] = {
+			!grid.has_wall(x, y, maze_grid::wall_left) ? static_cast<uint16_t>(cell - 1) : cell,
+			!grid.has_wall(x, y, maze_grid::wall_right) ? static_cast<uint16_t>(cell + 1) : cell,
+			!grid.has_wall(x, y, maze_grid::wall_up) ? static_cast<uint16_t>(cell - width) : cell,
+			!grid.has_wall(x, y, maze_grid::wall_down) ? static_cast<uint16_t>(cell + width) : cell
+		};
+		
+		for(uint16_t next : neighbours)
+		{
+			if(cell_distances[next] == UINT16_MAX)
+			{
+				cell_distances[next] = cell_distances[cell] + 1;
+				cells[write_index++] = next;
+			}
+		}
+	}
+	
+	return cell_distances[to.y * width + to.x];
+}
+
+///Generates the maze and chooses its entrance and exit as load_level() in maze.cpp does
+void generate_level_maze(const maze_level& info, util::coord& entrance, util::coord& exit)
+{
+	grid.init(info.width, info.height);
+	if(info.flags == algo_growing_tree_corners)
+		grid.generate_growing_tree();
+	else
+		grid.generate_dfs(exit, entrance);
+	
+	if(info.flags != algo_dfs_long_path)
+	{
+		const uint8_t last_x = info.width - 1, last_y = info.height - 1;
+		if(rand() % 2)
+		{
+			entrance = { 0, 0 };
+			exit = { last_x, last_y };
+		}
+		else
+		{
+			entrance = { last_x, 0 };
+			exit = { 0, last_y };
+		}
+		
+		if(rand() % 2)
+			util::swap(entrance, exit);
+	}
+	
+	if(info.random_passage_probability)
+		grid.add_random_passages(info.random_passage_probability * 4);
+}
+
+///Ticks to move the character by the pixel count holding a direction button
+uint32_t get_run_ticks(uint32_t pixels)
+{
+	if(!pixels)
+		return 0;
+	
+	return 1 + (pixels > 1 ? first_repeat_ticks + (pixels - 2) * repeat_ticks : 0);
+}
+
+/** Auto-solver, which moves the character from the entrance to the exit
+*   to the neighbour cell closer to the exit each step.
+*   @param path_length Number of cells passed
+*   @return Ticks it takes, or 0 if the way is not found or it's not the shortest one */
+uint32_t solve_level_maze(const maze_level& info, const util::coord& entrance, const util::coord& exit,
+	uint16_t& path_length)
+{
+	path_length = 0;
+	uint16_t max_distance;
+	if(!distances.calculate(grid, exit.x, exit.y, max_distance))
+		return 0;
+	
+	const uint8_t cell_pixels = info.cell_size + cell_size_increment - 1;
+	uint8_t x = entrance.x, y = entrance.y, previous_pos = 0;
+	uint32_t ticks = 0, run_pixels = 0;
+	//Distance tracked as the game does when the character moves
+	int32_t distance = distances.get_distance(grid, x, y);
+	while(const uint8_t pos = distances.get_exit_direction(grid, x, y))
+	{
+		if(pos != previous_pos)
+		{
+			ticks += get_run_ticks(run_pixels);
+			run_pixels = 0;
+			previous_pos = pos;
+		}
+		
+		const uint8_t from_x = x, from_y = y;
+		maze_distance_field::move(x, y, static_cast<maze_grid::wall_position>(pos));
+		distance += distances.get_distance_change(from_x, from_y, x, y);
+		run_pixels += cell_pixels;
+		if(++path_length > max_distance)
+			return 0;
+	}
+	
+	ticks += get_run_ticks(run_pixels);
+	if(x != exit.x || y != exit.y || distance
+		|| path_length != get_shortest_distance(entrance, exit))
+	{
+		return 0;
+	}
+	
+	return ticks;
+}
+
+uint8_t get_right_and_down_walls(chunked_maze& maze, uint32_t cell)
+{
+	const uint8_t x = cell % maze.get_width(), y = cell / maze.get_width();
+	return maze.has_wall(x, y, maze_grid::wall_right) | (maze.has_wall(x, y, maze_grid::wall_down) << 1);
+}
+
+///Former growing tree generator, which finds the randomly chosen
+///frontier cell by scanning the whole maze
+void generate_growing_tree_scan(uint8_t width, uint8_t height)
+{
+	enum : uint8_t { state_unvisited, state_in_list, state_removed };
+	static uint8_t states[maze_grid::max_cell_count];
+	static uint8_t walls[maze_grid::max_cell_count];
+	memset(states, 0, sizeof(states));
+	memset(walls, 0, sizeof(walls));
+	
+	uint16_t list_count = 1;
+	states[(rand() % height) * width + rand() % width] = state_in_list;
+	while(list_count)
+	{
+		uint16_t cell_index = rand() % list_count;
+		uint16_t cell = 0;
+		for(uint8_t x = 0; x != width; ++x)
+		{
+			for(uint8_t y = 0; y != height; ++y)
+			{
+				if(states[y * width + x] == state_in_list && !cell_index--)
+				{
+					cell = y * width + x;
+					x = width - 1;
+					break;
+				}
+			}
+		}
+		
+		const uint8_t x = cell % width, y = cell / width;
+		uint16_t unvisited[4];
+		uint8_t unvisited_count = 0;
+		if(x && states[cell - 1] == state_unvisited)
+			unvisited[unvisited_count++] = cell - 1;
+		if(x + 1 != width && states[cell + 1] == state_unvisited)
+			unvisited[unvisited_count++] = cell + 1;
+		if(y && states[cell - width] == state_unvisited)
+			unvisited[unvisited_count++] = cell - width;
+		if(y + 1 != height && states[cell + width] == state_unvisited)
+			unvisited[unvisited_count++] = cell + width;
+		
+		if(!unvisited_count)
+		{
+			states[cell] = state_removed;
+			--list_count;
+			continue;
+		}
+		
+		const uint16_t next = unvisited[rand() % unvisited_count];
+		walls[cell] |= 1;
+		walls[next] |= 1;
+		states[next] = state_in_list;
+		++list_count;
+	}
+}
+
+const char* get_algorithm_name(uint8_t flags)
+{
+	switch(flags)
+	{
+		case algo_dfs_long_path:
+			return "depth-first search";
+		
+		case algo_dfs_corners:
+			return "depth-first search, corners";
+		
+		case algo_growing_tree_corners:
+			return "growing tree, corners";
+		
+		default:
+			return "unknown";
+	}
+}
+} //namespace
+
+int main(int argc, char** argv)
+{
+	const uint32_t maze_count = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 100;
+	const uint32_t seed = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 1;
+	if(!maze_count || !seed)
+	{
+		fprintf(stderr, "Usage: maze_benchmark [maze count per level] [seed]\n");
+		return 1;
+	}
+	
+	bool valid = true;
+	for(uint8_t level_id = 0; level_id != level_count; ++level_id)
+	{
+		maze_level info;
+		memcpy_P(&info, &maze_levels[level_id], sizeof(info));
+		
+		const uint16_t cell_count = info.width * info.height;
+		double seconds = 0;
+		uint32_t invalid_mazes = 0;
+		for(uint32_t i = 0; i != maze_count; ++i)
+		{
+			srand(seed + i);
+			const auto start = std::chrono::steady_clock::now();
+			grid.init(info.width, info.height);
+			util::coord start_cell, deepest_cell;
+			if(info.flags == algo_growing_tree_corners)
+				grid.generate_growing_tree();
+			else
+				grid.generate_dfs(start_cell, deepest_cell);
+			seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			
+			if(count_passages(grid) != cell_count - 1 || count_reachable_cells(grid) != cell_count)
+				++invalid_mazes;
+		}
+		
+		printf("Level %2u: %2ux%-2u %-28s %9.1f us per maze", level_id + 1, info.width, info.height,
+			get_algorithm_name(info.flags), seconds * 1e6 / maze_count);
+		
+		if(info.flags == algo_growing_tree_corners)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			for(uint32_t i = 0; i != maze_count; ++i)
+			{
+				srand(seed + i);
+				generate_growing_tree_scan(info.width, info.height);
+			}
+			
+			const double scan_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			printf(" (maze scan %.1f us)", scan_seconds * 1e6 / maze_count);
+		}
+		
+		printf("\n");
+		if(invalid_mazes)
+		{
+			printf("Level %2u: %u invalid mazes\n", level_id + 1, invalid_mazes);
+			valid = false;
+		}
+	}
+	
+	//Biggest hard mode maze, with and without loops inside chunks
+	for(uint8_t probability = 0; probability <= 16; probability += 16)
+	{
+		const uint32_t cell_count = chunked_maze::max_size * chunked_maze::max_size;
+		const uint32_t chunk_count = (chunked_maze::max_size + chunked_maze::chunk_size - 1) / chunked_maze::chunk_size
+			* ((chunked_maze::max_size + chunked_maze::chunk_size - 1) / chunked_maze::chunk_size);
+		uint32_t invalid_mazes = 0;
+		double seconds = 0;
+		for(uint32_t i = 0; i != maze_count; ++i)
+		{
+			chunks.init(chunked_maze::max_size, chunked_maze::max_size, static_cast<uint16_t>(seed + i), probability);
+			
+			//Each chunk is generated once when walls are read chunk by chunk
+			const auto start = std::chrono::steady_clock::now();
+			for(uint8_t chunk_y = 0; chunk_y <= (chunked_maze::max_size - 1) / chunked_maze::chunk_size; ++chunk_y)
+			{
+				for(uint8_t chunk_x = 0; chunk_x <= (chunked_maze::max_size - 1) / chunked_maze::chunk_size; ++chunk_x)
+					chunks.has_wall(chunk_x * chunked_maze::chunk_size, chunk_y * chunked_maze::chunk_size, maze_grid::wall_right);
+			}
+			seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			
+			//Walls read in reverse order come from regenerated chunks
+			static uint8_t walls[max_cell_count];
+			bool same_walls = true;
+			for(uint32_t cell = 0; cell != cell_count; ++cell)
+				walls[cell] = get_right_and_down_walls(chunks, cell);
+			for(uint32_t cell = cell_count; cell; --cell)
+				same_walls = same_walls && walls[cell - 1] == get_right_and_down_walls(chunks, cell - 1);
+			
+			const int32_t passages = count_passages(chunks);
+			if(passages < 0 || (!probability && static_cast<uint32_t>(passages) != cell_count - 1)
+				|| count_reachable_cells(chunks) != cell_count || !same_walls)
+			{
+				++invalid_mazes;
+			}
+		}
+		
+		printf("Chunked: %ux%u, loop probability %2u, %9.1f us per chunk (%u bytes)\n", chunked_maze::max_size,
+			chunked_maze::max_size, probability, seconds * 1e6 / maze_count / chunk_count,
+			static_cast<unsigned>(sizeof(chunked_maze)));
+		if(invalid_mazes)
+		{
+			printf("Chunked: %u invalid mazes\n", invalid_mazes);
+			valid = false;
+		}
+	}
+	
+	//Solve each level as fast as buttons allow
+	for(uint8_t level_id = 0; level_id != level_count; ++level_id)
+	{
+		maze_level info;
+		memcpy_P(&info, &maze_levels[level_id], sizeof(info));
+		
+		uint32_t max_ticks = 0, failed_mazes = 0;
+		uint16_t max_path_length = 0;
+		for(uint32_t i = 0; i != maze_count; ++i)
+		{
+			srand(seed + i);
+			util::coord entrance, exit;
+			generate_level_maze(info, entrance, exit);
+			
+			uint16_t path_length;
+			const uint32_t ticks = solve_level_maze(info, entrance, exit, path_length);
+			if(!ticks || ticks > info.allowed_time * 10u * ticks_per_second)
+				++failed_mazes;
+			
+			if(ticks > max_ticks)
+				max_ticks = ticks;
+			if(path_length > max_path_length)
+				max_path_length = path_length;
+		}
+		
+		printf("Level %2u: solved in %5.1f s at most, %3u s allowed, longest way %3u cells\n", level_id + 1,
+			static_cast<double>(max_ticks) / ticks_per_second, info.allowed_time * 10u, max_path_length);
+		if(failed_mazes)
+		{
+			printf("Level %2u: %u mazes are not solved in time\n", level_id + 1, failed_mazes);
+			valid = false;
+		}
+	}
+	
+	return valid ? 0 : 1;
+}
@@ -0,0 +1,168 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+//Host stress test of snake autopilot. Plays several games until the snake
+//fills the whole field or crashes, and reports decision speed, number of
+//moves per game and number of crashed games.
+
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "snake_ai.h"
+
+namespace
+{
+constexpr uint8_t field_width = 10;
+constexpr uint8_t field_height = 16;
+constexpr uint8_t init_length = 3;
+constexpr uint32_t max_moves_per_game = 1000000;
+
+using autopilot = snake_ai<field_width, field_height>;
+
+struct cell
+{
+	uint8_t x;
+	uint8_t y;
+};
+
+struct field
+{
+	bool occupied[field_height][field_width];
+	//Ring buffer of snake cells, tail first
+	cell cells[autopilot::cell_count];
+	uint8_t tail;
+	uint8_t length;
+	
+	void push_head(uint8_t x, uint8_t y)
+	{
+		cells[(tail + length++) % autopilot::cell_count] = { x, y };
+		occupied[y][x] = true;
+	}
+	
+	void pop_tail()
+	{
+		const cell& c = cells[tail];
+		occupied[c.y][c.x] = false;
+		tail = (tail + 1) % autopilot::cell_count;
+		--length;
+	}
+	
+	const cell& get_head() const
+	{
+		return cells[(tail + length - 1) % autopilot::cell_count];
+	}
+};
+
+uint32_t xorshift(uint32_t& state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+//Straight snake in random place and direction, as in the game
+void init(field& f, uint32_t& seed)
+{
+	f = field {};
+	const bool horizontal = xorshift(seed) & 1;
+	const bool reverse = xorshift(seed) & 1;
+	uint8_t x = xorshift(seed) % field_width;
+	uint8_t y = xorshift(seed) % field_height;
+	if(horizontal)
+		x = xorshift(seed) % (field_width - init_length + 1);
+	else
+		y = xorshift(seed) % (field_height - init_length + 1);
+	
+	for(uint8_t i = 0; i != init_length; ++i)
+	{
+		const uint8_t offset = reverse ? init_length - 1 - i : i;
+		f.push_head(horizontal ? x + offset : x, horizontal ? y : y + offset);
+	}
+}
+
+bool place_food(const field& f, uint32_t& seed, cell& food)
+{
+	const uint8_t free_count = autopilot::cell_count - f.length;
+	if(!free_count)
+		return false;
+	
+	uint8_t rank = xorshift(seed) % free_count;
+	for(uint8_t y = 0; y != field_height; ++y)
+	{
+		for(uint8_t x = 0; x != field_width; ++x)
+		{
+			if(!f.occupied[y][x] && !rank--)
+			{
+				food = { x, y };
+				return true;
+			}
+		}
+	}
+	
+	return false;
+}
+} //namespace
+
+int main(int argc, char** argv)
+{
+	const uint32_t game_count = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 100;
+	uint32_t seed = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 1;
+	if(!game_count || !seed)
+	{
+		fprintf(stderr, "Usage: snake_ai_benchmark [game count] [seed]\n");
+		return 1;
+	}
+	
+	field f;
+	autopilot ai;
+	uint64_t total_moves = 0;
+	uint32_t crashed_games = 0;
+	const auto start = std::chrono::steady_clock::now();
+	for(uint32_t game = 0; game != game_count; ++game)
+	{
+		init(f, seed);
+		ai.start();
+		cell food;
+		place_food(f, seed, food);
+		
+		uint32_t moves = 0;
+		bool crashed = false;
+		for(; moves != max_moves_per_game; ++moves)
+		{
+			const cell& head = f.get_head();
+			const cell& tail = f.cells[f.tail];
+			uint8_t x = head.x, y = head.y;
+			if(!ai.get_next_cell([&f](uint8_t cell_x, uint8_t cell_y) { return f.occupied[cell_y][cell_x]; },
+				f.length, tail.x, tail.y, food.x, food.y, x, y))
+			{
+				crashed = true;
+				break;
+			}
+			
+			const bool has_food = x == food.x && y == food.y;
+			if(!has_food)
+				f.pop_tail();
+			
+			f.push_head(x, y);
+			if(has_food && !place_food(f, seed, food))
+				break;
+		}
+		
+		if(crashed || moves == max_moves_per_game)
+		{
+			++crashed_games;
+			printf("Game %u: crashed at length %u after %u moves\n", game + 1, f.length, moves);
+		}
+		
+		total_moves += moves;
+	}
+	
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("Moves per second: %.0f\n", total_moves / seconds);
+	printf("Average moves per game: %.1f\n", static_cast<double>(total_moves) / game_count);
+	printf("Games which didn't fill the field: %u of %u\n", crashed_games, game_count);
+	return 0;
+}
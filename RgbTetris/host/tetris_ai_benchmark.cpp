@@ -0,0 +1,120 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+//Host benchmark of tetris autoplayer. Plays several games with standard
+//tetris blocks (first 7 blocks of the firmware block list) and reports
+//placement evaluation speed and average lines per game.
+
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tetris_ai.h"
+
+namespace
+{
+constexpr uint8_t field_width = 10;
+constexpr uint8_t field_height = 16;
+constexpr uint32_t max_pieces_per_game = 1000000;
+
+using autoplayer = tetris_ai<field_width, field_height>;
+
+struct shape
+{
+	uint8_t width;
+	uint8_t height;
+	uint8_t rows[autoplayer::max_block_size];
+};
+
+const shape shapes[] = {
+	{ 4, 1, { 0b1111, 0, 0, 0 } }, //line 4x1
+	{ 3, 2, { 0b0011, 0b0110, 0, 0 } }, //"Z" left
+	{ 3, 2, { 0b0110, 0b0011, 0, 0 } }, //"Z" right
+	{ 3, 2, { 0b0010, 0b0111, 0, 0 } }, //"T"
+	{ 3, 2, { 0b0001, 0b0111, 0, 0 } }, //"L" left
+	{ 3, 2, { 0b0100, 0b0111, 0, 0 } }, //"L" right
+	{ 2, 2, { 0b0011, 0b0011, 0, 0 } } //cube
+};
+
+constexpr uint8_t shape_count = sizeof(shapes) / sizeof(shapes[0]);
+
+autoplayer::piece rotate(const autoplayer::piece& p)
+{
+	autoplayer::piece ret { p.height, p.width, { 0, 0, 0, 0 } };
+	for(uint8_t x = 0; x != p.width; ++x)
+	{
+		for(uint8_t y = 0; y != p.height; ++y)
+		{
+			if(p.rows[y] & (1 << x))
+				ret.rows[x] |= 1 << (p.height - 1 - y);
+		}
+	}
+	
+	return ret;
+}
+
+uint32_t xorshift(uint32_t& state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+} //namespace
+
+int main(int argc, char** argv)
+{
+	const uint32_t game_count = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 20;
+	uint32_t seed = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 1;
+	if(!game_count || !seed)
+	{
+		fprintf(stderr, "Usage: tetris_ai_benchmark [game count] [seed]\n");
+		return 1;
+	}
+	
+	autoplayer::piece rotations[shape_count][autoplayer::max_rotations];
+	for(uint8_t i = 0; i != shape_count; ++i)
+	{
+		rotations[i][0] = { shapes[i].width, shapes[i].height,
+			{ shapes[i].rows[0], shapes[i].rows[1], shapes[i].rows[2], shapes[i].rows[3] } };
+		for(uint8_t r = 1; r != autoplayer::max_rotations; ++r)
+			rotations[i][r] = rotate(rotations[i][r - 1]);
+	}
+	
+	autoplayer ai;
+	uint64_t total_lines = 0, total_pieces = 0, total_evaluations = 0;
+	const auto start = std::chrono::steady_clock::now();
+	for(uint32_t game = 0; game != game_count; ++game)
+	{
+		autoplayer::row_mask field[field_height] {};
+		uint64_t lines = 0;
+		uint32_t pieces = 0;
+		for(; pieces != max_pieces_per_game; ++pieces)
+		{
+			const uint8_t id = xorshift(seed) % shape_count;
+			ai.start(field, rotations[id], autoplayer::max_rotations);
+			//Same budget per call as on device
+			while(!ai.search(4))
+				total_evaluations += 4;
+			
+			if(!ai.is_found())
+				break;
+			
+			autoplayer::placement result;
+			autoplayer::drop(field, rotations[id][ai.get_rotation()], ai.get_x(), result);
+			lines += result.cleared_lines;
+		}
+		
+		printf("Game %u: %u pieces, %llu lines\n", game + 1, pieces,
+			static_cast<unsigned long long>(lines));
+		total_lines += lines;
+		total_pieces += pieces;
+	}
+	
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("Placements per second: %.0f\n", total_pieces / seconds);
+	printf("Evaluations per second: %.0f\n", total_evaluations / seconds);
+	printf("Average lines per game: %.1f\n", static_cast<double>(total_lines) / game_count);
+	return 0;
+}
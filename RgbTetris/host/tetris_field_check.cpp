@@ -0,0 +1,378 @@
+// Copyright 2016 Denis T (https://github.com/dragon-dreamer / dragondreamer [ @ ] live.com)
+// SPDX-License-Identifier: GPL-3.0
+
+//Host check of tetris field bitboard. Plays games with random blocks on the
+//firmware bitboard (tetris_field.h) and on the former pixel array field
+//(per-pixel intersection test and row removal by copying pixels down),
+//using the same random sequence. Blocks go to random columns in odd games
+//and to columns chosen by the autoplayer in even games (to clear many rows).
+//Checks that each collision test, spawn position, field and score are
+//the same, then reports time per intersection test of both fields.
+
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tetris_ai.h"
+#include "tetris_field.h"
+
+namespace
+{
+constexpr uint8_t field_width = 10;
+constexpr uint8_t field_height = 16;
+constexpr uint8_t combo_multiplier = 3;
+constexpr uint32_t max_placements_per_game = 2000;
+
+using bitboard = tetris_field<field_width, field_height>;
+using autoplayer = tetris_ai<field_width, field_height>;
+
+struct block
+{
+	static constexpr uint8_t max_rows = 4;
+	
+	uint8_t width;
+	uint8_t height;
+	uint8_t rows[max_rows];
+	
+	uint8_t row(uint8_t y) const
+	{
+		return rows[y];
+	}
+	
+	bool at(uint8_t x, uint8_t y) const
+	{
+		return (rows[y] >> x) & 1;
+	}
+};
+
+//All firmware blocks (see tetris.cpp)
+const block shapes[] = {
+	{ 4, 1, { 0b1111, 0, 0, 0 } }, //line 4x1
+	{ 3, 2, { 0b0011, 0b0110, 0, 0 } }, //"Z" left
+	{ 3, 2, { 0b0110, 0b0011, 0, 0 } }, //"Z" right
+	{ 3, 2, { 0b0010, 0b0111, 0, 0 } }, //"T"
+	{ 3, 2, { 0b0001, 0b0111, 0, 0 } }, //"L" left
+	{ 3, 2, { 0b0100, 0b0111, 0, 0 } }, //"L" right
+	{ 2, 2, { 0b0011, 0b0011, 0, 0 } }, //cube
+	{ 1, 1, { 0b0001, 0, 0, 0 } }, //"."
+	{ 3, 2, { 0b0111, 0b0111, 0, 0 } }, //block 3x2
+	{ 3, 3, { 0b0111, 0b0010, 0b0010, 0 } }, //Huge "T"
+	{ 3, 3, { 0b0111, 0b0111, 0b0111, 0 } }, //Huge cube
+	{ 3, 1, { 0b0111, 0, 0, 0 } }, //line 3x1
+	{ 3, 3, { 0b0011, 0b0010, 0b0110, 0 } }, //Huge "Z" left
+	{ 3, 3, { 0b0110, 0b0010, 0b0011, 0 } } //Huge "Z" right
+};
+
+constexpr uint8_t shape_count = sizeof(shapes) / sizeof(shapes[0]);
+
+///Clockwise rotation
+block rotate(const block& b)
+{
+	block ret { b.height, b.width, { 0, 0, 0, 0 } };
+	for(uint8_t i = 0; i != b.width; ++i)
+	{
+		for(uint8_t j = 0; j != b.height; ++j)
+		{
+			if(b.at(i, j))
+				ret.rows[i] |= 1 << (b.height - 1 - j);
+		}
+	}
+	
+	return ret;
+}
+
+///Former field: display pixels are checked one by one
+class pixel_field
+{
+public:
+	void clear()
+	{
+		memset(pixels_, 0, sizeof(pixels_));
+	}
+	
+	bool is_on(uint8_t x, uint8_t y) const
+	{
+		if(x >= field_width || y >= field_height)
+			return false;
+		
+		return pixels_[y][x];
+	}
+	
+	bool intersects(const block& b, uint8_t x, uint8_t y) const
+	{
+		for(uint8_t i = 0; i != b.height; ++i)
+		{
+			for(uint8_t j = 0; j != b.width; ++j)
+			{
+				if(b.at(j, i) && is_on(x + j, y - i))
+					return true;
+			}
+		}
+		
+		return false;
+	}
+	
+	void add_block(uint8_t x, uint8_t y, const block& b)
+	{
+		for(uint8_t i = 0; i != b.height; ++i)
+		{
+			for(uint8_t j = 0; j != b.width; ++j)
+			{
+				if(b.at(j, i))
+					set(x + j, y - i, true);
+			}
+		}
+	}
+	
+	///Returns number of removed rows
+	uint8_t remove_full_rows()
+	{
+		uint8_t full_rows[field_height];
+		uint8_t row_count = 0;
+		for(uint8_t y = 0; y != field_height; ++y)
+		{
+			bool is_full = true;
+			for(uint8_t x = 0; x != field_width; ++x)
+				is_full = is_full && pixels_[y][x];
+			
+			if(is_full)
+				full_rows[row_count++] = y;
+		}
+		
+		for(uint8_t i = 0; i != row_count; ++i)
+		{
+			for(uint8_t y = full_rows[i] + 1 - i; y <= field_height; ++y)
+			{
+				for(uint8_t x = 0; x != field_width; ++x)
+					set(x, y - 1, is_on(x, y));
+			}
+		}
+		
+		return row_count;
+	}
+	
+	bool equals(const bitboard& other) const
+	{
+		for(uint8_t y = 0; y != field_height; ++y)
+		{
+			for(uint8_t x = 0; x != field_width; ++x)
+			{
+				if(pixels_[y][x] != static_cast<bool>((other.get_rows()[y] >> x) & 1))
+					return false;
+			}
+		}
+		
+		return true;
+	}
+	
+private:
+	void set(uint8_t x, uint8_t y, bool value)
+	{
+		if(x < field_width && y < field_height)
+			pixels_[y][x] = value;
+	}
+	
+	bool pixels_[field_height][field_width];
+};
+
+block rotations[shape_count][autoplayer::max_rotations];
+
+pixel_field pixels;
+bitboard rows;
+autoplayer ai;
+
+uint64_t intersection_count = 0;
+uint32_t failure_count = 0;
+
+void fail(uint32_t game, const char* message)
+{
+	if(++failure_count <= 10)
+		fprintf(stderr, "Game %u: %s\n", game, message);
+}
+
+bool intersects(uint32_t game, const block& b, uint8_t x, uint8_t y)
+{
+	++intersection_count;
+	const bool result = rows.intersects(b, x, y);
+	if(result != pixels.intersects(b, x, y))
+		fail(game, "intersection test differs");
+	
+	return result;
+}
+
+///Same as in tetris.cpp
+bool get_new_block_pos(uint32_t game, const block& b, uint8_t& x)
+{
+	x = (field_width - b.width) / 2;
+	if(!intersects(game, b, x, field_height - 1))
+		return true;
+	
+	for(uint8_t new_x = 0; new_x != field_width - b.width + 1; ++new_x)
+	{
+		if(!intersects(game, b, new_x, field_height - 1))
+		{
+			x = new_x;
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+///Chooses rotation and column of block with the autoplayer
+void choose_placement(uint8_t shape, uint8_t& rotation, uint8_t& x)
+{
+	autoplayer::piece pieces[autoplayer::max_rotations];
+	for(uint8_t i = 0; i != autoplayer::max_rotations; ++i)
+	{
+		const block& b = rotations[shape][i];
+		pieces[i] = { b.width, b.height, { b.rows[0], b.rows[1], b.rows[2], b.rows[3] } };
+	}
+	
+	ai.start(rows.get_rows(), pieces, autoplayer::max_rotations);
+	while(!ai.search(0xff))
+	{
+	}
+	
+	if(ai.is_found())
+	{
+		rotation = ai.get_rotation();
+		x = ai.get_x();
+	}
+}
+
+///Plays game until there's no space for a new block. Each block is
+///moved to its column as far as it can go, then dropped.
+void play(uint32_t game, bool autoplay, uint32_t& placement_count, uint32_t& line_count, uint32_t& score)
+{
+	pixels.clear();
+	rows.clear();
+	score = 0;
+	for(uint32_t placement = 0; placement != max_placements_per_game; ++placement)
+	{
+		const uint8_t shape = rand() % shape_count;
+		uint8_t rotation = rand() % autoplayer::max_rotations;
+		uint8_t target_x = rand() % field_width;
+		if(autoplay)
+			choose_placement(shape, rotation, target_x);
+		
+		const block& b = rotations[shape][rotation];
+		uint8_t x;
+		if(!get_new_block_pos(game, b, x))
+			return;
+		
+		uint8_t y = field_height - 1;
+		if(target_x > field_width - b.width)
+			target_x = field_width - b.width;
+		
+		while(x != target_x)
+		{
+			const uint8_t new_x = x < target_x ? x + 1 : x - 1;
+			if(intersects(game, b, new_x, y))
+				break;
+			
+			x = new_x;
+		}
+		
+		while(y != b.height - 1 && !intersects(game, b, x, y - 1))
+			--y;
+		
+		pixels.add_block(x, y, b);
+		rows.add_block(x, y, b);
+		++placement_count;
+		
+		uint8_t full_row_count = 0;
+		for(uint8_t row_y = 0; row_y != field_height; ++row_y)
+			full_row_count += rows.is_full(row_y);
+		
+		const uint8_t remaining_rows = rows.remove_full_rows([](uint8_t, uint8_t) {});
+		if(pixels.remove_full_rows() != full_row_count || remaining_rows != field_height - full_row_count)
+			fail(game, "number of removed rows differs");
+		
+		if(!pixels.equals(rows))
+			fail(game, "field differs");
+		
+		line_count += full_row_count;
+		score += full_row_count;
+		if(full_row_count > 1) //Combo
+			score += full_row_count / combo_multiplier;
+	}
+}
+
+template<typename Field>
+double measure_ns_per_test(const Field& field, uint32_t repeat_count)
+{
+	uint32_t result = 0;
+	uint64_t test_count = 0;
+	const auto start = std::chrono::steady_clock::now();
+	for(uint32_t i = 0; i != repeat_count; ++i)
+	{
+		for(uint8_t shape = 0; shape != shape_count; ++shape)
+		{
+			const block& b = rotations[shape][i % autoplayer::max_rotations];
+			for(uint8_t x = 0; x != field_width - b.width + 1; ++x)
+			{
+				for(uint8_t y = b.height - 1; y != field_height; ++y, ++test_count)
+					result += field.intersects(b, x, y);
+			}
+		}
+	}
+	
+	const double ns = std::chrono::duration<double, std::nano>(
+		std::chrono::steady_clock::now() - start).count();
+	//Keeps tests from being optimized out
+	if(result == 0xffffffff)
+		puts("");
+	
+	return ns / test_count;
+}
+} //namespace
+
+int main(int argc, char** argv)
+{
+	const uint32_t game_count = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 1000;
+	const uint32_t seed = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 1;
+	if(!game_count)
+	{
+		fprintf(stderr, "Usage: tetris_field_check [game count] [seed]\n");
+		return 1;
+	}
+	
+	for(uint8_t i = 0; i != shape_count; ++i)
+	{
+		rotations[i][0] = shapes[i];
+		for(uint8_t rotation = 1; rotation != autoplayer::max_rotations; ++rotation)
+			rotations[i][rotation] = rotate(rotations[i][rotation - 1]);
+	}
+	
+	srand(seed);
+	uint32_t placement_count = 0, line_count = 0;
+	uint64_t total_score = 0;
+	for(uint32_t game = 0; game != game_count; ++game)
+	{
+		uint32_t score = 0;
+		play(game + 1, game % 2 != 0, placement_count, line_count, score);
+		total_score += score;
+	}
+	
+	printf("Games: %u, placements: %u, lines: %u, total score: %llu\n", game_count,
+		placement_count, line_count, static_cast<unsigned long long>(total_score));
+	printf("Intersection tests: %llu\n", static_cast<unsigned long long>(intersection_count));
+	
+	//Time collision tests on the field left after the last game
+	const uint32_t repeat_count = 20000;
+	const double pixel_time = measure_ns_per_test(pixels, repeat_count);
+	const double bitboard_time = measure_ns_per_test(rows, repeat_count);
+	printf("Intersection test: pixel field %.1f ns, bitboard %.1f ns\n", pixel_time, bitboard_time);
+	
+	if(failure_count)
+	{
+		printf("FAILED: %u differences\n", failure_count);
+		return 1;
+	}
+	
+	printf("Bitboard and pixel field are the same\n");
+	return 0;
+}